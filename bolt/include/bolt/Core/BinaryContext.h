@@ -1054,6 +1054,11 @@ public:
                                                                    EntryDesc);
   }
 
+  /// Return the function that \p BF was outlined from by Tapir lowering, or
+  /// nullptr if \p BF is not a Tapir helper or if its parent is not part of
+  /// the binary.
+  BinaryFunction *getTapirHelperParent(const BinaryFunction &BF);
+
   /// Associate the symbol \p Sym with the function \p BF for lookups with
   /// getFunctionForSymbol().
   void setSymbolToFunctionMap(const MCSymbol *Sym, BinaryFunction *BF) {
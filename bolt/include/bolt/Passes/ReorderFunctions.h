@@ -20,6 +20,12 @@ class Cluster;
 class ReorderFunctions : public BinaryFunctionPass {
   BinaryFunctionCallGraph Cg;
 
+  /// Move the hot helpers outlined by Tapir lowering in \p Order right after
+  /// the function they were outlined from, so that the fast path of a spawn
+  /// and the code around it share cache lines and pages.
+  std::vector<CallGraph::NodeId>
+  colocateTapirHelpers(const std::vector<CallGraph::NodeId> &Order);
+
   void reorder(std::vector<Cluster> &&Clusters,
                std::map<uint64_t, BinaryFunction> &BFs);
 
@@ -12,6 +12,7 @@
 #include "bolt/Passes/BinaryPasses.h"
 #include "llvm/Support/CommandLine.h"
 #include <atomic>
+#include <unordered_set>
 
 namespace llvm {
 namespace bolt {
@@ -31,6 +32,10 @@ private:
   /// Split function body into fragments.
   void splitFunction(BinaryFunction &Function);
 
+  /// Tapir helpers and the functions they were outlined from, which get all
+  /// their cold blocks outlined with -split-tapir-helpers.
+  std::unordered_set<const BinaryFunction *> TapirFunctions;
+
   std::atomic<uint64_t> SplitBytesHot{0ull};
   std::atomic<uint64_t> SplitBytesCold{0ull};
 
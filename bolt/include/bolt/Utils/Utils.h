@@ -41,6 +41,11 @@ std::string getEscapedName(const StringRef &Name);
 /// Return the unescaped name
 std::string getUnescapedName(const StringRef &Name);
 
+/// If \p Name is the name of a function outlined by Tapir lowering, i.e. a
+/// spawn helper or a parallel-loop helper, return the name of the function it
+/// was outlined from. Otherwise return an empty string.
+StringRef getTapirHelperParentName(StringRef Name);
+
 // Determines which register a given DWARF expression is being assigned to.
 // If the expression is defining the CFA, return NoneType.
 Optional<uint8_t> readDWARFExpressionTargetReg(StringRef ExprBytes);
@@ -1905,6 +1905,25 @@ BinaryFunction *BinaryContext::getFunctionForSymbol(const MCSymbol *Symbol,
   return BF;
 }
 
+BinaryFunction *BinaryContext::getTapirHelperParent(const BinaryFunction &BF) {
+  for (StringRef Name : BF.getNames()) {
+    // Names of local functions carry a "/<file>/<id>" suffix, which a local
+    // parent from the same file shares.
+    const size_t SlashPos = Name.find('/');
+    StringRef ParentName = getTapirHelperParentName(Name.take_front(SlashPos));
+    if (ParentName.empty())
+      continue;
+
+    for (const std::string &Candidate :
+         {(ParentName + Name.substr(SlashPos)).str(), ParentName.str()})
+      if (const BinaryData *BD = getBinaryDataByName(Candidate))
+        if (BinaryFunction *Parent = getFunctionForSymbol(BD->getSymbol()))
+          if (Parent != &BF)
+            return Parent;
+  }
+  return nullptr;
+}
+
 void BinaryContext::exitWithBugReport(StringRef Message,
                                       const BinaryFunction &Function) const {
   errs() << "=======================================\n";
@@ -15,8 +15,9 @@
 #include "bolt/Core/BinaryFunction.h"
 #include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
-#include <mutex>
-#include <shared_mutex>
+#include <algorithm>
+#include <atomic>
+#include <tuple>
 
 #define DEBUG_TYPE "par-utils"
 
@@ -76,27 +77,87 @@ unsigned computeCostFor(const BinaryFunction &BF,
   }
 }
 
-inline unsigned estimateTotalCost(const BinaryContext &BC,
-                                  const PredicateTy &SkipPredicate,
-                                  SchedulingPolicy &SchedPolicy) {
-  if (SchedPolicy == SchedulingPolicy::SP_TRIVIAL)
-    return BC.getBinaryFunctions().size();
+/// Functions to process, most expensive first, along with the running sum of
+/// their estimated costs.
+struct WorkList {
+  std::vector<BinaryFunction *> Functions;
+  /// CostPrefix[I] is the total cost of Functions[0, I).
+  std::vector<uint64_t> CostPrefix{0};
+
+  WorkList(BinaryContext &BC, const PredicateTy &SkipPredicate,
+           SchedulingPolicy SchedPolicy) {
+    std::vector<std::pair<BinaryFunction *, uint64_t>> Costs;
+    for (auto &BFI : BC.getBinaryFunctions()) {
+      BinaryFunction &BF = BFI.second;
+      if (SkipPredicate && SkipPredicate(BF))
+        continue;
+      // Every function takes some time, even if it is estimated to be free.
+      const uint64_t Cost =
+          std::max(computeCostFor(BF, PredicateTy(), SchedPolicy), 1u);
+      Costs.emplace_back(&BF, Cost);
+    }
 
-  unsigned TotalCost = 0;
-  for (auto &BFI : BC.getBinaryFunctions()) {
-    const BinaryFunction &BF = BFI.second;
-    TotalCost += computeCostFor(BF, SkipPredicate, SchedPolicy);
+    // Start the largest functions first, so that they do not end up running
+    // alone once everything else is done. The sort is stable to keep the
+    // order deterministic.
+    std::stable_sort(Costs.begin(), Costs.end(),
+                     [](const std::pair<BinaryFunction *, uint64_t> &A,
+                        const std::pair<BinaryFunction *, uint64_t> &B) {
+                       return A.second > B.second;
+                     });
+
+    Functions.reserve(Costs.size());
+    CostPrefix.reserve(Costs.size() + 1);
+    for (const std::pair<BinaryFunction *, uint64_t> &FC : Costs) {
+      Functions.push_back(FC.first);
+      CostPrefix.push_back(CostPrefix.back() + FC.second);
+    }
   }
 
-  // Switch to trivial scheduling if total estimated work is zero
-  if (TotalCost == 0) {
-    outs() << "BOLT-WARNING: Running parallel work of 0 estimated cost, will "
-              "switch to  trivial scheduling.\n";
-
-    SchedPolicy = SP_TRIVIAL;
-    TotalCost = BC.getBinaryFunctions().size();
+  size_t size() const { return Functions.size(); }
+  uint64_t totalCost() const { return CostPrefix.back(); }
+};
+
+/// Hands out chunks of a WorkList to the worker threads on demand. A chunk is
+/// a single function, or a run of cheaper functions of about ChunkCost total
+/// cost. Idle workers keep taking chunks until the list is exhausted, so a
+/// skewed cost estimate delays at most one chunk instead of a whole bucket.
+class WorkQueue {
+  const WorkList &Work;
+  const uint64_t ChunkCost;
+  std::atomic<size_t> Next{0};
+
+public:
+  WorkQueue(const WorkList &Work, uint64_t ChunkCost)
+      : Work(Work), ChunkCost(ChunkCost) {}
+
+  /// Claim the functions [Begin, End) of the work list. Return false if there
+  /// is no work left.
+  bool next(size_t &Begin, size_t &End) {
+    size_t Current = Next.load(std::memory_order_relaxed);
+    do {
+      if (Current >= Work.size())
+        return false;
+      const uint64_t Limit = Work.CostPrefix[Current] + ChunkCost;
+      auto It = std::upper_bound(Work.CostPrefix.begin() + Current + 1,
+                                 Work.CostPrefix.end(), Limit);
+      End = std::max<size_t>(It - Work.CostPrefix.begin() - 1, Current + 1);
+    } while (!Next.compare_exchange_weak(Current, End,
+                                         std::memory_order_relaxed));
+    Begin = Current;
+    return true;
   }
-  return TotalCost;
+};
+
+/// Return the number of worker tasks and the cost of the chunks to split
+/// \p Work into, aiming at \p TasksPerThread chunks per thread.
+std::pair<unsigned, uint64_t> getWorkSplit(const WorkList &Work,
+                                           unsigned TasksPerThread) {
+  const unsigned NumWorkers =
+      std::min<size_t>(std::max(opts::ThreadCount.getValue(), 1u), Work.size());
+  const uint64_t ChunksCount =
+      std::max<uint64_t>(uint64_t(TasksPerThread) * NumWorkers, 1);
+  return {NumWorkers, std::max<uint64_t>(Work.totalCost() / ChunksCount, 1)};
 }
 
 } // namespace
@@ -137,29 +198,28 @@ void runOnEachFunction(BinaryContext &BC, SchedulingPolicy SchedPolicy,
     return;
   }
 
-  // Estimate the overall runtime cost using the scheduling policy
-  const unsigned TotalCost = estimateTotalCost(BC, SkipPredicate, SchedPolicy);
-  const unsigned BlocksCount = TasksPerThread * opts::ThreadCount;
-  const unsigned BlockCost =
-      TotalCost > BlocksCount ? TotalCost / BlocksCount : 1;
+  const WorkList Work(BC, SkipPredicate, SchedPolicy);
+  if (!Work.size())
+    return;
+
+  unsigned NumWorkers;
+  uint64_t ChunkCost;
+  std::tie(NumWorkers, ChunkCost) = getWorkSplit(Work, TasksPerThread);
+  WorkQueue Queue(Work, ChunkCost);
+
+  auto runWorker = [&]() {
+    Timer T(LogName, LogName);
+    LLVM_DEBUG(T.startTimer());
+    size_t Begin, End;
+    while (Queue.next(Begin, End))
+      for (size_t I = Begin; I != End; ++I)
+        WorkFunction(*Work.Functions[I]);
+    LLVM_DEBUG(T.stopTimer());
+  };
 
-  // Divide work into blocks of equal cost
   ThreadPool &Pool = getThreadPool();
-  auto BlockBegin = BC.getBinaryFunctions().begin();
-  unsigned CurrentCost = 0;
-
-  for (auto It = BC.getBinaryFunctions().begin();
-       It != BC.getBinaryFunctions().end(); ++It) {
-    BinaryFunction &BF = It->second;
-    CurrentCost += computeCostFor(BF, SkipPredicate, SchedPolicy);
-
-    if (CurrentCost >= BlockCost) {
-      Pool.async(runBlock, BlockBegin, std::next(It));
-      BlockBegin = std::next(It);
-      CurrentCost = 0;
-    }
-  }
-  Pool.async(runBlock, BlockBegin, BC.getBinaryFunctions().end());
+  for (unsigned I = 0; I < NumWorkers; ++I)
+    Pool.async(runWorker);
   Pool.wait();
 }
 
@@ -170,13 +230,11 @@ void runOnEachFunctionWithUniqueAllocId(
   if (BC.getBinaryFunctions().size() == 0)
     return;
 
-  std::shared_timed_mutex MainLock;
   auto runBlock = [&](std::map<uint64_t, BinaryFunction>::iterator BlockBegin,
                       std::map<uint64_t, BinaryFunction>::iterator BlockEnd,
                       MCPlusBuilder::AllocatorIdTy AllocId) {
     Timer T(LogName, LogName);
     LLVM_DEBUG(T.startTimer());
-    std::shared_lock<std::shared_timed_mutex> Lock(MainLock);
     for (auto It = BlockBegin; It != BlockEnd; ++It) {
       BinaryFunction &BF = It->second;
       if (SkipPredicate && SkipPredicate(BF))
@@ -191,48 +249,41 @@ void runOnEachFunctionWithUniqueAllocId(
     runBlock(BC.getBinaryFunctions().begin(), BC.getBinaryFunctions().end(), 0);
     return;
   }
-  // This lock is used to postpone task execution
-  std::unique_lock<std::shared_timed_mutex> Lock(MainLock);
 
-  // Estimate the overall runtime cost using the scheduling policy
-  const unsigned TotalCost = estimateTotalCost(BC, SkipPredicate, SchedPolicy);
-  const unsigned BlocksCount = TasksPerThread * opts::ThreadCount;
-  const unsigned BlockCost =
-      TotalCost > BlocksCount ? TotalCost / BlocksCount : 1;
+  const WorkList Work(BC, SkipPredicate, SchedPolicy);
+  if (!Work.size())
+    return;
 
-  // Divide work into blocks of equal cost
-  ThreadPool &Pool = getThreadPool();
-  auto BlockBegin = BC.getBinaryFunctions().begin();
-  unsigned CurrentCost = 0;
-  unsigned AllocId = 1;
-  for (auto It = BC.getBinaryFunctions().begin();
-       It != BC.getBinaryFunctions().end(); ++It) {
-    BinaryFunction &BF = It->second;
-    CurrentCost += computeCostFor(BF, SkipPredicate, SchedPolicy);
-
-    if (CurrentCost >= BlockCost) {
-      if (!BC.MIB->checkAllocatorExists(AllocId)) {
-        MCPlusBuilder::AllocatorIdTy Id =
-            BC.MIB->initializeNewAnnotationAllocator();
-        (void)Id;
-        assert(AllocId == Id && "unexpected allocator id created");
-      }
-      Pool.async(runBlock, BlockBegin, std::next(It), AllocId);
-      AllocId++;
-      BlockBegin = std::next(It);
-      CurrentCost = 0;
+  unsigned NumWorkers;
+  uint64_t ChunkCost;
+  std::tie(NumWorkers, ChunkCost) = getWorkSplit(Work, TasksPerThread);
+  WorkQueue Queue(Work, ChunkCost);
+
+  // Each worker uses its own annotation allocator. They are all created
+  // before any work starts, since creating one is not thread-safe.
+  for (MCPlusBuilder::AllocatorIdTy AllocId = 1; AllocId <= NumWorkers;
+       ++AllocId) {
+    if (!BC.MIB->checkAllocatorExists(AllocId)) {
+      MCPlusBuilder::AllocatorIdTy Id =
+          BC.MIB->initializeNewAnnotationAllocator();
+      (void)Id;
+      assert(AllocId == Id && "unexpected allocator id created");
     }
   }
 
-  if (!BC.MIB->checkAllocatorExists(AllocId)) {
-    MCPlusBuilder::AllocatorIdTy Id =
-        BC.MIB->initializeNewAnnotationAllocator();
-    (void)Id;
-    assert(AllocId == Id && "unexpected allocator id created");
-  }
+  auto runWorker = [&](MCPlusBuilder::AllocatorIdTy AllocId) {
+    Timer T(LogName, LogName);
+    LLVM_DEBUG(T.startTimer());
+    size_t Begin, End;
+    while (Queue.next(Begin, End))
+      for (size_t I = Begin; I != End; ++I)
+        WorkFunction(*Work.Functions[I], AllocId);
+    LLVM_DEBUG(T.stopTimer());
+  };
 
-  Pool.async(runBlock, BlockBegin, BC.getBinaryFunctions().end(), AllocId);
-  Lock.unlock();
+  ThreadPool &Pool = getThreadPool();
+  for (unsigned I = 0; I < NumWorkers; ++I)
+    Pool.async(runWorker, I + 1);
   Pool.wait();
 }
 
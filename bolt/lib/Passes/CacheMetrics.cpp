@@ -13,6 +13,7 @@
 
 #include "bolt/Passes/CacheMetrics.h"
 #include "bolt/Core/BinaryBasicBlock.h"
+#include "bolt/Core/BinaryContext.h"
 #include "bolt/Core/BinaryFunction.h"
 #include "llvm/Support/CommandLine.h"
 #include <unordered_map>
@@ -214,6 +215,49 @@ double expectedCacheHitRatio(
   return 100.0 * (1.0 - Misses / TotalSamples);
 }
 
+/// Print how the hot functions outlined by Tapir lowering are placed relative
+/// to the functions they were outlined from. A spawn helper that is on another
+/// i-TLB page than its parent costs a page walk on every spawn.
+void printTapirHelperMetrics(
+    const std::vector<BinaryFunction *> &BinaryFunctions,
+    const std::unordered_map<BinaryBasicBlock *, uint64_t> &BBAddr) {
+  const uint64_t PageSize = opts::ITLBPageSize;
+  size_t NumHelpers = 0;
+  size_t NumSamePage = 0;
+  uint64_t TotalCount = 0;
+  uint64_t SamePageCount = 0;
+  for (BinaryFunction *BF : BinaryFunctions) {
+    if (!BF->hasProfile() || BF->layout_empty())
+      continue;
+    BinaryFunction *Parent = BF->getBinaryContext().getTapirHelperParent(*BF);
+    if (!Parent || Parent->layout_empty())
+      continue;
+    auto ParentAddr = BBAddr.find(Parent->layout_front());
+    if (ParentAddr == BBAddr.end())
+      continue;
+
+    const uint64_t Count = BF->getKnownExecutionCount();
+    ++NumHelpers;
+    TotalCount += Count;
+    if (BBAddr.at(BF->layout_front()) / PageSize ==
+        ParentAddr->second / PageSize) {
+      ++NumSamePage;
+      SamePageCount += Count;
+    }
+  }
+
+  if (!NumHelpers)
+    return;
+
+  outs() << format("  There are %zu Tapir helpers with profile;", NumHelpers)
+         << format(" %zu (%.2lf%%) share an i-TLB page with their parent\n",
+                   NumSamePage, 100.0 * NumSamePage / NumHelpers);
+  if (TotalCount)
+    outs() << format("  Tapir helper executions on the i-TLB page of their "
+                     "parent: %.2lf%%\n",
+                     100.0 * SamePageCount / TotalCount);
+}
+
 } // namespace
 
 double CacheMetrics::extTSPScore(uint64_t SrcAddr, uint64_t SrcSize,
@@ -308,4 +352,6 @@ void CacheMetrics::printAll(const std::vector<BinaryFunction *> &BFs) {
 
   outs() << "  ExtTSP score: "
          << format("%.0lf\n", calcExtTSPScore(BFs, BBAddr, BBSize));
+
+  printTapirHelperMetrics(BFs, BBAddr);
 }
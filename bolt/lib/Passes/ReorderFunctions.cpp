@@ -14,6 +14,7 @@
 #include "bolt/Passes/HFSort.h"
 #include "llvm/Support/CommandLine.h"
 #include <fstream>
+#include <unordered_map>
 
 #define DEBUG_TYPE "hfsort"
 
@@ -55,6 +56,15 @@ ReorderFunctions("reorder-functions",
   cl::ZeroOrMore,
   cl::cat(BoltOptCategory));
 
+static cl::opt<bool>
+ColocateTapirHelpers("colocate-tapir-helpers",
+  cl::desc("place hot functions outlined by Tapir lowering (spawn helpers and "
+           "parallel-loop helpers) right after the function they were "
+           "outlined from"),
+  cl::init(false),
+  cl::ZeroOrMore,
+  cl::cat(BoltOptCategory));
+
 static cl::opt<bool>
 ReorderFunctionsUseHotSize("reorder-functions-use-hot-size",
   cl::desc("use a function's hot size when doing clustering"),
@@ -119,19 +129,65 @@ using NodeId = CallGraph::NodeId;
 using Arc = CallGraph::Arc;
 using Node = CallGraph::Node;
 
+std::vector<NodeId>
+ReorderFunctions::colocateTapirHelpers(const std::vector<NodeId> &Order) {
+  std::vector<bool> InOrder(Cg.numNodes());
+  for (const NodeId FuncId : Order)
+    InOrder[FuncId] = true;
+
+  // Attach each helper to the function it was outlined from, keeping the
+  // relative order of the helpers of a function.
+  std::unordered_map<NodeId, std::vector<NodeId>> Helpers;
+  std::vector<bool> IsHelper(Cg.numNodes());
+  for (const NodeId FuncId : Order) {
+    BinaryFunction *BF = Cg.nodeIdToFunc(FuncId);
+    BinaryFunction *Parent = BF->getBinaryContext().getTapirHelperParent(*BF);
+    if (!Parent)
+      continue;
+    const NodeId ParentId = Cg.maybeGetNodeId(Parent);
+    if (ParentId == CallGraph::InvalidId || !InOrder[ParentId])
+      continue;
+    Helpers[ParentId].push_back(FuncId);
+    IsHelper[FuncId] = true;
+  }
+
+  // Helpers of helpers follow their own parent. The name of a parent is
+  // always a strict prefix of the names of its helpers, so this terminates.
+  std::vector<NodeId> NewOrder;
+  NewOrder.reserve(Order.size());
+  std::function<void(NodeId)> place = [&](NodeId FuncId) {
+    NewOrder.push_back(FuncId);
+    auto It = Helpers.find(FuncId);
+    if (It != Helpers.end())
+      for (const NodeId HelperId : It->second)
+        place(HelperId);
+  };
+  for (const NodeId FuncId : Order)
+    if (!IsHelper[FuncId])
+      place(FuncId);
+
+  assert(NewOrder.size() == Order.size() && "lost functions while colocating");
+  return NewOrder;
+}
+
 void ReorderFunctions::reorder(std::vector<Cluster> &&Clusters,
                                std::map<uint64_t, BinaryFunction> &BFs) {
   std::vector<uint64_t> FuncAddr(Cg.numNodes()); // Just for computing stats
   uint64_t TotalSize = 0;
   uint32_t Index = 0;
 
+  std::vector<NodeId> Order;
+  for (const Cluster &Cluster : Clusters)
+    Order.insert(Order.end(), Cluster.targets().begin(),
+                 Cluster.targets().end());
+  if (opts::ColocateTapirHelpers)
+    Order = colocateTapirHelpers(Order);
+
   // Set order of hot functions based on clusters.
-  for (const Cluster &Cluster : Clusters) {
-    for (const NodeId FuncId : Cluster.targets()) {
-      Cg.nodeIdToFunc(FuncId)->setIndex(Index++);
-      FuncAddr[FuncId] = TotalSize;
-      TotalSize += Cg.size(FuncId);
-    }
+  for (const NodeId FuncId : Order) {
+    Cg.nodeIdToFunc(FuncId)->setIndex(Index++);
+    FuncAddr[FuncId] = TotalSize;
+    TotalSize += Cg.size(FuncId);
   }
 
   if (opts::ReorderFunctions == RT_NONE)
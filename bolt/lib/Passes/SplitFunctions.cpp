@@ -35,6 +35,14 @@ AggressiveSplitting("split-all-cold",
   cl::ZeroOrMore,
   cl::cat(BoltOptCategory));
 
+static cl::opt<bool>
+SplitTapirHelpers("split-tapir-helpers",
+  cl::desc("outline as many cold basic blocks as possible from functions "
+           "outlined by Tapir lowering and from the functions they were "
+           "outlined from, e.g. steal and exception paths"),
+  cl::ZeroOrMore,
+  cl::cat(BoltOptCategory));
+
 static cl::opt<unsigned>
 SplitAlignThreshold("split-align-threshold",
   cl::desc("when deciding to split a function, apply this alignment "
@@ -96,6 +104,16 @@ void SplitFunctions::runOnFunctions(BinaryContext &BC) {
   if (opts::SplitFunctions == SplitFunctions::ST_NONE)
     return;
 
+  if (opts::SplitTapirHelpers) {
+    for (auto &BFI : BC.getBinaryFunctions()) {
+      BinaryFunction &BF = BFI.second;
+      if (BinaryFunction *Parent = BC.getTapirHelperParent(BF)) {
+        TapirFunctions.insert(&BF);
+        TapirFunctions.insert(Parent);
+      }
+    }
+  }
+
   ParallelUtilities::WorkFuncTy WorkFun = [&](BinaryFunction &BF) {
     splitFunction(BF);
   };
@@ -190,7 +208,7 @@ void SplitFunctions::splitFunction(BinaryFunction &BF) {
     }
   }
 
-  if (opts::AggressiveSplitting) {
+  if (opts::AggressiveSplitting || TapirFunctions.count(&BF)) {
     // All blocks with 0 count that we can move go to the end of the function.
     // Even if they were natural to cluster formation and were seen in-between
     // hot basic blocks.
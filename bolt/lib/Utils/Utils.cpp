@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "bolt/Utils/Utils.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/BinaryFormat/Dwarf.h"
 #include "llvm/MC/MCDwarf.h"
 #include "llvm/Support/LEB128.h"
@@ -66,6 +67,27 @@ std::string getUnescapedName(const StringRef &Name) {
   return Output;
 }
 
+StringRef getTapirHelperParentName(StringRef Name) {
+  const size_t Pos = Name.rfind(".outline_");
+  if (Pos == StringRef::npos)
+    return StringRef();
+
+  // Spawn helpers end in .otd<task depth>, parallel-loop helpers in
+  // .ls<loop depth>, and helpers created for the Cilk Plus ABI in .shelper.
+  StringRef Suffix = Name.drop_front(Pos);
+  for (StringRef Marker : {".otd", ".ls"}) {
+    const size_t MarkerPos = Suffix.rfind(Marker);
+    if (MarkerPos != StringRef::npos &&
+        MarkerPos + Marker.size() < Suffix.size() &&
+        isDigit(Suffix[MarkerPos + Marker.size()]))
+      return Name.take_front(Pos);
+  }
+  if (Suffix.contains(".shelper"))
+    return Name.take_front(Pos);
+
+  return StringRef();
+}
+
 Optional<uint8_t> readDWARFExpressionTargetReg(StringRef ExprBytes) {
   uint8_t Opcode = ExprBytes[0];
   if (Opcode == dwarf::DW_CFA_def_cfa_expression)
@@ -0,0 +1,143 @@
+#include "bolt/Core/BinaryContext.h"
+#include "bolt/Core/BinaryFunction.h"
+#include "bolt/Utils/Utils.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Support/TargetSelect.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::object;
+using namespace llvm::ELF;
+using namespace bolt;
+
+namespace {
+struct BinaryContextTester : public testing::TestWithParam<Triple::ArchType> {
+  void SetUp() override {
+    initalizeLLVM();
+    prepareElf();
+    initializeBolt();
+  }
+
+protected:
+  void initalizeLLVM() {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmParsers();
+    llvm::InitializeAllDisassemblers();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllAsmPrinters();
+  }
+
+  void prepareElf() {
+    memcpy(ElfBuf, "\177ELF", 4);
+    ELF64LE::Ehdr *EHdr = reinterpret_cast<typename ELF64LE::Ehdr *>(ElfBuf);
+    EHdr->e_ident[llvm::ELF::EI_CLASS] = llvm::ELF::ELFCLASS64;
+    EHdr->e_ident[llvm::ELF::EI_DATA] = llvm::ELF::ELFDATA2LSB;
+    EHdr->e_machine = GetParam() == Triple::aarch64 ? EM_AARCH64 : EM_X86_64;
+    MemoryBufferRef Source(StringRef(ElfBuf, sizeof(ElfBuf)), "ELF");
+    ObjFile = cantFail(ObjectFile::createObjectFile(Source));
+  }
+
+  void initializeBolt() {
+    BC = BinaryContext::createBinaryContext(
+        ObjFile.get(), true, DWARFContext::create(*ObjFile.get()));
+    ASSERT_FALSE(!BC);
+    Text = &BC->registerOrUpdateSection(".text", ELF::SHT_PROGBITS,
+                                        ELF::SHF_ALLOC | ELF::SHF_EXECINSTR,
+                                        nullptr, 0, 16);
+  }
+
+  BinaryFunction *createFunction(StringRef Name) {
+    NextAddress += 0x100;
+    return BC->createBinaryFunction(Name.str(), *Text, NextAddress, 0x10);
+  }
+
+  char ElfBuf[sizeof(typename ELF64LE::Ehdr)] = {};
+  std::unique_ptr<ObjectFile> ObjFile;
+  std::unique_ptr<BinaryContext> BC;
+  BinarySection *Text = nullptr;
+  uint64_t NextAddress = 0;
+};
+} // namespace
+
+#ifdef AARCH64_AVAILABLE
+
+INSTANTIATE_TEST_SUITE_P(AArch64, BinaryContextTester,
+                         ::testing::Values(Triple::aarch64));
+
+#endif
+
+#ifdef X86_AVAILABLE
+
+INSTANTIATE_TEST_SUITE_P(X86, BinaryContextTester,
+                         ::testing::Values(Triple::x86_64));
+
+#endif
+
+TEST(TapirHelperTest, ParentName) {
+  // Spawn helpers.
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_det.achd.otd1"), "foo");
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_det.achd.otd12"), "foo");
+  // Parallel-loop helpers.
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_pfor.body.ls1"), "foo");
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_pfor.body.ls2.otd1"),
+            "foo");
+  // Cilk Plus helpers.
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_det.achd.shelper"), "foo");
+  // A helper outlined from another helper has that helper as its parent.
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_a.otd1.outline_b.otd2"),
+            "foo.outline_a.otd1");
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_a.ls1.outline_b.otd1"),
+            "foo.outline_a.ls1");
+
+  // Not Tapir helpers.
+  EXPECT_EQ(getTapirHelperParentName("foo"), "");
+  EXPECT_EQ(getTapirHelperParentName("foo.otd1"), "");
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_bar"), "");
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_bar.otd"), "");
+  EXPECT_EQ(getTapirHelperParentName("foo.outline_bar.lsx"), "");
+  EXPECT_EQ(getTapirHelperParentName(".outline_bar.otd1"), "");
+}
+
+TEST_P(BinaryContextTester, TapirHelperParent) {
+  BinaryFunction *Foo = createFunction("foo");
+  BinaryFunction *Spawn = createFunction("foo.outline_a.otd1");
+  BinaryFunction *Loop = createFunction("foo.outline_l.ls1");
+  BinaryFunction *Nested = createFunction("foo.outline_a.otd1.outline_b.otd2");
+
+  EXPECT_EQ(BC->getTapirHelperParent(*Foo), nullptr);
+  EXPECT_EQ(BC->getTapirHelperParent(*Spawn), Foo);
+  EXPECT_EQ(BC->getTapirHelperParent(*Loop), Foo);
+  EXPECT_EQ(BC->getTapirHelperParent(*Nested), Spawn);
+
+  // A helper whose parent is not in the binary has no parent.
+  BinaryFunction *Orphan = createFunction("gone.outline_a.otd1");
+  EXPECT_EQ(BC->getTapirHelperParent(*Orphan), nullptr);
+}
+
+TEST_P(BinaryContextTester, TapirHelperParentOfLocalFunction) {
+  // Local functions of the same name in different files.
+  BinaryFunction *Bar = createFunction("bar/a.c/1");
+  BinaryFunction *OtherBar = createFunction("bar/b.c/1");
+  BinaryFunction *Helper = createFunction("bar.outline_a.otd1/a.c/1");
+  BinaryFunction *OtherHelper = createFunction("bar.outline_a.otd1/b.c/1");
+  BinaryFunction *NestedHelper =
+      createFunction("bar.outline_a.otd1.outline_b.ls1/b.c/1");
+
+  EXPECT_EQ(BC->getTapirHelperParent(*Helper), Bar);
+  EXPECT_EQ(BC->getTapirHelperParent(*OtherHelper), OtherBar);
+  EXPECT_EQ(BC->getTapirHelperParent(*NestedHelper), OtherHelper);
+
+  // A local helper of a global function.
+  BinaryFunction *Baz = createFunction("baz");
+  BinaryFunction *LocalHelper = createFunction("baz.outline_a.otd1/c.c/1");
+  EXPECT_EQ(BC->getTapirHelperParent(*LocalHelper), Baz);
+
+  // The parent is also found through another symbol of the helper.
+  BinaryFunction *Aliased = createFunction("alias");
+  Aliased->getSymbols().push_back(BC->registerNameAtAddress(
+      "baz.outline_b.shelper", Aliased->getAddress(), 0x10, 0));
+  EXPECT_EQ(BC->getTapirHelperParent(*Aliased), Baz);
+}
@@ -0,0 +1,169 @@
+#include "bolt/Core/BinaryContext.h"
+#include "bolt/Core/BinaryFunction.h"
+#include "bolt/Core/ParallelUtilities.h"
+#include "bolt/Rewrite/RewriteInstance.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Support/TargetSelect.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <mutex>
+
+using namespace llvm;
+using namespace llvm::object;
+using namespace llvm::ELF;
+using namespace bolt;
+
+namespace {
+constexpr unsigned NumFunctions = 1000;
+constexpr unsigned NumThreads = 4;
+
+struct ParallelUtilitiesTester
+    : public testing::TestWithParam<Triple::ArchType> {
+  void SetUp() override {
+    initalizeLLVM();
+    prepareElf();
+    initializeBolt();
+    createFunctions();
+  }
+
+protected:
+  void initalizeLLVM() {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmParsers();
+    llvm::InitializeAllDisassemblers();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllAsmPrinters();
+  }
+
+  void prepareElf() {
+    memcpy(ElfBuf, "\177ELF", 4);
+    ELF64LE::Ehdr *EHdr = reinterpret_cast<typename ELF64LE::Ehdr *>(ElfBuf);
+    EHdr->e_ident[llvm::ELF::EI_CLASS] = llvm::ELF::ELFCLASS64;
+    EHdr->e_ident[llvm::ELF::EI_DATA] = llvm::ELF::ELFDATA2LSB;
+    EHdr->e_machine = GetParam() == Triple::aarch64 ? EM_AARCH64 : EM_X86_64;
+    MemoryBufferRef Source(StringRef(ElfBuf, sizeof(ElfBuf)), "ELF");
+    ObjFile = cantFail(ObjectFile::createObjectFile(Source));
+  }
+
+  void initializeBolt() {
+    BC = BinaryContext::createBinaryContext(
+        ObjFile.get(), true, DWARFContext::create(*ObjFile.get()));
+    ASSERT_FALSE(!BC);
+    BC->initializeTarget(std::unique_ptr<MCPlusBuilder>(createMCPlusBuilder(
+        GetParam(), BC->MIA.get(), BC->MII.get(), BC->MRI.get())));
+    opts::ThreadCount = NumThreads;
+  }
+
+  /// Create functions of very different sizes, so that a few large ones get a
+  /// chunk of their own and runs of small ones share chunks.
+  void createFunctions() {
+    BinarySection &Text = BC->registerOrUpdateSection(
+        ".text", ELF::SHT_PROGBITS, ELF::SHF_ALLOC | ELF::SHF_EXECINSTR,
+        nullptr, 0, 16);
+    uint64_t Address = 0x1000;
+    for (unsigned I = 0; I < NumFunctions; ++I) {
+      const uint64_t Size = I % 100 == 0 ? 0x1000 : 1 + I % 7;
+      BC->createBinaryFunction("f" + std::to_string(I), Text, Address, Size);
+      Address += Size;
+    }
+  }
+
+  /// Skip every third function.
+  static bool skip(const BinaryFunction &BF) {
+    return BF.getAddress() % 3 == 0;
+  }
+
+  /// Check that every function that is not skipped was visited exactly once.
+  void checkVisits(const DenseMap<const BinaryFunction *, unsigned> &Visits,
+                   bool Skipped) {
+    for (auto &BFI : BC->getBinaryFunctions()) {
+      const BinaryFunction &BF = BFI.second;
+      const unsigned Expected = Skipped && skip(BF) ? 0 : 1;
+      EXPECT_EQ(Visits.lookup(&BF), Expected) << BF.getPrintName();
+    }
+  }
+
+  char ElfBuf[sizeof(typename ELF64LE::Ehdr)] = {};
+  std::unique_ptr<ObjectFile> ObjFile;
+  std::unique_ptr<BinaryContext> BC;
+};
+} // namespace
+
+#ifdef AARCH64_AVAILABLE
+
+INSTANTIATE_TEST_SUITE_P(AArch64, ParallelUtilitiesTester,
+                         ::testing::Values(Triple::aarch64));
+
+#endif
+
+#ifdef X86_AVAILABLE
+
+INSTANTIATE_TEST_SUITE_P(X86, ParallelUtilitiesTester,
+                         ::testing::Values(Triple::x86_64));
+
+#endif
+
+TEST_P(ParallelUtilitiesTester, EachFunctionOnce) {
+  using namespace ParallelUtilities;
+  for (SchedulingPolicy Policy :
+       {SP_TRIVIAL, SP_CONSTANT, SP_INST_LINEAR, SP_INST_QUADRATIC}) {
+    for (unsigned TasksPerThread : {1u, 20u, NumFunctions * 2}) {
+      for (bool Skipped : {false, true}) {
+        std::mutex Mutex;
+        DenseMap<const BinaryFunction *, unsigned> Visits;
+        runOnEachFunction(
+            *BC, Policy,
+            [&](BinaryFunction &BF) {
+              std::lock_guard<std::mutex> Lock(Mutex);
+              ++Visits[&BF];
+            },
+            Skipped ? PredicateTy(skip) : PredicateTy(), "test",
+            /*ForceSequential=*/false, TasksPerThread);
+        checkVisits(Visits, Skipped);
+      }
+    }
+  }
+}
+
+TEST_P(ParallelUtilitiesTester, EachFunctionOnceWithUniqueAllocId) {
+  using namespace ParallelUtilities;
+  for (unsigned TasksPerThread : {1u, 20u, NumFunctions * 2}) {
+    for (bool Skipped : {false, true}) {
+      std::mutex Mutex;
+      DenseMap<const BinaryFunction *, unsigned> Visits;
+      // The number of functions being worked on with each allocator. No two
+      // functions may use the same allocator at the same time.
+      std::atomic<unsigned> InUse[NumThreads + 1] = {};
+      runOnEachFunctionWithUniqueAllocId(
+          *BC, SP_INST_LINEAR,
+          [&](BinaryFunction &BF, MCPlusBuilder::AllocatorIdTy AllocId) {
+            ASSERT_GE(AllocId, 1u);
+            ASSERT_LE(AllocId, NumThreads);
+            EXPECT_TRUE(BC->MIB->checkAllocatorExists(AllocId));
+            EXPECT_EQ(InUse[AllocId]++, 0u);
+            {
+              std::lock_guard<std::mutex> Lock(Mutex);
+              ++Visits[&BF];
+            }
+            --InUse[AllocId];
+          },
+          Skipped ? PredicateTy(skip) : PredicateTy(), "test",
+          /*ForceSequential=*/false, TasksPerThread);
+      checkVisits(Visits, Skipped);
+    }
+  }
+
+  // Sequential runs use the default allocator.
+  DenseMap<const BinaryFunction *, unsigned> Visits;
+  runOnEachFunctionWithUniqueAllocId(
+      *BC, SP_INST_LINEAR,
+      [&](BinaryFunction &BF, MCPlusBuilder::AllocatorIdTy AllocId) {
+        EXPECT_EQ(AllocId, 0u);
+        ++Visits[&BF];
+      },
+      PredicateTy(), "test", /*ForceSequential=*/true);
+  checkVisits(Visits, /*Skipped=*/false);
+}
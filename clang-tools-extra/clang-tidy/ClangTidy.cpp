@@ -39,8 +39,11 @@
 #include "clang/Tooling/Refactoring.h"
 #include "clang/Tooling/ReplacementsYaml.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
+#include <mutex>
 #include <utility>
 
 #if CLANG_TIDY_ENABLE_STATIC_ANALYZER
@@ -509,13 +512,121 @@ getCheckOptions(const ClangTidyOptions &Options,
   return Factory.getCheckOptions();
 }
 
-std::vector<ClangTidyError>
-runClangTidy(clang::tidy::ClangTidyContext &Context,
-             const CompilationDatabase &Compilations,
+namespace {
+class ActionFactory : public FrontendActionFactory {
+public:
+  ActionFactory(ClangTidyContext &Context,
+                IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS)
+      : ConsumerFactory(Context, std::move(BaseFS)) {}
+  std::unique_ptr<FrontendAction> create() override {
+    return std::make_unique<Action>(&ConsumerFactory);
+  }
+
+  bool runInvocation(std::shared_ptr<CompilerInvocation> Invocation,
+                     FileManager *Files,
+                     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                     DiagnosticConsumer *DiagConsumer) override {
+    // Explicitly ask to define __clang_analyzer__ macro.
+    Invocation->getPreprocessorOpts().SetUpStaticAnalyzer = true;
+    return FrontendActionFactory::runInvocation(
+        Invocation, Files, PCHContainerOps, DiagConsumer);
+  }
+
+private:
+  class Action : public ASTFrontendAction {
+  public:
+    Action(ClangTidyASTConsumerFactory *Factory) : Factory(Factory) {}
+    std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
+                                                   StringRef File) override {
+      return Factory->createASTConsumer(Compiler, File);
+    }
+
+  private:
+    ClangTidyASTConsumerFactory *Factory;
+  };
+
+  ClangTidyASTConsumerFactory ConsumerFactory;
+};
+
+/// Provides the options of a context shared by the threads running the check
+/// partitions.
+class SharedContextOptionsProvider : public ClangTidyOptionsProvider {
+public:
+  SharedContextOptionsProvider(const ClangTidyContext &Context,
+                               std::mutex &Mutex)
+      : Context(Context), Mutex(Mutex) {}
+
+  const ClangTidyGlobalOptions &getGlobalOptions() override {
+    return Context.getGlobalOptions();
+  }
+
+  std::vector<OptionsSource> getRawOptions(StringRef FileName) override {
+    // Options providers cache the configuration files they read.
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return {OptionsSource(Context.getOptionsForFile(FileName),
+                          "clang-tidy check partition")};
+  }
+
+private:
+  const ClangTidyContext &Context;
+  std::mutex &Mutex;
+};
+
+/// Keeps a working directory of its own rather than changing the one of the
+/// underlying file system, which is shared by the threads running the check
+/// partitions and may be the working directory of the process.
+class WorkingDirectoryFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+  explicit WorkingDirectoryFileSystem(IntrusiveRefCntPtr<vfs::FileSystem> FS)
+      : ProxyFileSystem(FS) {
+    if (auto CWD = FS->getCurrentWorkingDirectory())
+      WorkingDirectory = *CWD;
+  }
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override {
+    return ProxyFileSystem::status(resolve(Path));
+  }
+  llvm::ErrorOr<std::unique_ptr<vfs::File>>
+  openFileForRead(const Twine &Path) override {
+    return ProxyFileSystem::openFileForRead(resolve(Path));
+  }
+  vfs::directory_iterator dir_begin(const Twine &Dir,
+                                    std::error_code &EC) override {
+    return ProxyFileSystem::dir_begin(resolve(Dir), EC);
+  }
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override {
+    WorkingDirectory = resolve(Path);
+    return {};
+  }
+  std::error_code getRealPath(const Twine &Path,
+                              SmallVectorImpl<char> &Output) const override {
+    return ProxyFileSystem::getRealPath(resolve(Path), Output);
+  }
+  std::error_code isLocal(const Twine &Path, bool &Result) override {
+    return ProxyFileSystem::isLocal(resolve(Path), Result);
+  }
+
+private:
+  std::string resolve(const Twine &Path) const {
+    SmallString<256> Result;
+    Path.toVector(Result);
+    if (!llvm::sys::path::is_absolute(Result))
+      llvm::sys::fs::make_absolute(WorkingDirectory, Result);
+    return std::string(Result);
+  }
+
+  std::string WorkingDirectory;
+};
+} // namespace
+
+static void
+runClangTool(ClangTidyContext &Context, const CompilationDatabase &Compilations,
              ArrayRef<std::string> InputFiles,
              llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
-             bool ApplyAnyFix, bool EnableCheckProfile,
-             llvm::StringRef StoreCheckProfile) {
+             ClangTidyDiagnosticConsumer &DiagConsumer) {
   ClangTool Tool(Compilations, InputFiles,
                  std::make_shared<PCHContainerOperations>(), BaseFS);
 
@@ -539,52 +650,68 @@ runClangTidy(clang::tidy::ClangTidyContext &Context,
 
   Tool.appendArgumentsAdjuster(PerFileExtraArgumentsInserter);
   Tool.appendArgumentsAdjuster(getStripPluginsAdjuster());
-  Context.setEnableProfiling(EnableCheckProfile);
-  Context.setProfileStoragePrefix(StoreCheckProfile);
 
-  ClangTidyDiagnosticConsumer DiagConsumer(Context, nullptr, true, ApplyAnyFix);
   DiagnosticsEngine DE(new DiagnosticIDs(), new DiagnosticOptions(),
                        &DiagConsumer, /*ShouldOwnClient=*/false);
   Context.setDiagnosticsEngine(&DE);
   Tool.setDiagnosticConsumer(&DiagConsumer);
 
-  class ActionFactory : public FrontendActionFactory {
-  public:
-    ActionFactory(ClangTidyContext &Context,
-                  IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS)
-        : ConsumerFactory(Context, std::move(BaseFS)) {}
-    std::unique_ptr<FrontendAction> create() override {
-      return std::make_unique<Action>(&ConsumerFactory);
-    }
-
-    bool runInvocation(std::shared_ptr<CompilerInvocation> Invocation,
-                       FileManager *Files,
-                       std::shared_ptr<PCHContainerOperations> PCHContainerOps,
-                       DiagnosticConsumer *DiagConsumer) override {
-      // Explicitly ask to define __clang_analyzer__ macro.
-      Invocation->getPreprocessorOpts().SetUpStaticAnalyzer = true;
-      return FrontendActionFactory::runInvocation(
-          Invocation, Files, PCHContainerOps, DiagConsumer);
-    }
+  ActionFactory Factory(Context, std::move(BaseFS));
+  Tool.run(&Factory);
+}
 
-  private:
-    class Action : public ASTFrontendAction {
-    public:
-      Action(ClangTidyASTConsumerFactory *Factory) : Factory(Factory) {}
-      std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &Compiler,
-                                                     StringRef File) override {
-        return Factory->createASTConsumer(Compiler, File);
-      }
+std::vector<ClangTidyError>
+runClangTidy(clang::tidy::ClangTidyContext &Context,
+             const CompilationDatabase &Compilations,
+             ArrayRef<std::string> InputFiles,
+             llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
+             bool ApplyAnyFix, bool EnableCheckProfile,
+             llvm::StringRef StoreCheckProfile, unsigned NumCheckPartitions) {
+  Context.setEnableProfiling(EnableCheckProfile);
+  Context.setProfileStoragePrefix(StoreCheckProfile);
 
-    private:
-      ClangTidyASTConsumerFactory *Factory;
-    };
+  ClangTidyDiagnosticConsumer DiagConsumer(Context, nullptr, true, ApplyAnyFix);
+  // Profiles are collected per translation unit, and would be split.
+  if (NumCheckPartitions <= 1 || EnableCheckProfile) {
+    runClangTool(Context, Compilations, InputFiles, std::move(BaseFS),
+                 DiagConsumer);
+    return DiagConsumer.take();
+  }
 
-    ClangTidyASTConsumerFactory ConsumerFactory;
-  };
+  // Traversing an AST from several threads is not safe: the ASTContext caches
+  // type layouts and parent maps, and DeclContext lookup tables are built
+  // lazily. Each partition of the checks therefore parses the input files on
+  // its own, with a context of its own. Context is only used to provide the
+  // options to the partitions, and to collect their statistics.
+  std::mutex OptionsMutex;
+  std::vector<std::unique_ptr<ClangTidyContext>> Contexts;
+  std::vector<std::unique_ptr<ClangTidyDiagnosticConsumer>> DiagConsumers;
+  for (unsigned I = 0; I < NumCheckPartitions; ++I) {
+    Contexts.push_back(std::make_unique<ClangTidyContext>(
+        std::make_unique<SharedContextOptionsProvider>(Context, OptionsMutex),
+        Context.canEnableAnalyzerAlphaCheckers()));
+    Contexts.back()->setCheckPartition(I, NumCheckPartitions);
+    DiagConsumers.push_back(std::make_unique<ClangTidyDiagnosticConsumer>(
+        *Contexts.back(), nullptr, /*RemoveIncompatibleErrors=*/false,
+        ApplyAnyFix));
+  }
 
-  ActionFactory Factory(Context, std::move(BaseFS));
-  Tool.run(&Factory);
+  ThreadPool Pool(hardware_concurrency(NumCheckPartitions));
+  for (unsigned I = 0; I < NumCheckPartitions; ++I)
+    Pool.async([&, I] {
+      IntrusiveRefCntPtr<vfs::OverlayFileSystem> PartitionFS(
+          new vfs::OverlayFileSystem(
+              new WorkingDirectoryFileSystem(BaseFS)));
+      runClangTool(*Contexts[I], Compilations, InputFiles, PartitionFS,
+                   *DiagConsumers[I]);
+    });
+  Pool.wait();
+
+  // Diagnostics are merged in the order of the partitions, and take() then
+  // sorts them by location and resolves conflicting fixes across all the
+  // partitions, so that the output does not depend on the scheduling.
+  for (auto &PartitionConsumer : DiagConsumers)
+    DiagConsumer.merge(*PartitionConsumer);
   return DiagConsumer.take();
 }
 
@@ -74,13 +74,17 @@ getCheckOptions(const ClangTidyOptions &Options,
 /// \param StoreCheckProfile If provided, and EnableCheckProfile is true,
 /// the profile will not be output to stderr, but will instead be stored
 /// as a JSON file in the specified directory.
+/// \param NumCheckPartitions If greater than one, the enabled checks are split
+/// into this many partitions that run on separate threads, each parsing the
+/// input files on its own. Ignored if \p EnableCheckProfile is true.
 std::vector<ClangTidyError>
 runClangTidy(clang::tidy::ClangTidyContext &Context,
              const tooling::CompilationDatabase &Compilations,
              ArrayRef<std::string> InputFiles,
              llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> BaseFS,
              bool ApplyAnyFix, bool EnableCheckProfile = false,
-             llvm::StringRef StoreCheckProfile = StringRef());
+             llvm::StringRef StoreCheckProfile = StringRef(),
+             unsigned NumCheckPartitions = 1);
 
 /// Controls what kind of fixes clang-tidy is allowed to apply.
 enum FixBehaviour {
@@ -36,6 +36,7 @@
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Regex.h"
+#include "llvm/Support/xxhash.h"
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -264,7 +265,21 @@ ClangTidyContext::getProfileStorageParams() const {
 
 bool ClangTidyContext::isCheckEnabled(StringRef CheckName) const {
   assert(CheckFilter != nullptr);
-  return CheckFilter->contains(CheckName);
+  return CheckFilter->contains(CheckName) && isInCheckPartition(CheckName);
+}
+
+bool ClangTidyContext::isInCheckPartition(StringRef CheckName) const {
+  if (NumCheckPartitions <= 1)
+    return true;
+  unsigned Partition;
+  if (CheckName.startswith("clang-analyzer-"))
+    Partition = NumCheckPartitions - 1;
+  else if (CheckName.empty() || CheckName.startswith("clang-diagnostic-") ||
+           CheckName.startswith("clang-tidy-"))
+    Partition = 0;
+  else
+    Partition = llvm::xxHash64(CheckName) % NumCheckPartitions;
+  return Partition == CheckPartition;
 }
 
 bool ClangTidyContext::treatAsError(StringRef CheckName) const {
@@ -346,6 +361,14 @@ void ClangTidyDiagnosticConsumer::HandleDiagnostic(
   if (LastErrorWasIgnored && DiagLevel == DiagnosticsEngine::Note)
     return;
 
+  // Diagnostics of the other partitions, including the compiler's, are
+  // reported by the consumers running them.
+  if (DiagLevel != DiagnosticsEngine::Note &&
+      !Context.isInCheckPartition(Context.getCheckName(Info.getID()))) {
+    LastErrorWasIgnored = true;
+    return;
+  }
+
   SmallVector<tooling::Diagnostic, 1> SuppressionErrors;
   if (Context.shouldSuppressDiagnostic(DiagLevel, Info, SuppressionErrors,
                                        EnableNolintBlocks)) {
@@ -721,8 +744,27 @@ struct EqualClangTidyError {
 };
 } // end anonymous namespace
 
+void ClangTidyDiagnosticConsumer::merge(ClangTidyDiagnosticConsumer &Other) {
+  Other.finalizeLastError();
+  MergedErrors.insert(MergedErrors.end(),
+                      std::make_move_iterator(Other.Errors.begin()),
+                      std::make_move_iterator(Other.Errors.end()));
+  Other.Errors.clear();
+
+  const ClangTidyStats &OtherStats = Other.Context.Stats;
+  ClangTidyStats &Stats = Context.Stats;
+  Stats.ErrorsDisplayed += OtherStats.ErrorsDisplayed;
+  Stats.ErrorsIgnoredCheckFilter += OtherStats.ErrorsIgnoredCheckFilter;
+  Stats.ErrorsIgnoredNOLINT += OtherStats.ErrorsIgnoredNOLINT;
+  Stats.ErrorsIgnoredNonUserCode += OtherStats.ErrorsIgnoredNonUserCode;
+  Stats.ErrorsIgnoredLineFilter += OtherStats.ErrorsIgnoredLineFilter;
+}
+
 std::vector<ClangTidyError> ClangTidyDiagnosticConsumer::take() {
   finalizeLastError();
+  Errors.insert(Errors.end(), std::make_move_iterator(MergedErrors.begin()),
+                std::make_move_iterator(MergedErrors.end()));
+  MergedErrors.clear();
 
   llvm::stable_sort(Errors, LessClangTidyError());
   Errors.erase(std::unique(Errors.begin(), Errors.end(), EqualClangTidyError()),
@@ -142,6 +142,21 @@ public:
   /// The \c CurrentFile can be changed using \c setCurrentFile.
   bool isCheckEnabled(StringRef CheckName) const;
 
+  /// Restricts the checks run through this context to the \p Partition-th of
+  /// \p NumPartitions disjoint sets of checks. This allows running the sets
+  /// on separate threads, each with its own context.
+  void setCheckPartition(unsigned Partition, unsigned NumPartitions) {
+    assert(Partition < NumPartitions && "Partition out of range");
+    CheckPartition = Partition;
+    NumCheckPartitions = NumPartitions;
+  }
+
+  /// Returns \c true if the diagnostics named \p CheckName are reported
+  /// through this context. Compiler diagnostics belong to the first partition,
+  /// and all the static analyzer checks to the last one, as they share a
+  /// single analysis.
+  bool isInCheckPartition(StringRef CheckName) const;
+
   /// Returns \c true if the check should be upgraded to error for the
   /// \c CurrentFile.
   bool treatAsError(StringRef CheckName) const;
@@ -210,6 +225,9 @@ private:
   std::unique_ptr<CachedGlobList> CheckFilter;
   std::unique_ptr<CachedGlobList> WarningAsErrorFilter;
 
+  unsigned CheckPartition = 0;
+  unsigned NumCheckPartitions = 1;
+
   LangOptions LangOpts;
 
   ClangTidyStats Stats;
@@ -256,6 +274,11 @@ public:
   // Retrieve the diagnostics that were captured.
   std::vector<ClangTidyError> take();
 
+  /// Adds the diagnostics captured by \p Other, which ran another partition of
+  /// the checks over the same files, and its statistics. take() then sorts,
+  /// deduplicates and resolves conflicting fixes across all the partitions.
+  void merge(ClangTidyDiagnosticConsumer &Other);
+
 private:
   void finalizeLastError();
   void removeIncompatibleErrors();
@@ -278,6 +301,8 @@ private:
   bool GetFixesFromNotes;
   bool EnableNolintBlocks;
   std::vector<ClangTidyError> Errors;
+  /// Already finalized errors of other partitions, see merge().
+  std::vector<ClangTidyError> MergedErrors;
   std::unique_ptr<llvm::Regex> HeaderFilter;
   bool LastErrorRelatesToUserCode;
   bool LastErrorPassesLineFilter;
@@ -216,6 +216,21 @@ these per-TU profiles are instead stored as JSON.
                                               cl::value_desc("prefix"),
                                               cl::cat(ClangTidyCategory));
 
+static cl::opt<unsigned> ParallelChecks("parallel-checks", cl::desc(R"(
+Split the enabled checks into this many groups,
+and run each group on its own thread, so that
+the checks of a single input file run in
+parallel. Every group parses the input files
+on its own, which multiplies the parsing time
+and memory by the number of groups. This only
+pays off when running the checks takes longer
+than parsing, as for large generated files.
+The diagnostics do not depend on the number of
+groups. Ignored along with -enable-check-profile.
+)"),
+                                        cl::init(1),
+                                        cl::cat(ClangTidyCategory));
+
 /// This option allows enabling the experimental alpha checkers from the static
 /// analyzer. This option is set to false and not visible in help, because it is
 /// highly not recommended for users.
@@ -498,7 +513,7 @@ int clangTidyMain(int argc, const char **argv) {
                            AllowEnablingAnalyzerAlphaCheckers);
   std::vector<ClangTidyError> Errors =
       runClangTidy(Context, OptionsParser->getCompilations(), PathList, BaseFS,
-                   FixNotes, EnableCheckProfile, ProfilePrefix);
+                   FixNotes, EnableCheckProfile, ProfilePrefix, ParallelChecks);
   bool FoundErrors = llvm::find_if(Errors, [](const ClangTidyError &E) {
                        return E.DiagLevel == ClangTidyError::Error;
                      }) != Errors.end();
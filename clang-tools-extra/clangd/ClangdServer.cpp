@@ -145,6 +145,8 @@ ClangdServer::Options::operator TUScheduler::Options() const {
   Opts.AsyncThreadsCount = AsyncThreadsCount;
   Opts.RetentionPolicy = RetentionPolicy;
   Opts.StorePreamblesInMemory = StorePreamblesInMemory;
+  Opts.SharedPreambleDir = SharedPreambleDir;
+  Opts.SharedPreambleDirMaxBytes = SharedPreambleDirMaxBytes;
   Opts.UpdateDebounce = UpdateDebounce;
   Opts.ContextProvider = ContextProvider;
   return Opts;
@@ -108,6 +108,11 @@ public:
     /// Cached preambles are potentially large. If false, store them on disk.
     bool StorePreamblesInMemory = true;
 
+    /// If not empty, share preambles with other clangd processes through this
+    /// directory, bounded by SharedPreambleDirMaxBytes if non-zero.
+    std::string SharedPreambleDir;
+    uint64_t SharedPreambleDirMaxBytes = 0;
+
     /// If true, ClangdServer builds a dynamic in-memory index for symbols in
     /// opened files and uses the index to augment code completion results.
     bool BuildDynamicSymbolIndex = false;
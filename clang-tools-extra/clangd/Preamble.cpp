@@ -40,6 +40,7 @@
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
@@ -316,12 +317,35 @@ bool isMainFile(llvm::StringRef FileName, const SourceManager &SM) {
   return FE && *FE == SM.getFileEntryForID(SM.getMainFileID());
 }
 
+// Moves the PCH to the shared store. Failures are not fatal, the preamble
+// simply stays private to this process.
+void sharePreamble(PrecompiledPreamble &Preamble,
+                   const SharedPreambleStore &Store, PathRef FileName) {
+  trace::Span Tracer("SharePreamble");
+  if (auto EC = Preamble.moveToSharedStore(Store.Directory)) {
+    elog("Could not share preamble for file {0} in {1}: {2}", FileName,
+         Store.Directory, EC.message());
+    return;
+  }
+  if (!Store.MaxSizeBytes)
+    return;
+  llvm::CachePruningPolicy Policy;
+  // Preamble builds are expensive enough that scanning the store after each
+  // of them is cheap in comparison, but rate-limit it across processes anyway.
+  Policy.Interval = std::chrono::seconds(60);
+  Policy.MaxSizeBytes = Store.MaxSizeBytes;
+  // Mapped preambles stay valid once their file is pruned, so the budget can
+  // be enforced without coordinating with the processes using them.
+  llvm::pruneCache(Store.Directory, Policy);
+}
+
 } // namespace
 
 std::shared_ptr<const PreambleData>
 buildPreamble(PathRef FileName, CompilerInvocation CI,
               const ParseInputs &Inputs, bool StoreInMemory,
-              PreambleParsedCallback PreambleCallback) {
+              PreambleParsedCallback PreambleCallback,
+              const SharedPreambleStore *SharedStore) {
   // Note that we don't need to copy the input contents, preamble can live
   // without those.
   auto ContentsBuffer =
@@ -391,6 +415,8 @@ buildPreamble(PathRef FileName, CompilerInvocation CI,
   if (BuiltPreamble) {
     vlog("Built preamble of size {0} for file {1} version {2}",
          BuiltPreamble->getSize(), FileName, Inputs.Version);
+    if (SharedStore)
+      sharePreamble(*BuiltPreamble, *SharedStore, FileName);
     std::vector<Diag> Diags = PreambleDiagnostics.take();
     auto Result = std::make_shared<PreambleData>(std::move(*BuiltPreamble));
     Result->Version = Inputs.Version;
@@ -75,13 +75,25 @@ struct PreambleData {
 using PreambleParsedCallback = std::function<void(ASTContext &, Preprocessor &,
                                                   const CanonicalIncludes &)>;
 
+/// A directory where clangd processes publish the preambles they build, named
+/// after their contents. Processes working on the same code then map the same
+/// files rather than each keeping a private copy of identical preambles.
+struct SharedPreambleStore {
+  std::string Directory;
+  /// Least recently used preambles are pruned from the store beyond this size.
+  /// 0 means no limit.
+  uint64_t MaxSizeBytes = 0;
+};
+
 /// Build a preamble for the new inputs unless an old one can be reused.
 /// If \p PreambleCallback is set, it will be run on top of the AST while
 /// building the preamble.
+/// If \p SharedStore is set, the preamble is moved there once built.
 std::shared_ptr<const PreambleData>
 buildPreamble(PathRef FileName, CompilerInvocation CI,
               const ParseInputs &Inputs, bool StoreInMemory,
-              PreambleParsedCallback PreambleCallback);
+              PreambleParsedCallback PreambleCallback,
+              const SharedPreambleStore *SharedStore = nullptr);
 
 /// Returns true if \p Preamble is reusable for \p Inputs. Note that it will
 /// return true when some missing headers are now available.
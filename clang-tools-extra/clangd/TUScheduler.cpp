@@ -313,6 +313,16 @@ bool isReliable(const tooling::CompileCommand &Cmd) {
   return Cmd.Heuristic.empty();
 }
 
+llvm::Optional<SharedPreambleStore>
+sharedPreambleStore(const TUScheduler::Options &Opts) {
+  if (Opts.SharedPreambleDir.empty())
+    return llvm::None;
+  SharedPreambleStore Store;
+  Store.Directory = Opts.SharedPreambleDir;
+  Store.MaxSizeBytes = Opts.SharedPreambleDirMaxBytes;
+  return Store;
+}
+
 /// Threadsafe manager for updating a TUStatus and emitting it after each
 /// update.
 class SynchronizedTUStatus {
@@ -353,12 +363,14 @@ private:
 class PreambleThread {
 public:
   PreambleThread(llvm::StringRef FileName, ParsingCallbacks &Callbacks,
-                 bool StorePreambleInMemory, bool RunSync,
+                 bool StorePreambleInMemory,
+                 llvm::Optional<SharedPreambleStore> SharedStore, bool RunSync,
                  SynchronizedTUStatus &Status,
                  TUScheduler::HeaderIncluderCache &HeaderIncluders,
                  ASTWorker &AW)
       : FileName(FileName), Callbacks(Callbacks),
-        StoreInMemory(StorePreambleInMemory), RunSync(RunSync), Status(Status),
+        StoreInMemory(StorePreambleInMemory),
+        SharedStore(std::move(SharedStore)), RunSync(RunSync), Status(Status),
         ASTPeer(AW), HeaderIncluders(HeaderIncluders) {}
 
   /// It isn't guaranteed that each requested version will be built. If there
@@ -482,6 +494,7 @@ private:
   const Path FileName;
   ParsingCallbacks &Callbacks;
   const bool StoreInMemory;
+  const llvm::Optional<SharedPreambleStore> SharedStore;
   const bool RunSync;
 
   SynchronizedTUStatus &Status;
@@ -742,8 +755,9 @@ ASTWorker::ASTWorker(PathRef FileName, const GlobalCompilationDatabase &CDB,
       UpdateDebounce(Opts.UpdateDebounce), FileName(FileName),
       ContextProvider(Opts.ContextProvider), CDB(CDB), Callbacks(Callbacks),
       Barrier(Barrier), Done(false), Status(FileName, Callbacks),
-      PreamblePeer(FileName, Callbacks, Opts.StorePreamblesInMemory, RunSync,
-                   Status, HeaderIncluders, *this) {
+      PreamblePeer(FileName, Callbacks, Opts.StorePreamblesInMemory,
+                   sharedPreambleStore(Opts), RunSync, Status, HeaderIncluders,
+                   *this) {
   // Set a fallback command because compile command can be accessed before
   // `Inputs` is initialized. Other fields are only used after initialization
   // from client inputs.
@@ -979,7 +993,8 @@ void PreambleThread::build(Request Req) {
       [this, Version(Inputs.Version)](ASTContext &Ctx, Preprocessor &PP,
                                       const CanonicalIncludes &CanonIncludes) {
         Callbacks.onPreambleAST(FileName, Version, Ctx, PP, CanonIncludes);
-      });
+      },
+      SharedStore.getPointer());
   if (LatestBuild && isReliable(LatestBuild->CompileCommand))
     HeaderIncluders.update(FileName, LatestBuild->Includes.allHeaders());
 }
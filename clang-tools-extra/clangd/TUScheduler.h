@@ -194,6 +194,12 @@ public:
     /// Cache (large) preamble data in RAM rather than temporary files on disk.
     bool StorePreamblesInMemory = false;
 
+    /// If not empty, preambles are moved to this directory once built, so that
+    /// clangd processes working on the same code share identical preambles.
+    std::string SharedPreambleDir;
+    /// Size budget of SharedPreambleDir, 0 means no limit.
+    uint64_t SharedPreambleDirMaxBytes = 0;
+
     /// Time to wait after an update to see if another one comes along.
     /// This tries to ensure we rebuild once the user stops typing.
     DebouncePolicy UpdateDebounce;
@@ -12,26 +12,103 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MathExtras.h"
+#include <array>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace clang {
 namespace clangd {
 namespace dex {
 namespace {
 
-/// Implements iterator of PostingList chunks. This requires iterating over two
-/// levels: the first level iterator iterates over the chunks and decompresses
-/// them on-the-fly when the contents of chunk are to be seen.
-class ChunkIterator : public Iterator {
-public:
-  explicit ChunkIterator(const Token *Tok, llvm::ArrayRef<Chunk> Chunks)
-      : Tok(Tok), Chunks(Chunks), CurrentChunk(Chunks.begin()) {
-    if (!Chunks.empty()) {
-      DecompressedChunk = CurrentChunk->decompress();
-      CurrentID = DecompressedChunk.begin();
+/// Decompressed DocIDs of a block. The entries past the end of the block are
+/// set to the largest DocID, and there are a few more than Block::Size of them
+/// so that the block can be scanned a vector at a time without bounds checks.
+using DecodedBlock = std::array<DocID, Block::Size + 4>;
+
+/// Replaces Docs[0...Count) by its inclusive prefix sum.
+void prefixSum(DocID *Docs, size_t Count) {
+  size_t I = 0;
+#ifdef __SSE2__
+  __m128i Carry = _mm_setzero_si128();
+  for (; I + 4 <= Count; I += 4) {
+    __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Docs + I));
+    V = _mm_add_epi32(V, _mm_slli_si128(V, 4));
+    V = _mm_add_epi32(V, _mm_slli_si128(V, 8));
+    V = _mm_add_epi32(V, Carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(Docs + I), V);
+    // Broadcast the last lane as the carry into the next vector.
+    Carry = _mm_shuffle_epi32(V, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+#endif
+  for (I = std::max<size_t>(I, 1); I < Count; ++I)
+    Docs[I] += Docs[I - 1];
+}
+
+/// Returns the index of the first DocID not less than ID in Docs[From...],
+/// which is sorted and terminated by the largest DocID.
+size_t findNotLess(const DecodedBlock &Docs, size_t From, DocID ID) {
+#ifdef __SSE2__
+  // SSE2 only has signed comparisons, flip the sign bits to compare unsigned
+  // values.
+  const __m128i SignBit = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m128i Needle = _mm_xor_si128(_mm_set1_epi32(ID), SignBit);
+  for (;; From += 4) {
+    __m128i V =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Docs.data() + From));
+    unsigned Less = _mm_movemask_ps(
+        _mm_castsi128_ps(_mm_cmplt_epi32(_mm_xor_si128(V, SignBit), Needle)));
+    if (Less != 0xf)
+      return From + llvm::countTrailingOnes(Less);
+  }
+#else
+  return std::partition_point(Docs.begin() + From, Docs.end(),
+                              [&](const DocID D) { return D < ID; }) -
+         Docs.begin();
+#endif
+}
+
+/// Decompresses B into Docs, returns the number of DocIDs in B.
+size_t decompress(const Block &B, llvm::ArrayRef<uint32_t> Payload,
+                  DecodedBlock &Docs) {
+  size_t Count = B.Last + 1;
+  Docs[0] = B.Head;
+  if (B.Width == 0) {
+    std::fill(Docs.begin() + 1, Docs.begin() + Count, 1);
+  } else {
+    const uint32_t *Words = Payload.data() + B.Offset;
+    const uint64_t Mask = (uint64_t(1) << B.Width) - 1;
+    for (size_t I = 1, Bit = 0; I < Count; ++I, Bit += B.Width) {
+      // Payload is padded with a word, so that the last gap can be read as
+      // part of a 64-bit window as well.
+      uint64_t Window =
+          Words[Bit / 32] | (uint64_t(Words[Bit / 32 + 1]) << 32);
+      Docs[I] = ((Window >> (Bit % 32)) & Mask) + 1;
     }
   }
+  prefixSum(Docs.data(), Count);
+  std::fill(Docs.begin() + Count, Docs.end(),
+            std::numeric_limits<DocID>::max());
+  return Count;
+}
 
-  bool reachedEnd() const override { return CurrentChunk == Chunks.end(); }
+/// Implements iterator of PostingList blocks. This requires iterating over two
+/// levels: the first level iterator iterates over the blocks and decompresses
+/// them on-the-fly when the contents of block are to be seen.
+class BlockIterator : public Iterator {
+public:
+  explicit BlockIterator(const Token *Tok, llvm::ArrayRef<Block> Blocks,
+                         llvm::ArrayRef<uint32_t> Payload)
+      : Tok(Tok), Blocks(Blocks), Payload(Payload),
+        CurrentBlock(Blocks.begin()) {
+    if (!Blocks.empty())
+      decompressCurrentBlock();
+  }
+
+  bool reachedEnd() const override { return CurrentBlock == Blocks.end(); }
 
   /// Advances cursor to the next item.
   void advance() override {
@@ -41,23 +118,22 @@ public:
     normalizeCursor();
   }
 
-  /// Applies binary search to advance cursor to the next item with DocID
-  /// equal or higher than the given one.
+  /// Uses the block heads to skip to the block which might contain the next
+  /// item with DocID equal or higher than the given one, then scans it.
   void advanceTo(DocID ID) override {
     assert(!reachedEnd() &&
            "Posting List iterator can't advance() at the end.");
     if (ID <= peek())
       return;
-    advanceToChunk(ID);
-    // Try to find ID within current chunk.
-    CurrentID = std::partition_point(CurrentID, DecompressedChunk.end(),
-                                     [&](const DocID D) { return D < ID; });
+    advanceToBlock(ID);
+    // Try to find ID within current block.
+    CurrentID = findNotLess(DecompressedBlock, CurrentID, ID);
     normalizeCursor();
   }
 
   DocID peek() const override {
     assert(!reachedEnd() && "Posting List iterator can't peek() at the end.");
-    return *CurrentID;
+    return DecompressedBlock[CurrentID];
   }
 
   float consume() override {
@@ -67,7 +143,10 @@ public:
   }
 
   size_t estimateSize() const override {
-    return Chunks.size() * ApproxEntriesPerChunk;
+    // All blocks but the last one are full.
+    return Blocks.empty() ? 0
+                          : (Blocks.size() - 1) * Block::Size +
+                                Blocks.back().Last + 1;
   }
 
 private:
@@ -76,151 +155,125 @@ private:
       return OS << *Tok;
     OS << '[';
     const char *Sep = "";
-    for (const Chunk &C : Chunks)
-      for (const DocID Doc : C.decompress()) {
+    DecodedBlock Docs;
+    for (const Block &B : Blocks) {
+      size_t Count = decompress(B, Payload, Docs);
+      for (const DocID Doc : llvm::makeArrayRef(Docs.data(), Count)) {
         OS << Sep << Doc;
         Sep = " ";
       }
+    }
     return OS << ']';
   }
 
-  /// If the cursor is at the end of a chunk, place it at the start of the next
-  /// chunk.
+  /// If the cursor is at the end of a block, place it at the start of the next
+  /// block.
   void normalizeCursor() {
-    // Invariant is already established if examined chunk is not exhausted.
-    if (CurrentID != std::end(DecompressedChunk))
+    // Invariant is already established if examined block is not exhausted.
+    if (CurrentID != BlockSize)
       return;
-    // Advance to next chunk if current one is exhausted.
-    ++CurrentChunk;
-    if (CurrentChunk == Chunks.end()) // Reached the end of PostingList.
+    // Advance to next block if current one is exhausted.
+    ++CurrentBlock;
+    if (CurrentBlock == Blocks.end()) // Reached the end of PostingList.
       return;
-    DecompressedChunk = CurrentChunk->decompress();
-    CurrentID = DecompressedChunk.begin();
+    decompressCurrentBlock();
   }
 
-  /// Advances CurrentChunk to the chunk which might contain ID.
-  void advanceToChunk(DocID ID) {
-    if ((CurrentChunk != Chunks.end() - 1) &&
-        ((CurrentChunk + 1)->Head <= ID)) {
-      CurrentChunk =
-          std::partition_point(CurrentChunk + 1, Chunks.end(),
-                               [&](const Chunk &C) { return C.Head < ID; });
-      --CurrentChunk;
-      DecompressedChunk = CurrentChunk->decompress();
-      CurrentID = DecompressedChunk.begin();
+  /// Advances CurrentBlock to the block which might contain ID.
+  void advanceToBlock(DocID ID) {
+    if ((CurrentBlock != Blocks.end() - 1) &&
+        ((CurrentBlock + 1)->Head <= ID)) {
+      CurrentBlock =
+          std::partition_point(CurrentBlock + 1, Blocks.end(),
+                               [&](const Block &B) { return B.Head <= ID; });
+      --CurrentBlock;
+      decompressCurrentBlock();
     }
   }
 
+  void decompressCurrentBlock() {
+    BlockSize = decompress(*CurrentBlock, Payload, DecompressedBlock);
+    CurrentID = 0;
+  }
+
   const Token *Tok;
-  llvm::ArrayRef<Chunk> Chunks;
-  /// Iterator over chunks.
-  /// If CurrentChunk is valid, then DecompressedChunk is
-  /// CurrentChunk->decompress() and CurrentID is a valid (non-end) iterator
-  /// into it.
-  decltype(Chunks)::const_iterator CurrentChunk;
-  llvm::SmallVector<DocID, Chunk::PayloadSize + 1> DecompressedChunk;
-  /// Iterator over DecompressedChunk.
-  decltype(DecompressedChunk)::iterator CurrentID;
-
-  static constexpr size_t ApproxEntriesPerChunk = 15;
+  llvm::ArrayRef<Block> Blocks;
+  llvm::ArrayRef<uint32_t> Payload;
+  /// Iterator over blocks.
+  /// If CurrentBlock is valid, then DecompressedBlock holds its BlockSize
+  /// DocIDs and CurrentID is a valid (non-end) index into it.
+  decltype(Blocks)::const_iterator CurrentBlock;
+  DecodedBlock DecompressedBlock;
+  size_t BlockSize = 0;
+  /// Index into DecompressedBlock.
+  size_t CurrentID = 0;
 };
 
-static constexpr size_t BitsPerEncodingByte = 7;
-
-/// Writes a variable length DocID into the buffer and updates the buffer size.
-/// If it doesn't fit, returns false and doesn't write to the buffer.
-bool encodeVByte(DocID Delta, llvm::MutableArrayRef<uint8_t> &Payload) {
-  assert(Delta != 0 && "0 is not a valid PostingList delta.");
-  // Calculate number of bytes Delta encoding would take by examining the
-  // meaningful bits.
-  unsigned Width = 1 + llvm::findLastSet(Delta) / BitsPerEncodingByte;
-  if (Width > Payload.size())
-    return false;
-
-  do {
-    uint8_t Encoding = Delta & 0x7f;
-    Delta >>= 7;
-    Payload.front() = Delta ? Encoding | 0x80 : Encoding;
-    Payload = Payload.drop_front();
-  } while (Delta != 0);
-  return true;
+/// Appends the low Width bits of Value to the bit stream in Payload, of which
+/// BitSize bits are used.
+void appendBits(uint32_t Value, unsigned Width, std::vector<uint32_t> &Payload,
+                size_t &BitSize) {
+  if (BitSize % 32 == 0)
+    Payload.push_back(0);
+  Payload.back() |= Value << (BitSize % 32);
+  unsigned Written = 32 - BitSize % 32;
+  if (Written < Width)
+    Payload.push_back(Value >> Written);
+  BitSize += Width;
 }
 
-/// Use Variable-length Byte (VByte) delta encoding to compress sorted list of
-/// DocIDs. The compression stores deltas (differences) between subsequent
-/// DocIDs and encodes these deltas utilizing the least possible number of
-/// bytes.
+/// Use frame of reference encoding to compress sorted list of DocIDs. The list
+/// is split into blocks of Block::Size DocIDs, and the gaps between subsequent
+/// DocIDs of a block are packed using as many bits as the largest one needs.
+/// Gaps are at least one, and are stored minus one: runs of consecutive DocIDs
+/// take no payload at all.
 ///
-/// Each encoding byte consists of two parts: the first bit (continuation bit)
-/// indicates whether this is the last byte (0 if this byte is the last) of
-/// current encoding and seven bytes a piece of DocID (payload). DocID contains
-/// 32 bits and therefore it takes up to 5 bytes to encode it (4 full 7-bit
-/// payloads and one 4-bit payload), but in practice it is expected that gaps
-/// (deltas) between subsequent DocIDs are not large enough to require 5 bytes.
-/// In very dense posting lists (with average gaps less than 128) this
-/// representation would be 4 times more efficient than raw DocID array.
+/// Fixed-width gaps are larger than variable length ones when their sizes vary
+/// wildly within a block, but they decode without branches, and the block
+/// heads allow skipping over whole blocks without decoding them.
 ///
-/// PostingList encoding example:
+/// PostingList encoding example (Width = 13):
 ///
-/// DocIDs    42            47        7000
-/// gaps                    5         6958
-/// Encoding  (raw number)  00000101  10110110 00101110
-std::vector<Chunk> encodeStream(llvm::ArrayRef<DocID> Documents) {
+/// DocIDs    42            47             7000
+/// gaps - 1                4              6952
+/// Encoding  (raw number)  0000000000100  1101100101000
+void encodeStream(llvm::ArrayRef<DocID> Documents, std::vector<Block> &Blocks,
+                  std::vector<uint32_t> &Payload) {
   assert(!Documents.empty() && "Can't encode empty sequence.");
-  std::vector<Chunk> Result;
-  Result.emplace_back();
-  DocID Last = Result.back().Head = Documents.front();
-  llvm::MutableArrayRef<uint8_t> RemainingPayload = Result.back().Payload;
-  for (DocID Doc : Documents.drop_front()) {
-    if (!encodeVByte(Doc - Last, RemainingPayload)) { // didn't fit, flush chunk
-      Result.emplace_back();
-      Result.back().Head = Doc;
-      RemainingPayload = Result.back().Payload;
+  size_t BitSize = 0;
+  for (size_t Begin = 0; Begin < Documents.size(); Begin += Block::Size) {
+    auto Docs = Documents.slice(Begin).take_front(Block::Size);
+    uint32_t MaxGap = 0;
+    for (size_t I = 1; I < Docs.size(); ++I) {
+      assert(Docs[I] > Docs[I - 1] && "DocIDs must be sorted and unique.");
+      MaxGap = std::max(MaxGap, Docs[I] - Docs[I - 1] - 1);
     }
-    Last = Doc;
+    // Start each block on a word boundary.
+    BitSize = llvm::alignTo(BitSize, 32);
+    Block B;
+    B.Head = Docs.front();
+    B.Offset = BitSize / 32;
+    B.Width = MaxGap ? llvm::Log2_32(MaxGap) + 1 : 0;
+    B.Last = Docs.size() - 1;
+    if (B.Width)
+      for (size_t I = 1; I < Docs.size(); ++I)
+        appendBits(Docs[I] - Docs[I - 1] - 1, B.Width, Payload, BitSize);
+    Blocks.push_back(B);
   }
-  return std::vector<Chunk>(Result); // no move, shrink-to-fit
-}
-
-/// Reads variable length DocID from the buffer and updates the buffer size. If
-/// the stream is terminated, return None.
-llvm::Optional<DocID> readVByte(llvm::ArrayRef<uint8_t> &Bytes) {
-  if (Bytes.front() == 0 || Bytes.empty())
-    return None;
-  DocID Result = 0;
-  bool HasNextByte = true;
-  for (size_t Length = 0; HasNextByte && !Bytes.empty(); ++Length) {
-    assert(Length <= 5 && "Malformed VByte encoding sequence.");
-    // Write meaningful bits to the correct place in the document decoding.
-    Result |= (Bytes.front() & 0x7f) << (BitsPerEncodingByte * Length);
-    if ((Bytes.front() & 0x80) == 0)
-      HasNextByte = false;
-    Bytes = Bytes.drop_front();
-  }
-  return Result;
+  // Padding for the 64-bit reads of decompress().
+  Payload.push_back(0);
+  Blocks.shrink_to_fit();
+  Payload.shrink_to_fit();
 }
 
 } // namespace
 
-llvm::SmallVector<DocID, Chunk::PayloadSize + 1> Chunk::decompress() const {
-  llvm::SmallVector<DocID, Chunk::PayloadSize + 1> Result{Head};
-  llvm::ArrayRef<uint8_t> Bytes(Payload);
-  DocID Delta;
-  for (DocID Current = Head; !Bytes.empty(); Current += Delta) {
-    auto MaybeDelta = readVByte(Bytes);
-    if (!MaybeDelta)
-      break;
-    Delta = *MaybeDelta;
-    Result.push_back(Current + Delta);
-  }
-  return llvm::SmallVector<DocID, Chunk::PayloadSize + 1>{Result};
+PostingList::PostingList(llvm::ArrayRef<DocID> Documents) {
+  encodeStream(Documents, Blocks, Payload);
 }
 
-PostingList::PostingList(llvm::ArrayRef<DocID> Documents)
-    : Chunks(encodeStream(Documents)) {}
-
 std::unique_ptr<Iterator> PostingList::iterator(const Token *Tok) const {
-  return std::make_unique<ChunkIterator>(Tok, Chunks);
+  return std::make_unique<BlockIterator>(Tok, Blocks, Payload);
 }
 
 } // namespace dex
@@ -13,10 +13,12 @@
 /// traversed in order using an iterator and are values for inverted index,
 /// which maps search tokens to corresponding posting lists.
 ///
-/// In order to decrease size of Index in-memory representation, Variable Byte
-/// Encoding (VByte) is used for PostingLists compression. An overview of VByte
-/// algorithm can be found in "Introduction to Information Retrieval" book:
-/// https://nlp.stanford.edu/IR-book/html/htmledition/variable-byte-codes-1.html
+/// In order to decrease size of Index in-memory representation, PostingLists
+/// are split into blocks of consecutive DocIDs, and the gaps between DocIDs of
+/// a block are bit-packed using the width of the largest one (frame of
+/// reference encoding). Blocks have a fixed number of entries, which keeps
+/// decoding branch-free and lets it use SIMD where available; the first DocID
+/// of each block is stored uncompressed and serves as a skip pointer.
 ///
 //===----------------------------------------------------------------------===//
 
@@ -25,7 +27,6 @@
 
 #include "Iterator.h"
 #include "llvm/ADT/ArrayRef.h"
-#include "llvm/ADT/SmallVector.h"
 #include <cstdint>
 #include <vector>
 
@@ -36,40 +37,48 @@ class Token;
 
 /// NOTE: This is an implementation detail.
 ///
-/// Chunk is a fixed-width piece of PostingList which contains the first DocID
-/// in uncompressed format (Head) and delta-encoded Payload. It can be
-/// decompressed upon request.
-struct Chunk {
-  /// Keep sizeof(Chunk) == 32.
-  static constexpr size_t PayloadSize = 32 - sizeof(DocID);
+/// Block is a piece of PostingList which contains up to Size DocIDs: the first
+/// one in uncompressed format (Head), and the gaps to the following ones,
+/// minus one, packed into Width bits each. Packed gaps are stored in the
+/// payload of the PostingList, starting at word Offset. All blocks but the
+/// last one of a PostingList are full.
+struct Block {
+  static constexpr size_t Size = 64;
 
-  llvm::SmallVector<DocID, PayloadSize + 1> decompress() const;
-
-  /// The first element of decompressed Chunk.
+  /// The first DocID of the block.
   DocID Head;
-  /// VByte-encoded deltas.
-  std::array<uint8_t, PayloadSize> Payload;
+  /// Index of the first payload word holding packed gaps.
+  uint32_t Offset;
+  /// Number of bits of each packed gap, 0 if all DocIDs are consecutive.
+  uint8_t Width;
+  /// Number of DocIDs in the block, minus one.
+  uint8_t Last;
 };
-static_assert(sizeof(Chunk) == 32, "Chunk should take 32 bytes of memory.");
+static_assert(sizeof(Block) == 12, "Block should take 12 bytes of memory.");
 
 /// PostingList is the storage of DocIDs which can be inserted to the Query
 /// Tree as a leaf by constructing Iterator over the PostingList object. DocIDs
-/// are stored in underlying chunks. Compression saves memory at a small cost
+/// are stored in underlying blocks. Compression saves memory at a small cost
 /// in access time, which is still fast enough in practice.
 class PostingList {
 public:
   explicit PostingList(llvm::ArrayRef<DocID> Documents);
 
   /// Constructs DocumentIterator over given posting list. DocumentIterator will
-  /// go through the chunks and decompress them on-the-fly when necessary.
+  /// go through the blocks and decompress them on-the-fly when necessary.
   /// If given, Tok is only used for the string representation.
   std::unique_ptr<Iterator> iterator(const Token *Tok = nullptr) const;
 
   /// Returns in-memory size of external storage.
-  size_t bytes() const { return Chunks.capacity() * sizeof(Chunk); }
+  size_t bytes() const {
+    return Blocks.capacity() * sizeof(Block) +
+           Payload.capacity() * sizeof(uint32_t);
+  }
 
 private:
-  const std::vector<Chunk> Chunks;
+  std::vector<Block> Blocks;
+  /// Bit-packed gaps of all blocks.
+  std::vector<uint32_t> Payload;
 };
 
 } // namespace dex
@@ -386,7 +386,7 @@ opt<std::string> CheckFileLines{
     ValueOptional,
 };
 
-enum PCHStorageFlag { Disk, Memory };
+enum PCHStorageFlag { Disk, Memory, Shared };
 opt<PCHStorageFlag> PCHStorage{
     "pch-storage",
     cat(Misc),
@@ -394,10 +394,29 @@ opt<PCHStorageFlag> PCHStorage{
          "improve performance"),
     values(
         clEnumValN(PCHStorageFlag::Disk, "disk", "store PCHs on disk"),
-        clEnumValN(PCHStorageFlag::Memory, "memory", "store PCHs in memory")),
+        clEnumValN(PCHStorageFlag::Memory, "memory", "store PCHs in memory"),
+        clEnumValN(PCHStorageFlag::Shared, "shared",
+                   "map PCHs from a store shared with other clangd processes, "
+                   "see --pch-store-dir")),
     init(PCHStorageFlag::Disk),
 };
 
+opt<std::string> PCHStoreDir{
+    "pch-store-dir",
+    cat(Misc),
+    desc("Directory of the PCH store used by --pch-storage=shared. "
+         "Defaults to a clangd directory in the user's cache directory"),
+    init(""),
+};
+
+opt<unsigned> PCHStoreSizeMB{
+    "pch-store-size",
+    cat(Misc),
+    desc("Size budget of the PCH store in megabytes. Least recently used PCHs "
+         "are pruned beyond it, 0 means no limit"),
+    init(4096),
+};
+
 opt<bool> Sync{
     "sync",
     cat(Misc),
@@ -847,6 +866,23 @@ clangd accepts flags on the commandline, and in the CLANGD_FLAGS environment var
   case PCHStorageFlag::Disk:
     Opts.StorePreamblesInMemory = false;
     break;
+  case PCHStorageFlag::Shared: {
+    // Build in memory, the preamble is written out only if no other process
+    // has published an identical one already.
+    Opts.StorePreamblesInMemory = true;
+    llvm::SmallString<128> StoreDir(PCHStoreDir);
+    if (StoreDir.empty() && llvm::sys::path::cache_directory(StoreDir))
+      llvm::sys::path::append(StoreDir, "clangd", "preambles");
+    if (StoreDir.empty()) {
+      elog("Couldn't determine a directory for shared PCHs, keeping them in "
+           "memory");
+      break;
+    }
+    log("Sharing PCHs through {0}", StoreDir);
+    Opts.SharedPreambleDir = std::string(StoreDir);
+    Opts.SharedPreambleDirMaxBytes = uint64_t(PCHStoreSizeMB) * 1024 * 1024;
+    break;
+  }
   }
   if (!ResourceDir.empty())
     Opts.ResourceDir = ResourceDir;
@@ -68,6 +68,33 @@ TEST(DexIterators, DocumentIterator) {
   EXPECT_TRUE(DocIterator->reachedEnd());
 }
 
+TEST(DexIterators, DocumentIteratorAcrossBlocks) {
+  // Mix runs of consecutive DocIDs with small and large gaps, so that blocks
+  // get different bit widths.
+  std::vector<DocID> Docs;
+  DocID D = 3;
+  while (Docs.size() < 1000) {
+    Docs.push_back(D);
+    D += Docs.size() % 100 < 50 ? 1 : Docs.size() % 7 * 1000 + 1;
+  }
+  const PostingList L(Docs);
+
+  auto DocIterator = L.iterator();
+  EXPECT_EQ(DocIterator->estimateSize(), Docs.size());
+  EXPECT_THAT(consumeIDs(*DocIterator), testing::ElementsAreArray(Docs));
+
+  DocIterator = L.iterator();
+  for (size_t I = 0; I < Docs.size(); I += 97) {
+    DocIterator->advanceTo(Docs[I]);
+    EXPECT_EQ(DocIterator->peek(), Docs[I]);
+    DocIterator->advanceTo(Docs[I] + 1);
+    ASSERT_FALSE(DocIterator->reachedEnd());
+    EXPECT_EQ(DocIterator->peek(), Docs[I + 1]);
+  }
+  DocIterator->advanceTo(Docs.back() + 1);
+  EXPECT_TRUE(DocIterator->reachedEnd());
+}
+
 TEST(DexIterators, AndTwoLists) {
   Corpus C{10000};
   const PostingList L0({0, 5, 7, 10, 42, 320, 9000});
@@ -19,10 +19,13 @@
 #include "clang/Frontend/PrecompiledPreamble.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -567,6 +570,47 @@ TEST(PreamblePatch, NoopWhenNotRequested) {
                                             TU.inputs(FS), *BaselinePreamble);
   EXPECT_TRUE(PP.text().empty());
 }
+
+TEST(SharedPreambleStore, IdenticalPreamblesShareAFile) {
+  llvm::SmallString<256> StoreDir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("preamble-store", StoreDir));
+  auto CleanDir = llvm::make_scope_exit(
+      [&] { llvm::sys::fs::remove_directories(StoreDir); });
+  SharedPreambleStore Store;
+  Store.Directory = std::string(StoreDir);
+
+  MockFS FS;
+  IgnoreDiagnostics Diags;
+  auto TU = TestTU::withCode(R"cpp(
+    #include "a.h"
+    int y = x;
+  )cpp");
+  TU.AdditionalFiles["a.h"] = "int x;";
+  auto PI = TU.inputs(FS);
+  auto Build = [&] {
+    return buildPreamble(TU.Filename, *buildCompilerInvocation(PI, Diags), PI,
+                         /*StoreInMemory=*/true, nullptr, &Store);
+  };
+  auto First = Build();
+  auto Second = Build();
+  ASSERT_TRUE(First && Second);
+
+  // Both preambles are mapped from the same file.
+  std::vector<std::string> Files;
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator I(StoreDir, EC), E; !EC && I != E;
+       I.increment(EC))
+    Files.push_back(llvm::sys::path::filename(I->path()).str());
+  EXPECT_THAT(Files, ElementsAre(MatchesRegex(
+                         "llvmcache-preamble-[0-9a-f]{40}\\.pch")));
+  EXPECT_EQ(First->Preamble.getSize(), Second->Preamble.getSize());
+
+  // The mapped preamble is usable.
+  auto AST = ParsedAST::build(testPath(TU.Filename), PI,
+                              buildCompilerInvocation(PI, Diags), {}, Second);
+  ASSERT_TRUE(AST);
+  EXPECT_THAT(*AST->getDiagnostics(), testing::IsEmpty());
+}
 } // namespace
 } // namespace clangd
 } // namespace clang
@@ -0,0 +1,3 @@
+struct H {
+  H(int);
+};
@@ -0,0 +1,10 @@
+#include "header.h"
+
+struct T {
+  T(int);
+};
+
+void g() {
+  int *q = 0;
+  (void)q;
+}
@@ -0,0 +1,36 @@
+// RUN: clang-tidy %S/Inputs/parallel/second.cpp %s -checks='-*,clang-diagnostic-unused-variable,cert-err09-cpp,cert-err61-cpp,google-explicit-constructor,modernize-use-nullptr' \
+// RUN:   -header-filter='header\.h' -- -fexceptions -Wunused-variable | FileCheck %s --check-prefixes=CHECK,SECOND --implicit-check-not='warning:'
+// RUN: clang-tidy %S/Inputs/parallel/second.cpp %s -checks='-*,clang-diagnostic-unused-variable,cert-err09-cpp,cert-err61-cpp,google-explicit-constructor,modernize-use-nullptr' \
+// RUN:   -header-filter='header\.h' -parallel-checks=3 -- -fexceptions -Wunused-variable | FileCheck %s --check-prefixes=CHECK,SECOND --implicit-check-not='warning:'
+// RUN: clang-tidy %s -checks='-*,clang-diagnostic-unused-variable,cert-err09-cpp,cert-err61-cpp,google-explicit-constructor,modernize-use-nullptr' \
+// RUN:   -header-filter='header\.h' -parallel-checks=3 -- -fexceptions -Wunused-variable | FileCheck %s --implicit-check-not='warning:'
+
+// Each diagnostic is reported once, in the same order as without partitions,
+// including the ones in a header included by several input files, whether
+// one or several input files are checked, and diagnostics of alias checks are
+// still merged.
+
+#include "Inputs/parallel/header.h"
+
+// CHECK: header.h:2:3: warning: single-argument constructors must be marked explicit {{.*}} [google-explicit-constructor]
+// SECOND: second.cpp:4:3: warning: single-argument constructors must be marked explicit {{.*}} [google-explicit-constructor]
+// SECOND: second.cpp:8:12: warning: use nullptr [modernize-use-nullptr]
+
+struct S {
+  S(int);
+  // CHECK: :[[@LINE-1]]:3: warning: single-argument constructors must be marked explicit {{.*}} [google-explicit-constructor]
+};
+
+void alwaysThrows() {
+  int ex = 42;
+  throw ex;
+  // CHECK: :[[@LINE-1]]:9: warning: throw expression should throw anonymous temporary values instead [cert-err09-cpp,cert-err61-cpp]
+}
+
+void f() {
+  int unused;
+  // CHECK: :[[@LINE-1]]:7: warning: unused variable 'unused' [clang-diagnostic-unused-variable]
+  int *p = 0;
+  // CHECK: :[[@LINE-1]]:12: warning: use nullptr [modernize-use-nullptr]
+  (void)p;
+}
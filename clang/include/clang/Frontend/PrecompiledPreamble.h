@@ -19,6 +19,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/AlignOf.h"
 #include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include <cstddef>
 #include <memory>
 #include <system_error>
@@ -127,6 +128,17 @@ public:
                         IntrusiveRefCntPtr<llvm::vfs::FileSystem> &VFS,
                         llvm::MemoryBuffer *MainFileBuffer) const;
 
+  /// Moves the PCH into \p StoreDir, a directory shared by the processes that
+  /// build preambles, and maps it read-only from there. The file is named
+  /// after the hash of its contents, so that identical preambles built by
+  /// different processes (e.g. several clangd instances working on the same
+  /// project) end up backed by the same pages in the OS page cache.
+  /// File names are compatible with llvm::pruneCache, which is how the store
+  /// is expected to be bounded. Already mapped preambles remain valid after
+  /// their file is pruned on platforms that allow removing mapped files.
+  /// On failure, the preamble keeps its current storage.
+  std::error_code moveToSharedStore(llvm::StringRef StoreDir);
+
 private:
   PrecompiledPreamble(PCHStorage Storage, std::vector<char> PreambleBytes,
                       bool PreambleEndsAtStartOfLine,
@@ -168,13 +180,20 @@ private:
     std::string Data;
   };
 
+  /// A PCH mapped from a file in a shared preamble store.
+  class MappedPreamble {
+  public:
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  };
+
   class PCHStorage {
   public:
-    enum class Kind { Empty, InMemory, TempFile };
+    enum class Kind { Empty, InMemory, TempFile, Mapped };
 
     PCHStorage() = default;
     PCHStorage(TempPCHFile File);
     PCHStorage(InMemoryPreamble Memory);
+    PCHStorage(MappedPreamble Mapped);
 
     PCHStorage(const PCHStorage &) = delete;
     PCHStorage &operator=(const PCHStorage &) = delete;
@@ -192,13 +211,17 @@ private:
     InMemoryPreamble &asMemory();
     const InMemoryPreamble &asMemory() const;
 
+    MappedPreamble &asMapped();
+    const MappedPreamble &asMapped() const;
+
   private:
     void destroy();
     void setEmpty();
 
   private:
     Kind StorageKind = Kind::Empty;
-    llvm::AlignedCharArrayUnion<TempPCHFile, InMemoryPreamble> Storage = {};
+    llvm::AlignedCharArrayUnion<TempPCHFile, InMemoryPreamble, MappedPreamble>
+        Storage = {};
   };
 
   /// Data used to determine if a file used in the preamble has been changed.
@@ -244,7 +267,7 @@ private:
                        PreprocessorOptions &PreprocessorOpts,
                        IntrusiveRefCntPtr<llvm::vfs::FileSystem> &VFS);
 
-  /// Manages the memory buffer or temporary file that stores the PCH.
+  /// Manages the memory buffer, temporary or shared file that stores the PCH.
   PCHStorage Storage;
   /// Keeps track of the files that were used when computing the
   /// preamble, with both their buffer size and their modification time.
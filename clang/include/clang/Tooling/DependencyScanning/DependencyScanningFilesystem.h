@@ -16,6 +16,7 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/VirtualFileSystem.h"
+#include <array>
 #include <mutex>
 
 namespace clang {
@@ -144,6 +145,45 @@ private:
   CachedFileContents *Contents;
 };
 
+/// This class is an on-disk cache of minimized file contents. Unlike the other
+/// caches, it outlives the dependency scanning service, so that subsequent
+/// scans only need to minimize the files that changed in the meantime.
+///
+/// Entries are keyed by the SHA1 of the original contents and a hash of the
+/// compiler version, and are named so that the directory can be managed with
+/// llvm::pruneCache. Each entry also records the SHA1 and size of the original
+/// contents, which are checked on lookup. Reading and writing entries is
+/// best-effort: any failure results in the file being minimized again.
+class DependencyScanningPersistentCache {
+public:
+  explicit DependencyScanningPersistentCache(StringRef Directory);
+
+  struct MinimizedContents {
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    PreprocessorSkippedRangeMapping PPSkippedRangeMapping;
+  };
+
+  /// \returns The minimized contents of the file with the given original
+  /// contents, if they were stored before.
+  Optional<MinimizedContents> lookup(StringRef Original) const;
+
+  /// Stores the minimized contents of the file with the given original
+  /// contents.
+  void store(StringRef Original, StringRef Minimized,
+             const PreprocessorSkippedRangeMapping &Mapping) const;
+
+  StringRef getDirectory() const { return Directory; }
+
+private:
+  using ContentHash = std::array<uint8_t, 20>;
+
+  std::string getEntryPath(const ContentHash &Hash) const;
+
+  std::string Directory;
+  /// Hash of the compiler version, which determines the minimizer's output.
+  std::string VersionHash;
+};
+
 /// This class is a shared cache, that caches the 'stat' and 'open' calls to the
 /// underlying real file system. It distinguishes between minimized and original
 /// files.
@@ -198,15 +238,24 @@ public:
                                 const CachedFileSystemEntry &Entry);
   };
 
-  DependencyScanningFilesystemSharedCache();
+  /// If \p PersistentCacheDir is not empty, minimized contents are also
+  /// cached on disk in that directory.
+  explicit DependencyScanningFilesystemSharedCache(
+      StringRef PersistentCacheDir = "");
 
   /// Returns shard for the given key.
   CacheShard &getShardForFilename(StringRef Filename) const;
   CacheShard &getShardForUID(llvm::sys::fs::UniqueID UID) const;
 
+  /// Returns the on-disk cache of minimized contents, if any.
+  const DependencyScanningPersistentCache *getPersistentCache() const {
+    return PersistentCache.get();
+  }
+
 private:
   std::unique_ptr<CacheShard[]> CacheShards;
   unsigned NumShards;
+  std::unique_ptr<DependencyScanningPersistentCache> PersistentCache;
 };
 
 /// This class is a local cache, that caches the 'stat' and 'open' calls to the
@@ -46,10 +46,13 @@ enum class ScanningOutputFormat {
 /// the invidual dependency scanning workers.
 class DependencyScanningService {
 public:
+  /// If \p PersistentCacheDir is not empty, minimized file contents are cached
+  /// in that directory across services, see DependencyScanningPersistentCache.
   DependencyScanningService(ScanningMode Mode, ScanningOutputFormat Format,
                             bool ReuseFileManager = true,
                             bool SkipExcludedPPRanges = true,
-                            bool OptimizeArgs = false);
+                            bool OptimizeArgs = false,
+                            StringRef PersistentCacheDir = "");
 
   ScanningMode getMode() const { return Mode; }
 
@@ -11628,8 +11628,19 @@ bool ASTContext::DeclMustBeEmitted(const Decl *D) {
     return false;
 
   // Variables that have destruction with side-effects are required.
-  if (VD->needsDestruction(*this))
-    return true;
+  // Unregistering a reducer has none of its own: it only matters to the code
+  // that uses the reducer, which emits it on demand. Not requiring these
+  // variables also keeps them out of the eagerly deserialized declarations
+  // and module initializers of PCHs and modules.
+  if (QualType::DestructionKind DK = VD->needsDestruction(*this)) {
+    if (DK != QualType::DK_hyperobject)
+      return true;
+    if (VD->getType()
+            ->castAs<HyperobjectType>()
+            ->getElementType()
+            .isDestructedType())
+      return true;
+  }
 
   // Variables that have initialization with side-effects are required.
   if (VD->getInit() && VD->getInit()->HasSideEffects(*this) &&
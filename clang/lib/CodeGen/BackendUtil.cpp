@@ -1694,6 +1694,14 @@ void EmitAssemblyHelper::RunOptimizationPipeline(
             MPM.addPass(CilkSanitizerPass());
             PassBuilder::addPostCilkInstrumentationPipeline(MPM, Level);
           });
+    // Record the spawn sites of Tapir tasks for the memory profiler before the
+    // tasks are outlined.
+    if (!CodeGenOpts.MemoryProfileOutput.empty() && TLII->hasTapirTarget())
+      PB.registerTapirLateEPCallback(
+          [](ModulePassManager &MPM, OptimizationLevel Level) {
+            MPM.addPass(
+                createModuleToFunctionPassAdaptor(MemProfTaskSitesPass()));
+          });
     // Register CSI instrumentation for Cilkscale
     if (LangOpts.getCilktool() != LangOptions::CilktoolKind::Cilktool_None) {
       switch (LangOpts.getCilktool()) {
@@ -31,8 +31,10 @@
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/VirtualFileSystem.h"
 #include <limits>
 #include <mutex>
@@ -482,6 +484,8 @@ std::size_t PrecompiledPreamble::getSize() const {
     return 0;
   case PCHStorage::Kind::InMemory:
     return Storage.asMemory().Data.size();
+  case PCHStorage::Kind::Mapped:
+    return Storage.asMapped().Buffer->getBufferSize();
   case PCHStorage::Kind::TempFile: {
     uint64_t Result;
     if (llvm::sys::fs::file_size(Storage.asFile().getFilePath(), Result))
@@ -620,6 +624,65 @@ void PrecompiledPreamble::OverridePreamble(
   configurePreamble(Bounds, CI, VFS, MainFileBuffer);
 }
 
+std::error_code PrecompiledPreamble::moveToSharedStore(StringRef StoreDir) {
+  std::unique_ptr<llvm::MemoryBuffer> FileContents;
+  StringRef Contents;
+  switch (Storage.getKind()) {
+  case PCHStorage::Kind::Empty:
+    llvm_unreachable("Sharing an invalid PrecompiledPreamble");
+  case PCHStorage::Kind::Mapped:
+    return std::error_code();
+  case PCHStorage::Kind::InMemory:
+    Contents = Storage.asMemory().Data;
+    break;
+  case PCHStorage::Kind::TempFile: {
+    auto Buf = llvm::MemoryBuffer::getFile(Storage.asFile().getFilePath());
+    if (!Buf)
+      return Buf.getError();
+    FileContents = std::move(*Buf);
+    Contents = FileContents->getBuffer();
+    break;
+  }
+  }
+
+  // Name the file after its contents: a preamble PCH depends on the compile
+  // command and on the contents of every header it includes, all of which end
+  // up in the PCH itself, so equal hashes mean interchangeable preambles.
+  llvm::SmallString<128> Path(StoreDir);
+  llvm::sys::path::append(
+      Path, "llvmcache-preamble-" +
+                llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(
+                                Contents)),
+                            /*LowerCase=*/true) +
+                ".pch");
+
+  if (std::error_code EC = llvm::sys::fs::create_directories(StoreDir))
+    return EC;
+  int FD;
+  if (!llvm::sys::fs::openFileForRead(Path, FD)) {
+    // Another process published this preamble already. Bump its timestamps so
+    // that pruning treats it as recently used.
+    llvm::sys::fs::setLastAccessAndModificationTime(
+        FD, std::chrono::system_clock::now());
+    llvm::sys::Process::SafelyCloseFileDescriptor(FD);
+  } else if (llvm::Error Err = llvm::writeFileAtomically(
+                 (Twine(Path) + ".tmp%%%%%%%%").str(), Path, Contents)) {
+    return llvm::errorToErrorCode(std::move(Err));
+  }
+
+  // The reader expects null-terminated PCH buffers; MemoryBuffer maps the
+  // file unless its size is a multiple of the page size.
+  auto Mapped = llvm::MemoryBuffer::getFile(Path, /*IsText=*/false,
+                                            /*RequiresNullTerminator=*/true);
+  if (!Mapped)
+    return Mapped.getError();
+  if ((*Mapped)->getBuffer() != Contents)
+    return std::make_error_code(std::errc::io_error);
+
+  Storage = PCHStorage(MappedPreamble{std::move(*Mapped)});
+  return std::error_code();
+}
+
 PrecompiledPreamble::PrecompiledPreamble(
     PCHStorage Storage, std::vector<char> PreambleBytes,
     bool PreambleEndsAtStartOfLine,
@@ -696,6 +759,11 @@ PrecompiledPreamble::PCHStorage::PCHStorage(InMemoryPreamble Memory)
   new (&asMemory()) InMemoryPreamble(std::move(Memory));
 }
 
+PrecompiledPreamble::PCHStorage::PCHStorage(MappedPreamble Mapped)
+    : StorageKind(Kind::Mapped) {
+  new (&asMapped()) MappedPreamble(std::move(Mapped));
+}
+
 PrecompiledPreamble::PCHStorage::PCHStorage(PCHStorage &&Other) : PCHStorage() {
   *this = std::move(Other);
 }
@@ -715,6 +783,9 @@ operator=(PCHStorage &&Other) {
   case Kind::InMemory:
     new (&asMemory()) InMemoryPreamble(std::move(Other.asMemory()));
     break;
+  case Kind::Mapped:
+    new (&asMapped()) MappedPreamble(std::move(Other.asMapped()));
+    break;
   }
 
   Other.setEmpty();
@@ -749,6 +820,17 @@ PrecompiledPreamble::PCHStorage::asMemory() const {
   return const_cast<PCHStorage *>(this)->asMemory();
 }
 
+PrecompiledPreamble::MappedPreamble &
+PrecompiledPreamble::PCHStorage::asMapped() {
+  assert(getKind() == Kind::Mapped);
+  return *reinterpret_cast<MappedPreamble *>(&Storage);
+}
+
+const PrecompiledPreamble::MappedPreamble &
+PrecompiledPreamble::PCHStorage::asMapped() const {
+  return const_cast<PCHStorage *>(this)->asMapped();
+}
+
 void PrecompiledPreamble::PCHStorage::destroy() {
   switch (StorageKind) {
   case Kind::Empty:
@@ -759,6 +841,9 @@ void PrecompiledPreamble::PCHStorage::destroy() {
   case Kind::InMemory:
     asMemory().~InMemoryPreamble();
     return;
+  case Kind::Mapped:
+    asMapped().~MappedPreamble();
+    return;
   }
 }
 
@@ -838,13 +923,20 @@ void PrecompiledPreamble::setupPreambleStorage(
     // read files, but the PCH was generated in the real file system.
     VFS = createVFSOverlayForPreamblePCH(PCHPath, std::move(*Buf), VFS);
   } else {
-    assert(Storage.getKind() == PCHStorage::Kind::InMemory);
-    // For in-memory preamble, we have to provide a VFS overlay that makes it
-    // accessible.
+    // For in-memory and mapped preambles, we have to provide a VFS overlay
+    // that makes them accessible. Mapped preambles are exposed under the
+    // in-memory path too, as they were built there.
     StringRef PCHPath = getInMemoryPreamblePath();
     PreprocessorOpts.ImplicitPCHInclude = std::string(PCHPath);
 
-    auto Buf = llvm::MemoryBuffer::getMemBuffer(Storage.asMemory().Data);
+    std::unique_ptr<llvm::MemoryBuffer> Buf;
+    if (Storage.getKind() == PCHStorage::Kind::Mapped) {
+      Buf = llvm::MemoryBuffer::getMemBuffer(
+          Storage.asMapped().Buffer->getMemBufferRef());
+    } else {
+      assert(Storage.getKind() == PCHStorage::Kind::InMemory);
+      Buf = llvm::MemoryBuffer::getMemBuffer(Storage.asMemory().Data);
+    }
     VFS = createVFSOverlayForPreamblePCH(PCHPath, std::move(Buf), VFS);
   }
 }
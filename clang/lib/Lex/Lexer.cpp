@@ -47,6 +47,15 @@
 #include <tuple>
 #include <utility>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -70,6 +79,134 @@ tok::ObjCKeywordKind Token::getObjCKeywordID() const {
   return specId ? specId->getObjCKeywordID() : tok::objc_not_keyword;
 }
 
+//===----------------------------------------------------------------------===//
+// Vectorized Scanning
+//===----------------------------------------------------------------------===//
+
+// The scanners below skip runs of uninteresting characters 16 bytes at a time,
+// and finish byte by byte.  They never read past BufferEnd, and rely on the
+// buffer being null terminated to stop the byte-by-byte loops.
+#if defined(__SSE2__) ||                                                       \
+    (defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define LEXER_HAS_VECTOR_SCAN 1
+
+#ifdef __SSE2__
+using ByteVector = __m128i;
+
+static ByteVector loadBytes(const char *Ptr) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+}
+static ByteVector bytesEqual(ByteVector V, char C) {
+  return _mm_cmpeq_epi8(V, _mm_set1_epi8(C));
+}
+/// Matches the bytes of \p V in the range [Lo, Hi].
+static ByteVector bytesInRange(ByteVector V, char Lo, char Hi) {
+  ByteVector Offset = _mm_sub_epi8(V, _mm_set1_epi8(Lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(Offset, _mm_set1_epi8(Hi - Lo)), Offset);
+}
+static ByteVector orBytes(ByteVector A, ByteVector B) {
+  return _mm_or_si128(A, B);
+}
+static ByteVector orBytes(ByteVector V, char C) {
+  return _mm_or_si128(V, _mm_set1_epi8(C));
+}
+/// Returns the index of the first byte of \p Matches that is not all ones, or
+/// 16 if there is none.
+static unsigned countLeadingMatches(ByteVector Matches) {
+  unsigned Mask = ~_mm_movemask_epi8(Matches) & 0xFFFF;
+  return Mask ? llvm::countTrailingZeros(Mask) : 16;
+}
+#else
+using ByteVector = uint8x16_t;
+
+static ByteVector loadBytes(const char *Ptr) {
+  return vld1q_u8(reinterpret_cast<const uint8_t *>(Ptr));
+}
+static ByteVector bytesEqual(ByteVector V, char C) {
+  return vceqq_u8(V, vdupq_n_u8(C));
+}
+/// Matches the bytes of \p V in the range [Lo, Hi].
+static ByteVector bytesInRange(ByteVector V, char Lo, char Hi) {
+  return vcleq_u8(vsubq_u8(V, vdupq_n_u8(Lo)), vdupq_n_u8(Hi - Lo));
+}
+static ByteVector orBytes(ByteVector A, ByteVector B) {
+  return vorrq_u8(A, B);
+}
+static ByteVector orBytes(ByteVector V, char C) {
+  return vorrq_u8(V, vdupq_n_u8(C));
+}
+/// Returns the index of the first byte of \p Matches that is not all ones, or
+/// 16 if there is none.
+static unsigned countLeadingMatches(ByteVector Matches) {
+  // Narrow each byte to 4 bits, since NEON has no equivalent to movemask.
+  uint64_t Mask = ~vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4)), 0);
+  return Mask ? llvm::countTrailingZeros(Mask) / 4 : 16;
+}
+#endif
+#endif
+
+/// Return the first character at or after \p CurPtr that does not match
+/// [_A-Za-z0-9].
+static const char *skipAsciiIdentifierContinue(const char *CurPtr,
+                                               const char *BufferEnd) {
+#ifdef LEXER_HAS_VECTOR_SCAN
+  while (CurPtr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(CurPtr);
+    unsigned N = countLeadingMatches(
+        orBytes(orBytes(bytesInRange(orBytes(V, 0x20), 'a', 'z'),
+                        bytesInRange(V, '0', '9')),
+                bytesEqual(V, '_')));
+    CurPtr += N;
+    if (N != 16)
+      return CurPtr;
+  }
+#endif
+  while (isAsciiIdentifierContinue(*CurPtr))
+    ++CurPtr;
+  return CurPtr;
+}
+
+/// Return the first character at or after \p CurPtr that is not horizontal
+/// whitespace.
+static const char *skipHorizontalWhitespace(const char *CurPtr,
+                                            const char *BufferEnd) {
+#ifdef LEXER_HAS_VECTOR_SCAN
+  while (CurPtr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(CurPtr);
+    unsigned N = countLeadingMatches(
+        orBytes(orBytes(bytesEqual(V, ' '), bytesEqual(V, '\t')),
+                orBytes(bytesEqual(V, '\f'), bytesEqual(V, '\v'))));
+    CurPtr += N;
+    if (N != 16)
+      return CurPtr;
+  }
+#endif
+  while (isHorizontalWhitespace(*CurPtr))
+    ++CurPtr;
+  return CurPtr;
+}
+
+/// Return the first newline or null character at or after \p CurPtr.
+static const char *findNewlineOrNull(const char *CurPtr,
+                                     const char *BufferEnd) {
+#ifdef LEXER_HAS_VECTOR_SCAN
+  while (CurPtr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(CurPtr);
+    // Invert the sense of the comparison by matching everything else.
+    ByteVector Stop = orBytes(
+        orBytes(bytesEqual(V, '\n'), bytesEqual(V, '\r')), bytesEqual(V, 0));
+    unsigned N = countLeadingMatches(bytesEqual(Stop, 0));
+    CurPtr += N;
+    if (N != 16)
+      return CurPtr;
+  }
+#endif
+  while (*CurPtr != 0 && *CurPtr != '\n' && *CurPtr != '\r')
+    ++CurPtr;
+  return CurPtr;
+}
+
 //===----------------------------------------------------------------------===//
 // Lexer Class Implementation
 //===----------------------------------------------------------------------===//
@@ -1764,7 +1901,7 @@ bool Lexer::LexIdentifierContinue(Token &Result, const char *CurPtr) {
     unsigned char C = *CurPtr;
     // Fast path.
     if (isAsciiIdentifierContinue(C)) {
-      ++CurPtr;
+      CurPtr = skipAsciiIdentifierContinue(CurPtr + 1, BufferEnd);
       continue;
     }
 
@@ -2317,8 +2454,10 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Skip consecutive spaces efficiently.
   while (true) {
     // Skip horizontal whitespace very aggressively.
-    while (isHorizontalWhitespace(Char))
-      Char = *++CurPtr;
+    if (isHorizontalWhitespace(Char)) {
+      CurPtr = skipHorizontalWhitespace(CurPtr + 1, BufferEnd);
+      Char = *CurPtr;
+    }
 
     // Otherwise if we have something other than whitespace, we're done.
     if (!isVerticalWhitespace(Char))
@@ -2395,11 +2534,10 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // character that ends the line comment.
   char C;
   while (true) {
+    // Skip over characters in the fast loop, stopping at a potential EOF, a
+    // newline or a DOS-style newline.
+    CurPtr = findNewlineOrNull(CurPtr, BufferEnd);
     C = *CurPtr;
-    // Skip over characters in the fast loop.
-    while (C != 0 &&                // Potentially EOF.
-           C != '\n' && C != '\r')  // Newline or DOS-style newline.
-      C = *++CurPtr;
 
     const char *NextLine = CurPtr;
     if (C != 0) {
@@ -2616,13 +2754,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -3325,9 +3456,7 @@ LexNextToken:
 
   // Small amounts of horizontal whitespace is very common between tokens.
   if (isHorizontalWhitespace(*CurPtr)) {
-    do {
-      ++CurPtr;
-    } while (isHorizontalWhitespace(*CurPtr));
+    CurPtr = skipHorizontalWhitespace(CurPtr + 1, BufferEnd);
 
     // If we are keeping whitespace and other tokens, just return what we just
     // skipped.  The next lexer invocation will return the token after the
@@ -17,10 +17,12 @@
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/EvaluatedExprVisitor.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/ExprCilk.h"
 #include "clang/AST/ExprObjC.h"
 #include "clang/AST/ParentMap.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/AST/StmtCXX.h"
+#include "clang/AST/StmtCilk.h"
 #include "clang/AST/StmtObjC.h"
 #include "clang/AST/StmtVisitor.h"
 #include "clang/Analysis/Analyses/CFGReachabilityAnalysis.h"
@@ -44,9 +46,11 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CheckedArithmetic.h"
 #include <algorithm>
 #include <deque>
 #include <iterator>
+#include <limits>
 
 using namespace clang;
 
@@ -2140,6 +2144,309 @@ public:
 } // namespace consumed
 } // namespace clang
 
+//===----------------------------------------------------------------------===//
+// -Wcilk-performance: Check for parallel constructs that cost more than they
+// gain.
+//===----------------------------------------------------------------------===//
+
+/// Heuristic bounds for the Cilk performance checks.  A spawn or a cilk_for
+/// iteration costs on the order of a few dozen instructions, so statements
+/// with fewer nodes than TrivialStmtBudget are assumed to be cheaper than the
+/// parallel construct running them.
+static const unsigned TrivialStmtBudget = 24;
+static const int64_t SmallCilkForTripCount = 128;
+
+/// Returns true if S is straight-line code with no calls, loops or parallel
+/// constructs, and at most Budget statements and expressions in total.
+static bool isTrivialStmt(const Stmt *S, unsigned &Budget) {
+  if (!S)
+    return true;
+  if (Budget == 0)
+    return false;
+  --Budget;
+  switch (S->getStmtClass()) {
+  case Stmt::CallExprClass:
+  case Stmt::CXXMemberCallExprClass:
+  case Stmt::CXXOperatorCallExprClass:
+  case Stmt::CXXConstructExprClass:
+  case Stmt::CXXTemporaryObjectExprClass:
+  case Stmt::CXXNewExprClass:
+  case Stmt::CXXDeleteExprClass:
+  case Stmt::CXXThrowExprClass:
+  case Stmt::ForStmtClass:
+  case Stmt::WhileStmtClass:
+  case Stmt::DoStmtClass:
+  case Stmt::CXXForRangeStmtClass:
+  case Stmt::GotoStmtClass:
+  case Stmt::IndirectGotoStmtClass:
+  case Stmt::GCCAsmStmtClass:
+  case Stmt::MSAsmStmtClass:
+  case Stmt::CilkSpawnStmtClass:
+  case Stmt::CilkSpawnExprClass:
+  case Stmt::CilkSyncStmtClass:
+  case Stmt::CilkForStmtClass:
+  case Stmt::CilkScopeStmtClass:
+    return false;
+  default:
+    break;
+  }
+  for (const Stmt *Child : S->children())
+    if (!isTrivialStmt(Child, Budget))
+      return false;
+  return true;
+}
+
+static bool isTrivialStmt(const Stmt *S) {
+  unsigned Budget = TrivialStmtBudget;
+  return isTrivialStmt(S, Budget);
+}
+
+/// Folds the trip count of a cilk_for from the initializer of its __end
+/// variable, looking through the implicit __init and __limit variables Sema
+/// introduces for the loop bounds.
+static Optional<int64_t> evaluateCilkForTripCount(const Expr *E,
+                                                  const ASTContext &Ctx) {
+  E = E->IgnoreParenImpCasts();
+  Expr::EvalResult Result;
+  if (E->EvaluateAsInt(Result, Ctx)) {
+    const llvm::APSInt &Val = Result.Val.getInt();
+    if (Val.isSigned() ? Val.getMinSignedBits() > 64 : Val.getActiveBits() > 63)
+      return None;
+    return Val.getExtValue();
+  }
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    if (VD && VD->isImplicit() && VD->getInit())
+      return evaluateCilkForTripCount(VD->getInit(), Ctx);
+    return None;
+  }
+
+  const auto *BO = dyn_cast<BinaryOperator>(E);
+  if (!BO)
+    return None;
+  Optional<int64_t> LHS = evaluateCilkForTripCount(BO->getLHS(), Ctx);
+  if (!LHS)
+    return None;
+  Optional<int64_t> RHS = evaluateCilkForTripCount(BO->getRHS(), Ctx);
+  if (!RHS)
+    return None;
+  switch (BO->getOpcode()) {
+  case BO_Add:
+    return llvm::checkedAdd(*LHS, *RHS);
+  case BO_Sub:
+    return llvm::checkedSub(*LHS, *RHS);
+  case BO_Div:
+    if (*RHS == 0 ||
+        (*LHS == std::numeric_limits<int64_t>::min() && *RHS == -1))
+      return None;
+    return *LHS / *RHS;
+  default:
+    return None;
+  }
+}
+
+/// Returns the hyperobject variable E refers to, looking through the view
+/// lookup Sema wraps around uses of hyperobjects.
+static const VarDecl *getReferencedHyperobject(const Expr *E) {
+  E = E->IgnoreParenImpCasts();
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    if (UO->getOpcode() != UO_Deref)
+      return nullptr;
+    const auto *Lookup =
+        dyn_cast<CallExpr>(UO->getSubExpr()->IgnoreParenCasts());
+    if (!Lookup || Lookup->getBuiltinCallee() != Builtin::BI__hyper_lookup ||
+        Lookup->getNumArgs() != 1)
+      return nullptr;
+    E = Lookup->getArg(0)->IgnoreParenImpCasts();
+    if (const auto *AddrOf = dyn_cast<UnaryOperator>(E))
+      E = AddrOf->getSubExpr()->IgnoreParenImpCasts();
+    else if (const auto *AddrOf = dyn_cast<CallExpr>(E))
+      if (AddrOf->getBuiltinCallee() == Builtin::BI__builtin_addressof &&
+          AddrOf->getNumArgs() == 1)
+        E = AddrOf->getArg(0)->IgnoreParenImpCasts();
+  }
+  const auto *DRE = dyn_cast<DeclRefExpr>(E);
+  if (!DRE)
+    return nullptr;
+  const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  if (!VD || !VD->getType()->isHyperobjectType())
+    return nullptr;
+  return VD;
+}
+
+/// Returns the hyperobject variable if S, ignoring a surrounding compound
+/// statement, is a single update of a hyperobject with an operand that is
+/// trivial to compute.
+static const VarDecl *getSoleReducerUpdate(const Stmt *S) {
+  if (const auto *CS = dyn_cast<CompoundStmt>(S)) {
+    if (CS->size() != 1)
+      return nullptr;
+    S = CS->body_front();
+  }
+  const auto *E = dyn_cast<Expr>(S);
+  if (!E)
+    return nullptr;
+  E = E->IgnoreImplicit();
+
+  const Expr *Target = nullptr;
+  const Expr *Operand = nullptr;
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    if (!UO->isIncrementDecrementOp())
+      return nullptr;
+    Target = UO->getSubExpr();
+  } else if (const auto *CAO = dyn_cast<CompoundAssignOperator>(E)) {
+    Target = CAO->getLHS();
+    Operand = CAO->getRHS();
+  } else {
+    return nullptr;
+  }
+
+  const VarDecl *VD = getReferencedHyperobject(Target);
+  if (!VD || !isTrivialStmt(Operand))
+    return nullptr;
+  return VD;
+}
+
+namespace {
+/// Walks a function body looking for spawns of trivial functions, cilk_for
+/// loops with too little work per iteration, and syncs that serialize the
+/// iterations of a loop.
+class CilkPerformanceChecker {
+  Sema &S;
+
+  /// The loops enclosing the statement being visited.  A sync only limits
+  /// parallelism if the serial loop around it also spawns work.
+  struct LoopInfo {
+    bool IsParallel;
+    bool HasSpawn = false;
+    SmallVector<const CilkSyncStmt *, 2> Syncs;
+    explicit LoopInfo(bool IsParallel) : IsParallel(IsParallel) {}
+  };
+  SmallVector<LoopInfo, 4> Loops;
+
+public:
+  explicit CilkPerformanceChecker(Sema &S) : S(S) {}
+
+  void check(const Stmt *Body) { visit(Body); }
+
+private:
+  void visit(const Stmt *St) {
+    if (!St)
+      return;
+    // Lambdas, blocks and captured statements are analyzed on their own.
+    if (isa<LambdaExpr>(St) || isa<BlockExpr>(St) || isa<CapturedStmt>(St))
+      return;
+
+    switch (St->getStmtClass()) {
+    case Stmt::CilkSpawnStmtClass: {
+      const Stmt *Spawned = cast<CilkSpawnStmt>(St)->getSpawnedStmt();
+      if (const auto *E = dyn_cast<Expr>(Spawned))
+        checkSpawnedCall(E, St->getBeginLoc());
+      noteSpawn();
+      break;
+    }
+    case Stmt::CilkSpawnExprClass: {
+      const auto *CSE = cast<CilkSpawnExpr>(St);
+      checkSpawnedCall(CSE->getSpawnedExpr(), CSE->getSpawnLoc());
+      noteSpawn();
+      break;
+    }
+    case Stmt::CilkSyncStmtClass:
+      if (!Loops.empty())
+        Loops.back().Syncs.push_back(cast<CilkSyncStmt>(St));
+      break;
+    case Stmt::CilkForStmtClass:
+      checkCilkFor(cast<CilkForStmt>(St));
+      visitLoop(St, /*IsParallel=*/true);
+      return;
+    case Stmt::ForStmtClass:
+    case Stmt::WhileStmtClass:
+    case Stmt::DoStmtClass:
+    case Stmt::CXXForRangeStmtClass:
+      visitLoop(St, /*IsParallel=*/false);
+      return;
+    default:
+      break;
+    }
+
+    for (const Stmt *Child : St->children())
+      visit(Child);
+  }
+
+  void visitLoop(const Stmt *Loop, bool IsParallel) {
+    Loops.emplace_back(IsParallel);
+    for (const Stmt *Child : Loop->children())
+      visit(Child);
+    LoopInfo Info = Loops.pop_back_val();
+    if (Info.IsParallel)
+      return;
+    if (Info.HasSpawn) {
+      for (const CilkSyncStmt *Sync : Info.Syncs)
+        S.Diag(Sync->getSyncLoc(), diag::warn_cilk_sync_in_serial_loop);
+      noteSpawn();
+    }
+  }
+
+  /// Records a spawn in the innermost enclosing loop.  The spawns in the body
+  /// of a cilk_for are synced at the end of each iteration, so they do not
+  /// escape to the loops around it.
+  void noteSpawn() {
+    if (!Loops.empty())
+      Loops.back().HasSpawn = true;
+  }
+
+  void checkSpawnedCall(const Expr *E, SourceLocation SpawnLoc) {
+    const auto *CE = dyn_cast<CallExpr>(E->IgnoreImplicit());
+    if (!CE)
+      return;
+    const FunctionDecl *Callee = CE->getDirectCallee();
+    if (!Callee)
+      return;
+    if (const auto *MD = dyn_cast<CXXMethodDecl>(Callee))
+      if (MD->isVirtual())
+        return;
+    const FunctionDecl *Definition = nullptr;
+    if (!Callee->hasBody(Definition) || !isTrivialStmt(Definition->getBody()))
+      return;
+    S.Diag(SpawnLoc, diag::warn_cilk_spawn_trivial_callee)
+        << Callee << CE->getSourceRange();
+  }
+
+  void checkCilkFor(const CilkForStmt *CF) {
+    const Stmt *Body = CF->getBody();
+    if (!Body)
+      return;
+
+    if (const VarDecl *Reducer = getSoleReducerUpdate(Body)) {
+      S.Diag(CF->getBeginLoc(), diag::warn_cilk_for_reducer_only_body)
+          << Reducer << Body->getSourceRange();
+      return;
+    }
+
+    const DeclStmt *EndStmt = CF->getEndStmt();
+    if (!EndStmt || !EndStmt->isSingleDecl() || !isTrivialStmt(Body))
+      return;
+    const auto *EndVar = dyn_cast<VarDecl>(EndStmt->getSingleDecl());
+    if (!EndVar || !EndVar->getInit())
+      return;
+    Optional<int64_t> TripCount =
+        evaluateCilkForTripCount(EndVar->getInit(), S.getASTContext());
+    if (TripCount && *TripCount > 0 && *TripCount < SmallCilkForTripCount)
+      S.Diag(CF->getBeginLoc(), diag::warn_cilk_for_small_body)
+          << static_cast<unsigned>(*TripCount) << Body->getSourceRange();
+  }
+};
+} // anonymous namespace
+
+static bool hasActiveCilkPerformanceDiagnostics(DiagnosticsEngine &Diags,
+                                                SourceLocation Loc) {
+  return !Diags.isIgnored(diag::warn_cilk_spawn_trivial_callee, Loc) ||
+         !Diags.isIgnored(diag::warn_cilk_for_small_body, Loc) ||
+         !Diags.isIgnored(diag::warn_cilk_for_reducer_only_body, Loc) ||
+         !Diags.isIgnored(diag::warn_cilk_sync_in_serial_loop, Loc);
+}
+
 //===----------------------------------------------------------------------===//
 // AnalysisBasedWarnings - Worker object used by Sema to execute analysis-based
 //  warnings on a function, method, or block.
@@ -2432,6 +2739,11 @@ void clang::sema::AnalysisBasedWarnings::IssueWarnings(
       if (S.getLangOpts().CPlusPlus && isNoexcept(FD))
         checkThrowInNonThrowingFunc(S, FD, AC);
 
+  // Check for Cilk constructs that are too fine-grained to pay off.
+  if (S.getLangOpts().getCilk() != LangOptions::Cilk_none &&
+      hasActiveCilkPerformanceDiagnostics(Diags, D->getBeginLoc()))
+    CilkPerformanceChecker(S).check(Body);
+
   // If none of the previous checks caused a CFG build, trigger one here
   // for the logical error handler.
   if (LogicalErrorHandler::hasActiveDiagnostics(Diags, D->getBeginLoc())) {
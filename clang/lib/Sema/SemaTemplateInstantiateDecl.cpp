@@ -6271,6 +6271,12 @@ NamedDecl *Sema::FindInstantiatedDecl(SourceLocation Loc, NamedDecl *D,
 /// Performs template instantiation for all implicit template
 /// instantiations we have seen until this point.
 void Sema::PerformPendingInstantiations(bool LocalOnly) {
+  // Instantiations are performed one at a time, in the order they were
+  // requested.  Instantiating a definition can queue further instantiations,
+  // create new specializations, emit diagnostics and allocate from the
+  // ASTContext.  All of that is unsynchronized state shared through Sema, so
+  // independent function bodies cannot be instantiated concurrently.  The
+  // order is also what makes the emitted definitions deterministic.
   std::deque<PendingImplicitInstantiation> delayedPCHInstantiations;
   while (!PendingLocalImplicitInstantiations.empty() ||
          (!LocalOnly && !PendingInstantiations.empty())) {
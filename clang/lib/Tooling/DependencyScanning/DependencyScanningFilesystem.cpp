@@ -7,10 +7,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
+#include "clang/Basic/Version.h"
 #include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/Threading.h"
+#include "llvm/Support/xxhash.h"
 
 using namespace clang;
 using namespace tooling;
@@ -60,6 +67,20 @@ EntryRef DependencyScanningWorkerFilesystem::minimizeIfNecessary(
   if (Contents->MinimizedAccess.load())
     return EntryRef(/*Minimized=*/true, Filename, Entry);
 
+  const DependencyScanningPersistentCache *PersistentCache =
+      SharedCache.getPersistentCache();
+  if (PersistentCache) {
+    StringRef Original = Contents->Original->getBuffer();
+    if (auto Cached = PersistentCache->lookup(Original)) {
+      Contents->PPSkippedRangeMapping =
+          std::move(Cached->PPSkippedRangeMapping);
+      Contents->MinimizedStorage = std::move(Cached->Buffer);
+      // See below for why this must come last.
+      Contents->MinimizedAccess.store(Contents->MinimizedStorage.get());
+      return EntryRef(/*Minimized=*/true, Filename, Entry);
+    }
+  }
+
   llvm::SmallString<1024> MinimizedFileContents;
   // Minimize the file down to directives that might affect the dependencies.
   SmallVector<minimize_source_to_dependency_directives::Token, 64> Tokens;
@@ -93,6 +114,9 @@ EntryRef DependencyScanningWorkerFilesystem::minimizeIfNecessary(
     }
     Mapping[Range.Offset] = Range.Length;
   }
+  if (PersistentCache)
+    PersistentCache->store(Contents->Original->getBuffer(),
+                           MinimizedFileContents, Mapping);
   Contents->PPSkippedRangeMapping = std::move(Mapping);
 
   Contents->MinimizedStorage = std::make_unique<llvm::SmallVectorMemoryBuffer>(
@@ -106,8 +130,106 @@ EntryRef DependencyScanningWorkerFilesystem::minimizeIfNecessary(
   return EntryRef(/*Minimized=*/true, Filename, Entry);
 }
 
+/// Identifies the format of persistent cache entries: a header made of the
+/// magic, the SHA1 of the original contents, the size of the original contents
+/// and the number of skipped ranges, followed by the skipped ranges (offset and
+/// length pairs) and the minimized contents. All integers are 32-bit
+/// little-endian.
+static constexpr llvm::StringLiteral PersistentCacheMagic = "CSD2";
+
+DependencyScanningPersistentCache::DependencyScanningPersistentCache(
+    StringRef Directory)
+    : Directory(Directory.str()),
+      VersionHash(llvm::utohexstr(llvm::xxHash64(getClangFullVersion()))) {
+  llvm::sys::fs::create_directories(Directory);
+}
+
+std::string
+DependencyScanningPersistentCache::getEntryPath(const ContentHash &Hash) const {
+  SmallString<256> Path(Directory);
+  llvm::sys::path::append(Path, "llvmcache-minimized-" + VersionHash + "-" +
+                                    llvm::toHex(Hash));
+  return std::string(Path);
+}
+
+Optional<DependencyScanningPersistentCache::MinimizedContents>
+DependencyScanningPersistentCache::lookup(StringRef Original) const {
+  ContentHash Hash = llvm::SHA1::hash(llvm::arrayRefFromStringRef(Original));
+  // Update the access time of the entry, which is what pruneCache() uses to
+  // decide which entries are stale.
+  std::string Path = getEntryPath(Hash);
+  Expected<llvm::sys::fs::file_t> FD = llvm::sys::fs::openNativeFileForRead(
+      Path, llvm::sys::fs::OF_UpdateAtime);
+  if (!FD) {
+    llvm::consumeError(FD.takeError());
+    return None;
+  }
+  auto Buffer = llvm::MemoryBuffer::getOpenFile(
+      *FD, Path, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+  llvm::sys::fs::closeFile(*FD);
+  if (!Buffer)
+    return None;
+  StringRef Data = (*Buffer)->getBuffer();
+  auto ReadU32 = [&](uint32_t &Value) {
+    if (Data.size() < sizeof(uint32_t))
+      return false;
+    Value = llvm::support::endian::read32le(Data.data());
+    Data = Data.drop_front(sizeof(uint32_t));
+    return true;
+  };
+
+  // The file name is derived from the hash too, but an entry is only trusted
+  // if the hash it records matches the contents being looked up: a truncated,
+  // corrupted or misnamed entry is treated as a miss.
+  uint32_t OriginalSize, NumRanges;
+  if (!Data.consume_front(PersistentCacheMagic) ||
+      !Data.consume_front(llvm::toStringRef(Hash)) || !ReadU32(OriginalSize) ||
+      OriginalSize != Original.size() || !ReadU32(NumRanges))
+    return None;
+  MinimizedContents Result;
+  SmallVector<std::pair<uint32_t, uint32_t>, 8> Ranges;
+  for (uint32_t I = 0; I < NumRanges; ++I) {
+    uint32_t Offset, Length;
+    if (!ReadU32(Offset) || !ReadU32(Length))
+      return None;
+    Ranges.emplace_back(Offset, Length);
+  }
+  // Skipped ranges refer to the minimized contents that follow them.
+  for (const auto &Range : Ranges) {
+    if (uint64_t(Range.first) + Range.second > Data.size())
+      return None;
+    Result.PPSkippedRangeMapping[Range.first] = Range.second;
+  }
+  // The minimized contents must be null terminated, like the minimizer's.
+  Result.Buffer = llvm::MemoryBuffer::getMemBufferCopy(Data);
+  return Result;
+}
+
+void DependencyScanningPersistentCache::store(
+    StringRef Original, StringRef Minimized,
+    const PreprocessorSkippedRangeMapping &Mapping) const {
+  ContentHash Hash = llvm::SHA1::hash(llvm::arrayRefFromStringRef(Original));
+  std::string Entry;
+  llvm::raw_string_ostream OS(Entry);
+  llvm::support::endian::Writer Writer(OS, llvm::support::little);
+  OS << PersistentCacheMagic << llvm::toStringRef(Hash);
+  Writer.write<uint32_t>(Original.size());
+  Writer.write<uint32_t>(Mapping.size());
+  for (const auto &Range : Mapping) {
+    Writer.write<uint32_t>(Range.first);
+    Writer.write<uint32_t>(Range.second);
+  }
+  OS << Minimized;
+  OS.flush();
+
+  std::string Path = getEntryPath(Hash);
+  // Concurrent scans may store the same entry, the last rename wins.
+  llvm::consumeError(
+      llvm::writeFileAtomically(Path + ".tmp%%%%%%%%", Path, Entry));
+}
+
 DependencyScanningFilesystemSharedCache::
-    DependencyScanningFilesystemSharedCache() {
+    DependencyScanningFilesystemSharedCache(StringRef PersistentCacheDir) {
   // This heuristic was chosen using a empirical testing on a
   // reasonably high core machine (iMacPro 18 cores / 36 threads). The cache
   // sharding gives a performance edge by reducing the lock contention.
@@ -116,6 +238,9 @@ DependencyScanningFilesystemSharedCache::
   NumShards =
       std::max(2u, llvm::hardware_concurrency().compute_thread_count() / 4);
   CacheShards = std::make_unique<CacheShard[]>(NumShards);
+  if (!PersistentCacheDir.empty())
+    PersistentCache =
+        std::make_unique<DependencyScanningPersistentCache>(PersistentCacheDir);
 }
 
 DependencyScanningFilesystemSharedCache::CacheShard &
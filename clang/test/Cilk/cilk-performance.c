@@ -0,0 +1,90 @@
+// RUN: %clang_cc1 %s -fopencilk -fsyntax-only -verify -Wcilk-performance
+// RUN: %clang_cc1 %s -fopencilk -fsyntax-only -verify=default
+
+// default-no-diagnostics
+
+void identity(void *value);
+void reduce(void *left, void *right);
+
+int add_one(int x) { return x + 1; }
+int work(int x);
+int fib(int n) {
+  if (n < 2)
+    return n;
+  int x = _Cilk_spawn fib(n - 1);
+  int y = fib(n - 2);
+  _Cilk_sync;
+  return x + y;
+}
+
+void spawn_trivial(int *a) {
+  int x = _Cilk_spawn add_one(a[0]); // expected-warning{{spawned function 'add_one' does too little work to pay for the spawn}}
+  _Cilk_spawn add_one(a[1]); // expected-warning{{spawned function 'add_one' does too little work to pay for the spawn}}
+  int y = _Cilk_spawn work(a[2]);
+  int z = _Cilk_spawn fib(a[3]);
+  _Cilk_sync;
+  a[0] = x + y + z;
+}
+
+void small_cilk_for(int *a, int n) {
+  _Cilk_for (int i = 0; i < 16; ++i) // expected-warning{{'_Cilk_for' with 16 iterations of a small body is cheaper to run serially}}
+    a[i] = 2 * a[i];
+  _Cilk_for (int i = 0; i < 10; i += 3) // expected-warning{{'_Cilk_for' with 4 iterations of a small body is cheaper to run serially}}
+    a[i] = 2 * a[i];
+  _Cilk_for (int i = 0; i < 4096; ++i)
+    a[i] = 2 * a[i];
+  _Cilk_for (int i = 0; i < n; ++i)
+    a[i] = 2 * a[i];
+  _Cilk_for (int i = 0; i < 16; ++i)
+    a[i] = work(a[i]);
+  // Trip counts that overflow while they are computed are not diagnosed.
+  _Cilk_for (long long i = -9223372036854775807LL - 1;
+             i < 9223372036854775807LL; ++i)
+    a[i & 15] = 2 * a[i & 15];
+  _Cilk_for (long long i = 9223372036854775807LL;
+             i > -9223372036854775807LL - 1; --i)
+    a[i & 15] = 2 * a[i & 15];
+}
+
+void reducer_only(int *a, int n) {
+  int _Hyperobject(identity, reduce) sum = 0;
+  _Cilk_for (int i = 0; i < n; ++i) // expected-warning{{'_Cilk_for' body only updates reducer 'sum'; the reducer lookup dominates the work of each iteration}}
+    sum += a[i];
+  _Cilk_for (int i = 0; i < n; ++i) { // expected-warning{{'_Cilk_for' body only updates reducer 'sum'}}
+    ++sum;
+  }
+  _Cilk_for (int i = 0; i < n; ++i)
+    sum += work(a[i]);
+  _Cilk_for (int i = 0; i < n; ++i) {
+    a[i] = 2 * a[i];
+    sum += a[i];
+  }
+}
+
+void sync_in_loop(int *a, int n) {
+  for (int i = 0; i < n; ++i) {
+    _Cilk_spawn work(a[i]);
+    work(a[i] + 1);
+    _Cilk_sync; // expected-warning{{'_Cilk_sync' inside a serial loop limits parallelism to a single iteration}}
+  }
+  while (n--) {
+    for (int i = 0; i < n; ++i)
+      _Cilk_spawn work(a[i]);
+    _Cilk_sync; // expected-warning{{'_Cilk_sync' inside a serial loop}}
+  }
+  for (int i = 0; i < n; ++i) {
+    work(a[i]);
+    _Cilk_sync;
+  }
+  for (int i = 0; i < n; ++i) {
+    _Cilk_for (int j = 0; j < n; ++j) {
+      _Cilk_spawn work(a[j]);
+      work(a[j] + 1);
+      _Cilk_sync;
+    }
+    _Cilk_sync;
+  }
+  for (int i = 0; i < n; ++i)
+    _Cilk_spawn work(a[i]);
+  _Cilk_sync;
+}
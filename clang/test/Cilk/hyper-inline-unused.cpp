@@ -0,0 +1,19 @@
+// RUN: %clang_cc1 %s -std=c++17 -fopencilk -verify -S -emit-llvm -disable-llvm-passes -o - | FileCheck %s --implicit-check-not=never_used
+// expected-no-diagnostics
+
+// Reducers with discardable linkage are emitted where they are used, like
+// other variables, unless destroying their view has side effects.
+
+void identity_long(void *v);
+void reduce_long(void *l, void *r);
+
+inline long _Hyperobject(identity_long, reduce_long) never_used = 1;
+
+// CHECK-DAG: @used = linkonce_odr
+inline long _Hyperobject(identity_long, reduce_long) used = 1;
+
+struct D { ~D(); };
+// CHECK-DAG: @unused_with_dtor = linkonce_odr
+inline D _Hyperobject(identity_long, reduce_long) unused_with_dtor;
+
+long get() { return used; }
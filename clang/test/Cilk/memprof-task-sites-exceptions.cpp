@@ -0,0 +1,31 @@
+// Verify that, with memory profiling enabled, the site of the task that called
+// a spawning function is restored after the sync.unwind that follows a sync,
+// since lowering expects the sync.unwind to immediately follow the sync.
+//
+// RUN: %clang_cc1 %s -std=c++11 -fcxx-exceptions -fexceptions -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -fmemory-profile -verify -S -emit-llvm -o - | FileCheck %s
+// expected-no-diagnostics
+
+void bar(int);
+void handle_exn(int);
+
+void foo() {
+  // CHECK-LABEL: define {{.*}}void @_Z3foov()
+  // CHECK: %[[PARENT:.+]] = call i8* @__memprof_get_task_site()
+  // CHECK: {{call|invoke}} void @_Z3bari(i32 1)
+  // CHECK: invoke void @llvm.sync.unwind(token %{{.+}})
+  // CHECK-NEXT: to label %[[SYNCCONT:.+]] unwind label %{{.+}}
+  // CHECK: [[SYNCCONT]]:
+  // CHECK-NEXT: call void @__memprof_set_task_site(i8* %[[PARENT]])
+  try {
+    _Cilk_spawn bar(1);
+    bar(2);
+    _Cilk_sync;
+  } catch (int e) {
+    handle_exn(e);
+  }
+}
+
+// The runtime hooks do not throw, so calls to them need no landing pads.
+// CHECK-DAG: declare void @__memprof_set_task_site(i8*) #[[NOUNWIND:[0-9]+]]
+// CHECK-DAG: declare i8* @__memprof_get_task_site() #[[NOUNWIND]]
+// CHECK: attributes #[[NOUNWIND]] = { nounwind }
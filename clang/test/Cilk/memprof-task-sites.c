@@ -0,0 +1,39 @@
+// Verify that, with memory profiling enabled, spawned tasks report their spawn
+// site to the MemProf runtime, and that continuations restore the site of the
+// task that called the spawning function.
+//
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -fmemory-profile -verify -S -emit-llvm -o - | FileCheck %s
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -fmemory-profile -debug-info-kind=line-tables-only -verify -S -emit-llvm -o - | FileCheck %s --check-prefix=DEBUG
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -verify -S -emit-llvm -o - | FileCheck %s --check-prefix=NOMEMPROF
+// expected-no-diagnostics
+
+void bar(int);
+
+// CHECK: @[[SITE:memprof.task.site.name[.0-9]*]] = private unnamed_addr constant [13 x i8] c"foo spawn #0\00"
+
+void foo() {
+  // CHECK-LABEL: define {{.*}}void @foo()
+  // CHECK: %[[PARENT:.+]] = call i8* @__memprof_get_task_site()
+  // CHECK: call void @__memprof_set_task_site(i8* getelementptr inbounds ([13 x i8], [13 x i8]* @[[SITE]], i32 0, i32 0))
+  // CHECK: call void @bar(i32 1)
+  // CHECK: call void @__memprof_set_task_site(i8* %[[PARENT]])
+  // CHECK: call void @bar(i32 2)
+  // CHECK: call void @__memprof_set_task_site(i8* %[[PARENT]])
+  // CHECK: ret void
+
+  // DEBUG: c"{{.*}}memprof-task-sites.c:[[@LINE+1]]:{{[0-9]+}} in foo\00"
+  _Cilk_spawn bar(1);
+  bar(2);
+  _Cilk_sync;
+}
+
+// Functions that do not spawn are left alone.
+void baz() {
+  // CHECK-LABEL: define {{.*}}void @baz()
+  // CHECK-NOT: __memprof_{{get|set}}_task_site
+  // CHECK: ret void
+  bar(3);
+}
+
+// NOMEMPROF-NOT: __memprof_get_task_site
+// NOMEMPROF-NOT: __memprof_set_task_site
@@ -0,0 +1,45 @@
+// Verify that Tapir lowering annotates the happens-before edges of spawns and
+// syncs for ThreadSanitizer.
+//
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -fsanitize=thread -ftapir=serial -verify -S -emit-llvm -o - | FileCheck %s
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -verify -S -emit-llvm -o - | FileCheck %s --check-prefix=NOTSAN
+// expected-no-diagnostics
+
+void addA(void);
+void addB(void);
+
+void foo() {
+  // CHECK-LABEL: define {{.*}}void @foo()
+  // CHECK-DAG: %[[SPAWN:.+]] = alloca i8
+  // CHECK-DAG: %[[SYNC:.+]] = alloca i8
+  // CHECK: call void @__tsan_release(i8* %[[SPAWN]])
+  // CHECK: call void @__tsan_acquire(i8* %[[SPAWN]])
+  // CHECK: call void @addA()
+  // CHECK: call void @__tsan_release(i8* %[[SYNC]])
+  // CHECK: call void @__tsan_acquire(i8* %[[SPAWN]])
+  // CHECK: call void @addB()
+  // CHECK: call void @__tsan_release(i8* %[[SYNC]])
+  // CHECK-NEXT: call void @__tsan_acquire(i8* %[[SYNC]])
+  _Cilk_spawn addA();
+  addB();
+  _Cilk_sync;
+}
+
+// Each spawn in a spawning loop gets its own sync object, allocated in the loop
+// body right before the spawn.
+void loop(int n) {
+  // CHECK-LABEL: define {{.*}}void @loop(
+  // CHECK: for.body:
+  // CHECK: %[[SPAWN:.+]] = alloca i8
+  // CHECK-NEXT: call void @__tsan_release(i8* %[[SPAWN]])
+  // CHECK: call void @__tsan_acquire(i8* %[[SPAWN]])
+  // CHECK: call void @addA()
+  // CHECK: call void @__tsan_acquire(i8* %[[SPAWN]])
+  // CHECK: for.inc:
+  for (int i = 0; i < n; ++i)
+    _Cilk_spawn addA();
+  _Cilk_sync;
+}
+
+// NOTSAN-NOT: __tsan_acquire
+// NOTSAN-NOT: __tsan_release
@@ -0,0 +1,56 @@
+// Verify that Tapir lowering emits XRay custom events at spawns, task entries,
+// continuations and syncs when -tapir-xray-events is given.
+//
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -mllvm -tapir-xray-events -verify -S -emit-llvm -o - | FileCheck %s
+// RUN: %clang_cc1 %s -std=c99 -triple x86_64-unknown-linux-gnu -O0 -fopencilk -ftapir=serial -verify -S -emit-llvm -o - | FileCheck %s --check-prefix=NOEVENTS
+// expected-no-diagnostics
+
+void addA(void);
+void addB(void);
+
+// Each payload is { magic "TPIR", kind, site, function GUID, frame address }.
+void foo() {
+  // CHECK-LABEL: define {{.*}}void @foo()
+  // CHECK: %[[FA:.+]] = call i8* @llvm.frameaddress.p0i8(i32 0)
+  // CHECK-NEXT: %[[FRAME:.+]] = ptrtoint i8* %[[FA]] to i64
+
+  // Spawn, site 0.
+  // CHECK: store i32 1380536404, i32*
+  // CHECK: store i16 1, i16*
+  // CHECK: store i16 0, i16*
+  // CHECK: store i64 [[GUID:-?[0-9]+]], i64*
+  // CHECK: store i64 %[[FRAME]], i64*
+  // CHECK: call void @llvm.xray.customevent(i8* %{{.+}}, i32 24)
+
+  // Task entry, site 0.
+  // CHECK: store i32 1380536404, i32*
+  // CHECK: store i16 2, i16*
+  // CHECK: store i16 0, i16*
+  // CHECK: store i64 [[GUID]], i64*
+  // CHECK: store i64 %[[FRAME]], i64*
+  // CHECK: call void @llvm.xray.customevent(i8* %{{.+}}, i32 24)
+  // CHECK: call void @addA()
+
+  // Continuation, site 0.
+  // CHECK: store i32 1380536404, i32*
+  // CHECK: store i16 3, i16*
+  // CHECK: store i16 0, i16*
+  // CHECK: store i64 [[GUID]], i64*
+  // CHECK: store i64 %[[FRAME]], i64*
+  // CHECK: call void @llvm.xray.customevent(i8* %{{.+}}, i32 24)
+  // CHECK: call void @addB()
+
+  // Sync, site 1.
+  // CHECK: store i32 1380536404, i32*
+  // CHECK: store i16 4, i16*
+  // CHECK: store i16 1, i16*
+  // CHECK: store i64 [[GUID]], i64*
+  // CHECK: store i64 %[[FRAME]], i64*
+  // CHECK: call void @llvm.xray.customevent(i8* %{{.+}}, i32 24)
+  _Cilk_spawn addA();
+  addB();
+  _Cilk_sync;
+}
+
+// NOEVENTS-NOT: llvm.xray.customevent
+// NOEVENTS-NOT: llvm.frameaddress
@@ -0,0 +1,49 @@
+// Check that minimized file contents are cached on disk, and that the cache is
+// keyed on the file contents rather than on the file name.
+
+// RUN: rm -rf %t
+// RUN: split-file %s %t
+// RUN: sed -e "s|DIR|%/t|g" %t/cdb.json.template > %t/cdb.json
+
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -j 1 \
+// RUN:   -persistent-cache-dir %t/cache | FileCheck %s --check-prefix=FIRST
+// RUN: ls %t/cache | FileCheck %s --check-prefix=CACHE
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -j 1 \
+// RUN:   -persistent-cache-dir %t/cache | FileCheck %s --check-prefix=FIRST
+
+// FIRST:      tu.o: {{.*}}tu.c
+// FIRST-NEXT:   header.h
+// FIRST-NOT:    extra.h
+
+// CACHE: llvmcache-minimized-
+
+// RUN: cp %t/header_with_extra.h %t/header.h
+// RUN: clang-scan-deps -compilation-database %t/cdb.json -j 1 \
+// RUN:   -persistent-cache-dir %t/cache | FileCheck %s --check-prefix=SECOND
+
+// SECOND:      tu.o: {{.*}}tu.c
+// SECOND-NEXT:   header.h
+// SECOND-NEXT:   extra.h
+
+//--- cdb.json.template
+[
+  {
+    "directory": "DIR",
+    "command": "clang -c DIR/tu.c -o DIR/tu.o",
+    "file": "DIR/tu.c"
+  }
+]
+
+//--- tu.c
+#include "header.h"
+
+//--- header.h
+// Comment that will be stripped by the minimizer.
+#define MACRO 1
+
+//--- header_with_extra.h
+// Comment that will be stripped by the minimizer.
+#define MACRO 1
+#include "extra.h"
+
+//--- extra.h
@@ -14,6 +14,7 @@
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/CachePruning.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/InitLLVM.h"
@@ -186,6 +187,14 @@ llvm::cl::opt<std::string>
                   llvm::cl::desc("Compilation database"), llvm::cl::Required,
                   llvm::cl::cat(DependencyScannerCategory));
 
+llvm::cl::opt<std::string> PersistentCacheDir(
+    "persistent-cache-dir",
+    llvm::cl::desc("Cache minimized file contents in the specified directory, "
+                   "so that subsequent invocations only minimize the files "
+                   "that changed. Entries that were not used for a week are "
+                   "pruned."),
+    llvm::cl::cat(DependencyScannerCategory));
+
 llvm::cl::opt<bool> ReuseFileManager(
     "reuse-filemanager",
     llvm::cl::desc("Reuse the file manager and its cache between invocations."),
@@ -531,7 +540,8 @@ int main(int argc, const char **argv) {
   SharedStream DependencyOS(llvm::outs());
 
   DependencyScanningService Service(ScanMode, Format, ReuseFileManager,
-                                    SkipExcludedPPRanges, OptimizeArgs);
+                                    SkipExcludedPPRanges, OptimizeArgs,
+                                    PersistentCacheDir);
   llvm::ThreadPool Pool(llvm::hardware_concurrency(NumThreads));
   std::vector<std::unique_ptr<DependencyScanningTool>> WorkerTools;
   for (unsigned I = 0; I < Pool.getThreadCount(); ++I)
@@ -590,6 +600,11 @@ int main(int argc, const char **argv) {
   }
   Pool.wait();
 
+  // The default policy expires week-old entries and keeps the cache below 75%
+  // of the available space. Pruning is rate-limited through a timestamp file.
+  if (!PersistentCacheDir.empty())
+    llvm::pruneCache(PersistentCacheDir, llvm::CachePruningPolicy());
+
   if (Format == ScanningOutputFormat::Full)
     FD.printFullOutput(llvm::outs());
 
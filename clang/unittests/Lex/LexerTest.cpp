@@ -657,4 +657,30 @@ TEST_F(LexerTest, RawAndNormalLexSameForLineComments) {
   }
   EXPECT_TRUE(ToksView.empty());
 }
+
+TEST_F(LexerTest, LongRunsOfIdentifierAndWhitespaceCharacters) {
+  // Identifiers, whitespace and line comments longer than a vector register,
+  // which end on characters the lexer must handle on its slow path.
+  const llvm::StringLiteral Source =
+      "abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789 "
+      "                                \t\t\t\t\f\v   x\n"
+      "a_very_long_identifier_with_a_ucn_\\u00e9_in_the_middle "
+      "a_very_long_identifier_with_an_escaped_\\\n_newline "
+      "// a line comment that is longer than sixteen bytes \\\n"
+      "   continued on the next line\n"
+      "// another line comment that is longer than sixteen bytes\r\n"
+      "y";
+  LangOpts.CPlusPlus = true;
+  std::vector<Token> Toks = CheckLex(
+      Source, {tok::identifier, tok::identifier, tok::identifier,
+               tok::identifier, tok::identifier});
+  EXPECT_EQ("abcdefghijklmnopqrstuvwxyz_ABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789",
+            getSourceText(Toks[0], Toks[0]));
+  EXPECT_EQ("x", getSourceText(Toks[1], Toks[1]));
+  EXPECT_EQ("a_very_long_identifier_with_a_ucn_\\u00e9_in_the_middle",
+            getSourceText(Toks[2], Toks[2]));
+  EXPECT_EQ("a_very_long_identifier_with_an_escaped__newline",
+            Toks[3].getIdentifierInfo()->getName());
+  EXPECT_EQ("y", getSourceText(Toks[4], Toks[4]));
+}
 } // anonymous namespace
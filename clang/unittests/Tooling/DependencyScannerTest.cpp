@@ -17,7 +17,9 @@
 #include "clang/Tooling/DependencyScanning/DependencyScanningFilesystem.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetSelect.h"
@@ -251,6 +253,89 @@ TEST(DependencyScanningFilesystem, IgnoredFilesAreCachedSeparately2) {
   EXPECT_EQ(StatusMinimized1->getName(), StringRef("/mod.h"));
 }
 
+TEST(DependencyScanningFilesystem, PersistentCacheProvidesMinimizedContents) {
+  SmallString<128> CacheDir;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("scan-deps-cache", CacheDir));
+  auto Cleanup = llvm::make_scope_exit(
+      [&] { llvm::sys::fs::remove_directories(CacheDir); });
+
+  StringRef Original = "#include <foo.h>\n"
+                       "// hi there!\n";
+  auto VFS = llvm::makeIntrusiveRefCnt<llvm::vfs::InMemoryFileSystem>();
+  VFS->addFile("/mod.h", 0, llvm::MemoryBuffer::getMemBuffer(Original));
+  auto Mappings = std::make_unique<ExcludedPreprocessorDirectiveSkipMapping>();
+
+  // The first scan minimizes the file and stores the result.
+  {
+    DependencyScanningFilesystemSharedCache SharedCache(CacheDir);
+    ASSERT_TRUE(SharedCache.getPersistentCache());
+    DependencyScanningWorkerFilesystem DepFS(SharedCache, VFS, Mappings.get());
+    auto Status = DepFS.status("/mod.h");
+    ASSERT_TRUE(Status);
+    EXPECT_EQ(Status->getSize(), 17u);
+    auto Cached = SharedCache.getPersistentCache()->lookup(Original);
+    ASSERT_TRUE(Cached);
+    EXPECT_EQ(Cached->Buffer->getBuffer(), "#include <foo.h>\n");
+  }
+
+  // Subsequent scans use the stored result rather than minimizing again.
+  DependencyScanningPersistentCache(CacheDir).store(
+      Original, "#include <bar_.h>\n", PreprocessorSkippedRangeMapping());
+  DependencyScanningFilesystemSharedCache SharedCache(CacheDir);
+  DependencyScanningWorkerFilesystem DepFS(SharedCache, VFS, Mappings.get());
+  auto File = DepFS.openFileForRead("/mod.h");
+  ASSERT_TRUE(File);
+  auto Buffer = (*File)->getBuffer("/mod.h");
+  ASSERT_TRUE(Buffer);
+  EXPECT_EQ((*Buffer)->getBuffer(), "#include <bar_.h>\n");
+
+  // Entries for other contents are not affected.
+  EXPECT_FALSE(SharedCache.getPersistentCache()->lookup("#include <foo.h>\n"));
+}
+
+TEST(DependencyScanningFilesystem, PersistentCacheEntriesMatchContents) {
+  SmallString<128> CacheDir;
+  ASSERT_FALSE(
+      llvm::sys::fs::createUniqueDirectory("scan-deps-cache", CacheDir));
+  auto Cleanup = llvm::make_scope_exit(
+      [&] { llvm::sys::fs::remove_directories(CacheDir); });
+
+  // Inputs of the same size get separate entries.
+  DependencyScanningPersistentCache Cache(CacheDir);
+  Cache.store("#define A 1\n", "#define A 1\n",
+              PreprocessorSkippedRangeMapping());
+  Cache.store("#define B 2\n", "#define B 2\n",
+              PreprocessorSkippedRangeMapping());
+  auto A = Cache.lookup("#define A 1\n");
+  ASSERT_TRUE(A);
+  EXPECT_EQ(A->Buffer->getBuffer(), "#define A 1\n");
+  auto B = Cache.lookup("#define B 2\n");
+  ASSERT_TRUE(B);
+  EXPECT_EQ(B->Buffer->getBuffer(), "#define B 2\n");
+  EXPECT_FALSE(Cache.lookup("#define C 3\n"));
+
+  // An entry whose recorded hash does not match, e.g. because it was
+  // corrupted, is a miss.
+  std::error_code EC;
+  unsigned NumEntries = 0;
+  for (llvm::sys::fs::directory_iterator I(CacheDir, EC), E; I != E && !EC;
+       I.increment(EC)) {
+    ++NumEntries;
+    auto Buffer = llvm::MemoryBuffer::getFile(I->path());
+    ASSERT_TRUE(Buffer);
+    std::string Entry = (*Buffer)->getBuffer().str();
+    // Flip a bit of the hash that follows the 4-byte magic.
+    Entry[4] ^= 1;
+    llvm::raw_fd_ostream OS(I->path(), EC);
+    ASSERT_FALSE(EC);
+    OS << Entry;
+  }
+  EXPECT_EQ(NumEntries, 2u);
+  EXPECT_FALSE(Cache.lookup("#define A 1\n"));
+  EXPECT_FALSE(Cache.lookup("#define B 2\n"));
+}
+
 } // end namespace dependencies
 } // end namespace tooling
 } // end namespace clang
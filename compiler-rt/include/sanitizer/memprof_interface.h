@@ -58,6 +58,22 @@ const char *__memprof_default_options(void);
 /// \returns 0 on success.
 int __memprof_profile_dump(void);
 
+/// Sets the spawn site of the Cilk task that the current thread is running.
+///
+/// Allocations made by the thread from now on are attributed to this site in
+/// the text report. Calls to this function are normally inserted by the
+/// compiler at task boundaries.
+///
+/// \param site Name of the spawn site. Sites are identified by the address of
+/// this string, which must stay valid for the life of the program.
+void __memprof_set_task_site(const char *site);
+
+/// Returns the spawn site of the Cilk task that the current thread is running.
+///
+/// \returns The site most recently passed to
+/// <c>__memprof_set_task_site()</c> on this thread, or null.
+const char *__memprof_get_task_site(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
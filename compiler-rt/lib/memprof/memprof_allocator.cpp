@@ -18,6 +18,7 @@
 #include "memprof_mibmap.h"
 #include "memprof_rawprofile.h"
 #include "memprof_stack.h"
+#include "memprof_tasksites.h"
 #include "memprof_thread.h"
 #include "profile/MemProfData.inc"
 #include "sanitizer_common/sanitizer_allocator_checks.h"
@@ -39,36 +40,56 @@ namespace __memprof {
 namespace {
 using ::llvm::memprof::MemInfoBlock;
 
-void Print(const MemInfoBlock &M, const u64 id, bool print_terse) {
+void PrintTerseStats(const MemInfoBlock &M) {
   u64 p;
+  p = M.total_size * 100 / M.alloc_count;
+  Printf("%u/%llu.%02llu/%u/%u/", M.alloc_count, p / 100, p % 100, M.min_size,
+         M.max_size);
+  p = M.total_access_count * 100 / M.alloc_count;
+  Printf("%llu.%02llu/%llu/%llu/", p / 100, p % 100, M.min_access_count,
+         M.max_access_count);
+  p = M.total_lifetime * 100 / M.alloc_count;
+  Printf("%llu.%02llu/%u/%u/", p / 100, p % 100, M.min_lifetime,
+         M.max_lifetime);
+  Printf("%u/%u/%u/%u\n", M.num_migrated_cpu, M.num_lifetime_overlaps,
+         M.num_same_alloc_cpu, M.num_same_dealloc_cpu);
+}
+
+void PrintStats(const MemInfoBlock &M) {
+  u64 p;
+  p = M.total_size * 100 / M.alloc_count;
+  Printf("\talloc_count %u, size (ave/min/max) %llu.%02llu / %u / %u\n",
+         M.alloc_count, p / 100, p % 100, M.min_size, M.max_size);
+  p = M.total_access_count * 100 / M.alloc_count;
+  Printf("\taccess_count (ave/min/max): %llu.%02llu / %llu / %llu\n", p / 100,
+         p % 100, M.min_access_count, M.max_access_count);
+  p = M.total_lifetime * 100 / M.alloc_count;
+  Printf("\tlifetime (ave/min/max): %llu.%02llu / %u / %u\n", p / 100, p % 100,
+         M.min_lifetime, M.max_lifetime);
+  Printf("\tnum migrated: %u, num lifetime overlaps: %u, num same alloc "
+         "cpu: %u, num same dealloc_cpu: %u\n",
+         M.num_migrated_cpu, M.num_lifetime_overlaps, M.num_same_alloc_cpu,
+         M.num_same_dealloc_cpu);
+}
 
+void Print(const MemInfoBlock &M, const u64 id, bool print_terse) {
   if (print_terse) {
-    p = M.total_size * 100 / M.alloc_count;
-    Printf("MIB:%llu/%u/%llu.%02llu/%u/%u/", id, M.alloc_count, p / 100,
-           p % 100, M.min_size, M.max_size);
-    p = M.total_access_count * 100 / M.alloc_count;
-    Printf("%llu.%02llu/%llu/%llu/", p / 100, p % 100, M.min_access_count,
-           M.max_access_count);
-    p = M.total_lifetime * 100 / M.alloc_count;
-    Printf("%llu.%02llu/%u/%u/", p / 100, p % 100, M.min_lifetime,
-           M.max_lifetime);
-    Printf("%u/%u/%u/%u\n", M.num_migrated_cpu, M.num_lifetime_overlaps,
-           M.num_same_alloc_cpu, M.num_same_dealloc_cpu);
+    Printf("MIB:%llu/", id);
+    PrintTerseStats(M);
   } else {
-    p = M.total_size * 100 / M.alloc_count;
     Printf("Memory allocation stack id = %llu\n", id);
-    Printf("\talloc_count %u, size (ave/min/max) %llu.%02llu / %u / %u\n",
-           M.alloc_count, p / 100, p % 100, M.min_size, M.max_size);
-    p = M.total_access_count * 100 / M.alloc_count;
-    Printf("\taccess_count (ave/min/max): %llu.%02llu / %llu / %llu\n", p / 100,
-           p % 100, M.min_access_count, M.max_access_count);
-    p = M.total_lifetime * 100 / M.alloc_count;
-    Printf("\tlifetime (ave/min/max): %llu.%02llu / %u / %u\n", p / 100,
-           p % 100, M.min_lifetime, M.max_lifetime);
-    Printf("\tnum migrated: %u, num lifetime overlaps: %u, num same alloc "
-           "cpu: %u, num same dealloc_cpu: %u\n",
-           M.num_migrated_cpu, M.num_lifetime_overlaps, M.num_same_alloc_cpu,
-           M.num_same_dealloc_cpu);
+    PrintStats(M);
+  }
+}
+
+void PrintTaskSite(const MemInfoBlock &M, const u32 site_id,
+                   bool print_terse) {
+  if (print_terse) {
+    Printf("TASKMIB:%u/%s/", site_id, GetTaskSiteName(site_id));
+    PrintTerseStats(M);
+  } else {
+    Printf("Task spawn site %u = %s\n", site_id, GetTaskSiteName(site_id));
+    PrintStats(M);
   }
 }
 } // namespace
@@ -123,9 +144,11 @@ struct ChunkHeader {
   // 3-rd 4 bytes
   u32 timestamp_ms;
   // 4-th 4 bytes
-  // Note only 1 bit is needed for this flag if we need space in the future for
-  // more fields.
-  u32 from_memalign;
+  // Only 1 bit is needed for the memalign flag. The remaining bits hold the id
+  // of the spawn site of the task that made the allocation, or 0 if it was not
+  // made by a spawned task.
+  u32 from_memalign : 1;
+  u32 task_site_id : 31;
   // 5-th and 6-th 4 bytes
   // The max size of an allocation is 2^40 (kMaxAllowedMallocSize), so this
   // could be shrunk to kMaxAllowedMallocBits if we need space in the future for
@@ -258,6 +281,10 @@ struct Allocator {
   // Holds the mapping of stack ids to MemInfoBlocks.
   MIBMapTy MIBMap;
 
+  // Holds the mapping of task spawn site ids to MemInfoBlocks.
+  TaskSiteMIBMapTy TaskSiteMIBMap;
+  atomic_uint8_t has_task_sites;
+
   atomic_uint8_t destructing;
   atomic_uint8_t constructed;
   bool print_text;
@@ -266,6 +293,7 @@ struct Allocator {
   explicit Allocator(LinkerInitialized) : print_text(flags()->print_text) {
     atomic_store_relaxed(&destructing, 0);
     atomic_store_relaxed(&constructed, 1);
+    atomic_store_relaxed(&has_task_sites, 0);
   }
 
   ~Allocator() {
@@ -279,6 +307,23 @@ struct Allocator {
     Print(Value->mib, Key, bool(Arg));
   }
 
+  static void PrintTaskSiteCallback(const uptr Key,
+                                    LockedMemInfoBlock *const &Value,
+                                    void *Arg) {
+    SpinMutexLock lock(&Value->mutex);
+    PrintTaskSite(Value->mib, Key, bool(Arg));
+  }
+
+  // Records the MemInfoBlock of chunk m in the maps keyed by allocation
+  // context and, if the allocation was made by a spawned task, by task site.
+  void RecordMIB(MemprofChunk *m, const MemInfoBlock &newMIB) {
+    InsertOrMerge(m->alloc_context_id, newMIB, MIBMap);
+    if (m->task_site_id) {
+      InsertOrMerge(m->task_site_id, newMIB, TaskSiteMIBMap);
+      atomic_store_relaxed(&has_task_sites, 1);
+    }
+  }
+
   void FinishAndWrite() {
     if (print_text && common_flags()->print_module_map)
       DumpProcessMap();
@@ -291,6 +336,13 @@ struct Allocator {
         Printf("Recorded MIBs (incl. live on exit):\n");
       MIBMap.ForEach(PrintCallback,
                      reinterpret_cast<void *>(flags()->print_terse));
+      if (atomic_load_relaxed(&has_task_sites)) {
+        if (!flags()->print_terse)
+          Printf("Recorded MIBs per task spawn site:\n");
+        TaskSiteMIBMap.ForEach(
+            PrintTaskSiteCallback,
+            reinterpret_cast<void *>(flags()->print_terse));
+      }
       StackDepotPrintAll();
     } else {
       // Serialize the contents to a raw profile. Format documented in
@@ -321,7 +373,7 @@ struct Allocator {
           long curtime = GetTimestamp();
           MemInfoBlock newMIB(user_requested_size, c, m->timestamp_ms, curtime,
                               m->cpu_id, GetCpuId());
-          InsertOrMerge(m->alloc_context_id, newMIB, A->MIBMap);
+          A->RecordMIB(m, newMIB);
         },
         this);
   }
@@ -409,6 +461,7 @@ struct Allocator {
     m->cpu_id = GetCpuId();
     m->timestamp_ms = GetTimestamp();
     m->alloc_context_id = StackDepotPut(*stack);
+    m->task_site_id = GetCurrentTaskSiteId();
 
     uptr size_rounded_down_to_granularity =
         RoundDownTo(size, SHADOW_GRANULARITY);
@@ -455,7 +508,7 @@ struct Allocator {
 
       MemInfoBlock newMIB(user_requested_size, c, m->timestamp_ms, curtime,
                           m->cpu_id, GetCpuId());
-      InsertOrMerge(m->alloc_context_id, newMIB, MIBMap);
+      RecordMIB(m, newMIB);
     }
 
     MemprofStats &thread_stats = GetCurrentThreadStats();
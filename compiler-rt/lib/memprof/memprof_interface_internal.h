@@ -50,6 +50,13 @@ SANITIZER_INTERFACE_ATTRIBUTE SANITIZER_WEAK_ATTRIBUTE extern char
     __memprof_profile_filename[1];
 SANITIZER_INTERFACE_ATTRIBUTE int __memprof_profile_dump();
 
+// Called by instrumented Cilk code whenever a thread starts executing a
+// spawned task (with the name of its spawn site) or resumes executing the
+// continuation of a spawn or sync (with the site returned by
+// __memprof_get_task_site on entry to the spawning function).
+SANITIZER_INTERFACE_ATTRIBUTE void __memprof_set_task_site(const char *site);
+SANITIZER_INTERFACE_ATTRIBUTE const char *__memprof_get_task_site();
+
 SANITIZER_INTERFACE_ATTRIBUTE void __memprof_load(uptr p);
 SANITIZER_INTERFACE_ATTRIBUTE void __memprof_store(uptr p);
 
@@ -18,9 +18,11 @@
 namespace __memprof {
 using ::llvm::memprof::MemInfoBlock;
 
-void InsertOrMerge(const uptr Id, const MemInfoBlock &Block, MIBMapTy &Map) {
-  MIBMapTy::Handle h(&Map, static_cast<uptr>(Id), /*remove=*/false,
-                     /*create=*/true);
+template <typename MapTy>
+static void InsertOrMergeImpl(const uptr Id, const MemInfoBlock &Block,
+                              MapTy &Map) {
+  typename MapTy::Handle h(&Map, static_cast<uptr>(Id), /*remove=*/false,
+                           /*create=*/true);
   if (h.created()) {
     LockedMemInfoBlock *lmib =
         (LockedMemInfoBlock *)InternalAlloc(sizeof(LockedMemInfoBlock));
@@ -34,4 +36,13 @@ void InsertOrMerge(const uptr Id, const MemInfoBlock &Block, MIBMapTy &Map) {
   }
 }
 
+void InsertOrMerge(const uptr Id, const MemInfoBlock &Block, MIBMapTy &Map) {
+  InsertOrMergeImpl(Id, Block, Map);
+}
+
+void InsertOrMerge(const uptr Id, const MemInfoBlock &Block,
+                   TaskSiteMIBMapTy &Map) {
+  InsertOrMergeImpl(Id, Block, Map);
+}
+
 } // namespace __memprof
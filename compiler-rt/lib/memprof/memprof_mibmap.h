@@ -17,11 +17,20 @@ struct LockedMemInfoBlock {
 // The MIB map stores a mapping from stack ids to MemInfoBlocks.
 typedef __sanitizer::AddrHashMap<LockedMemInfoBlock *, 200003> MIBMapTy;
 
+// The task site MIB map aggregates the MemInfoBlocks of all allocations made by
+// tasks spawned from the same site, keyed by task site id.
+typedef __sanitizer::AddrHashMap<LockedMemInfoBlock *, 4093> TaskSiteMIBMapTy;
+
 // Insert a new MemInfoBlock or merge with an existing block identified by the
 // stack id.
 void InsertOrMerge(const uptr Id, const ::llvm::memprof::MemInfoBlock &Block,
                    MIBMapTy &Map);
 
+// Insert a new MemInfoBlock or merge with an existing block identified by the
+// task site id.
+void InsertOrMerge(const uptr Id, const ::llvm::memprof::MemInfoBlock &Block,
+                   TaskSiteMIBMapTy &Map);
+
 } // namespace __memprof
 
 #endif // MEMPROF_MIBMAP_H_
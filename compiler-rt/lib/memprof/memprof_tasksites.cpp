@@ -0,0 +1,72 @@
+//===-- memprof_tasksites.cpp --------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file is a part of MemProfiler, a memory profiler.
+//
+// Tracking of the spawn sites of Cilk tasks.
+//===----------------------------------------------------------------------===//
+
+#include "memprof_tasksites.h"
+#include "memprof_interface_internal.h"
+#include "sanitizer_common/sanitizer_addrhashmap.h"
+#include "sanitizer_common/sanitizer_atomic.h"
+
+namespace __memprof {
+
+// The spawn site of the task currently running on this thread.
+static THREADLOCAL const char *current_task_site;
+
+// Interning a site requires a hash map lookup, so remember the last result:
+// consecutive allocations are usually made by the same task.
+static THREADLOCAL const char *cached_task_site;
+static THREADLOCAL u32 cached_task_site_id;
+
+typedef AddrHashMap<u32, 4093> TaskSiteIdMapTy;
+static TaskSiteIdMapTy task_site_ids;
+static const char *task_site_names[kMaxTaskSites];
+static atomic_uint32_t num_task_sites;
+
+static u32 InternTaskSite(const char *site) {
+  TaskSiteIdMapTy::Handle h(&task_site_ids, reinterpret_cast<uptr>(site),
+                            /*remove=*/false, /*create=*/true);
+  if (h.created()) {
+    u32 id = atomic_fetch_add(&num_task_sites, 1, memory_order_relaxed) + 1;
+    if (id >= kMaxTaskSites) {
+      id = 0;
+    } else {
+      task_site_names[id] = site;
+    }
+    *h = id;
+  }
+  return *h;
+}
+
+u32 GetCurrentTaskSiteId() {
+  const char *site = current_task_site;
+  if (!site)
+    return 0;
+  if (site != cached_task_site) {
+    cached_task_site_id = InternTaskSite(site);
+    cached_task_site = site;
+  }
+  return cached_task_site_id;
+}
+
+const char *GetTaskSiteName(u32 id) {
+  CHECK(id > 0 && id < kMaxTaskSites);
+  return task_site_names[id];
+}
+
+} // namespace __memprof
+
+// ---------------------- Interface ---------------- {{{1
+using namespace __memprof;
+
+void __memprof_set_task_site(const char *site) { current_task_site = site; }
+
+const char *__memprof_get_task_site() { return current_task_site; }
@@ -0,0 +1,40 @@
+//===-- memprof_tasksites.h ------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file is a part of MemProfiler, a memory profiler.
+//
+// Tracks the spawn site of the Cilk task running on each thread, so that
+// allocations can be attributed to the task that made them. The compiler
+// reports task switches through __memprof_set_task_site, passing a constant
+// string that names the spawn site.
+//===----------------------------------------------------------------------===//
+
+#ifndef MEMPROF_TASKSITES_H
+#define MEMPROF_TASKSITES_H
+
+#include "sanitizer_common/sanitizer_internal_defs.h"
+
+namespace __memprof {
+
+using __sanitizer::u32;
+
+// Site ids must fit in the 31 bits reserved for them in the chunk header.
+// Allocations made after this many distinct sites have been seen are not
+// attributed to any site.
+constexpr u32 kMaxTaskSites = 1 << 16;
+
+// Returns the id of the spawn site of the task running on the current thread,
+// or 0 if the thread is not running a spawned task.
+u32 GetCurrentTaskSiteId();
+
+// Returns the name of the spawn site with the given non-zero id.
+const char *GetTaskSiteName(u32 id);
+
+} // namespace __memprof
+
+#endif // MEMPROF_TASKSITES_H
@@ -87,6 +87,45 @@ struct DefaultConfig {
 
   template <class A> using TSDRegistryT = TSDRegistryExT<A>; // Exclusive
 };
+
+// Configuration for programs using a work-stealing runtime, such as OpenCilk.
+// Spawned tasks and their continuations run on whichever thread steals them,
+// so blocks are frequently freed on a different thread than the one that
+// allocated them. Each thread keeps an exclusive cache that also acts as an
+// outbox for those remote frees: it is only flushed back to the owning size
+// class region once it holds a large batch of blocks. The StatCacheDeallocs and
+// StatCacheOverflows statistics show how often caches fill up and have to be
+// flushed; they do not distinguish remote frees from local ones.
+struct WorkStealingConfig {
+  using SizeClassMap = WorkStealingSizeClassMap;
+  static const bool MaySupportMemoryTagging = true;
+
+#if SCUDO_CAN_USE_PRIMARY64
+  typedef SizeClassAllocator64<WorkStealingConfig> Primary;
+  static const uptr PrimaryRegionSizeLog = 32U;
+  typedef uptr PrimaryCompactPtrT;
+  static const uptr PrimaryCompactPtrScale = 0;
+  static const bool PrimaryEnableRandomOffset = true;
+  static const uptr PrimaryMapSizeIncrement = 1UL << 18;
+#else
+  typedef SizeClassAllocator32<WorkStealingConfig> Primary;
+  static const uptr PrimaryRegionSizeLog = 19U;
+  typedef uptr PrimaryCompactPtrT;
+#endif
+  static const s32 PrimaryMinReleaseToOsIntervalMs = INT32_MIN;
+  static const s32 PrimaryMaxReleaseToOsIntervalMs = INT32_MAX;
+
+  typedef MapAllocatorCache<WorkStealingConfig> SecondaryCache;
+  static const u32 SecondaryCacheEntriesArraySize = 32U;
+  static const u32 SecondaryCacheQuarantineSize = 0U;
+  static const u32 SecondaryCacheDefaultMaxEntriesCount = 32U;
+  static const uptr SecondaryCacheDefaultMaxEntrySize = 1UL << 19;
+  static const s32 SecondaryCacheMinReleaseToOsIntervalMs = INT32_MIN;
+  static const s32 SecondaryCacheMaxReleaseToOsIntervalMs = INT32_MAX;
+
+  template <class A> using TSDRegistryT = TSDRegistryExT<A>; // Exclusive
+};
+
 struct AndroidConfig {
   using SizeClassMap = AndroidSizeClassMap;
   static const bool MaySupportMemoryTagging = true;
@@ -195,6 +234,8 @@ typedef AndroidConfig Config;
 typedef FuchsiaConfig Config;
 #elif SCUDO_TRUSTY
 typedef TrustyConfig Config;
+#elif SCUDO_WORK_STEALING
+typedef WorkStealingConfig Config;
 #else
 typedef DefaultConfig Config;
 #endif
@@ -1431,6 +1431,14 @@ private:
     Primary.getStats(Str);
     Secondary.getStats(Str);
     Quarantine.getStats(Str);
+    // Callers disable the allocator, so the stats lock is already held.
+    StatCounters S;
+    Stats.getLocked(S);
+    const uptr Deallocs = S[StatCacheDeallocs];
+    const uptr Overflows = S[StatCacheOverflows];
+    Str->append("Stats: LocalCache: %zu blocks freed into caches; %zu drained "
+                "to the primary from full caches (%zu%%)\n",
+                Deallocs, Overflows, Deallocs ? Overflows * 100 / Deallocs : 0);
     return Str->length();
   }
 };
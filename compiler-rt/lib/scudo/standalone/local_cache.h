@@ -87,14 +87,20 @@ template <class SizeClassAllocator> struct SizeClassAllocatorLocalCache {
     // We still have to initialize the cache in the event that the first heap
     // operation in a thread is a deallocation.
     initCacheMaybe(C);
-    if (C->Count == C->MaxCount)
-      drain(C, ClassId);
+    if (C->Count == C->MaxCount) {
+      const u32 Drained = drain(C, ClassId);
+      if (ClassId != BatchClassId)
+        Stats.add(StatCacheOverflows, Drained);
+    }
     // See comment in allocate() about memory accesses.
     const uptr ClassSize = C->ClassSize;
     C->Chunks[C->Count++] =
         Allocator->compactPtr(ClassId, reinterpret_cast<uptr>(P));
     Stats.sub(StatAllocated, ClassSize);
     Stats.add(StatFree, ClassSize);
+    // Only count user blocks, see the comment about ClassSize in initCache().
+    if (LIKELY(ClassSize))
+      Stats.add(StatCacheDeallocs, 1);
   }
 
   bool isEmpty() const {
@@ -179,7 +185,8 @@ private:
     return true;
   }
 
-  NOINLINE void drain(PerClass *C, uptr ClassId) {
+  // Returns the number of blocks pushed back to the primary.
+  NOINLINE u32 drain(PerClass *C, uptr ClassId) {
     const u32 Count = Min(C->MaxCount / 2, C->Count);
     TransferBatch *B =
         createBatch(ClassId, Allocator->decompactPtr(ClassId, C->Chunks[0]));
@@ -190,6 +197,7 @@ private:
     for (uptr I = 0; I < C->Count; I++)
       C->Chunks[I] = C->Chunks[I + Count];
     Allocator->pushBatch(ClassId, B);
+    return Count;
   }
 };
 
@@ -53,6 +53,12 @@
 #define SCUDO_CAN_USE_PRIMARY64 (SCUDO_WORDSIZE == 64U)
 #endif
 
+// Select the allocator configuration tuned for work-stealing runtimes, see
+// WorkStealingConfig.
+#ifndef SCUDO_WORK_STEALING
+#define SCUDO_WORK_STEALING 0
+#endif
+
 #ifndef SCUDO_MIN_ALIGNMENT_LOG
 // We force malloc-type functions to be aligned to std::max_align_t, but there
 // is no reason why the minimum alignment for all other functions can't be 8
@@ -230,6 +230,24 @@ struct DefaultSizeClassConfig {
 
 typedef FixedSizeClassMap<DefaultSizeClassConfig> DefaultSizeClassMap;
 
+// Same classes as the default map, with much larger per-thread caches. With
+// work-stealing runtimes, a block is often freed on a different thread than
+// the one that allocated it, so the freeing thread's cache fills up with
+// blocks it will not reuse. Larger caches let it return those blocks to their
+// regions in fewer, larger batches.
+struct WorkStealingSizeClassConfig {
+  static const uptr NumBits = 3;
+  static const uptr MinSizeLog = 5;
+  static const uptr MidSizeLog = 8;
+  static const uptr MaxSizeLog = 17;
+  static const u32 MaxNumCachedHint = 32;
+  static const uptr MaxBytesCachedLog = 14;
+  static const uptr SizeDelta = 0;
+};
+
+typedef FixedSizeClassMap<WorkStealingSizeClassConfig>
+    WorkStealingSizeClassMap;
+
 struct FuchsiaSizeClassConfig {
   static const uptr NumBits = 3;
   static const uptr MinSizeLog = 5;
@@ -17,8 +17,19 @@
 
 namespace scudo {
 
-// Memory allocator statistics
-enum StatType { StatAllocated, StatFree, StatMapped, StatCount };
+// Memory allocator statistics. StatCacheDeallocs and StatCacheOverflows count
+// blocks rather than bytes: the blocks deallocated into the per-thread caches,
+// and the blocks that were drained back to the primary because a cache was
+// full. Their ratio tells how well the caches absorb frees; it does not tell
+// which thread allocated the freed blocks.
+enum StatType {
+  StatAllocated,
+  StatFree,
+  StatMapped,
+  StatCacheDeallocs,
+  StatCacheOverflows,
+  StatCount
+};
 
 typedef uptr StatCounters[StatCount];
 
@@ -74,6 +85,12 @@ public:
 
   void get(uptr *S) const {
     ScopedLock L(Mutex);
+    getLocked(S);
+  }
+
+  // Same as get(), for callers that already hold the lock, e.g. through
+  // disable().
+  void getLocked(uptr *S) const {
     for (uptr I = 0; I < StatCount; I++)
       S[I] = LocalStats::get(static_cast<StatType>(I));
     for (const auto &Stats : StatsList) {
@@ -113,6 +113,7 @@ template <typename T> using ScudoCombinedDeathTest = ScudoCombinedTest<T>;
 #define SCUDO_TYPED_TEST_ALL_TYPES(FIXTURE, NAME)                              \
   SCUDO_TYPED_TEST_TYPE(FIXTURE, NAME, AndroidSvelteConfig)                    \
   SCUDO_TYPED_TEST_TYPE(FIXTURE, NAME, DefaultConfig)                          \
+  SCUDO_TYPED_TEST_TYPE(FIXTURE, NAME, WorkStealingConfig)                     \
   SCUDO_TYPED_TEST_TYPE(FIXTURE, NAME, AndroidConfig)
 #endif
 
@@ -432,6 +433,36 @@ SCUDO_TYPED_TEST(ScudoCombinedTest, Stats) {
   EXPECT_NE(Stats.find("Stats: SizeClassAllocator"), std::string::npos);
   EXPECT_NE(Stats.find("Stats: MapAllocator"), std::string::npos);
   EXPECT_NE(Stats.find("Stats: Quarantine"), std::string::npos);
+  EXPECT_NE(Stats.find("Stats: LocalCache"), std::string::npos);
+}
+
+SCUDO_TYPED_TEST(ScudoCombinedTest, CacheOverflowStats) {
+  auto *Allocator = this->Allocator.get();
+
+  // Allocate on one thread and free on another, as happens when a task and its
+  // continuation run on different workers. The freeing thread's cache can only
+  // absorb a few of those blocks before it has to drain them to the primary.
+  constexpr scudo::uptr NumBlocks = 1024U;
+  std::vector<void *> V;
+  std::thread Producer([&]() {
+    for (scudo::uptr I = 0; I < NumBlocks; I++)
+      V.push_back(Allocator->allocate(64U, Origin));
+  });
+  Producer.join();
+  std::thread Consumer([&]() {
+    for (void *P : V)
+      Allocator->deallocate(P, Origin);
+  });
+  Consumer.join();
+
+  scudo::uptr Stats[scudo::StatCount];
+  Allocator->getStats(Stats);
+  // With a quarantine, freed blocks only reach the caches when recycled.
+  if (!UseQuarantine) {
+    EXPECT_GE(Stats[scudo::StatCacheDeallocs], NumBlocks);
+    EXPECT_GT(Stats[scudo::StatCacheOverflows], 0U);
+  }
+  EXPECT_LE(Stats[scudo::StatCacheOverflows], Stats[scudo::StatCacheDeallocs]);
 }
 
 SCUDO_TYPED_TEST(ScudoCombinedTest, CacheDrain) {
@@ -20,6 +20,10 @@ TEST(ScudoSizeClassMapTest, DefaultSizeClassMap) {
   testSizeClassMap<scudo::DefaultSizeClassMap>();
 }
 
+TEST(ScudoSizeClassMapTest, WorkStealingSizeClassMap) {
+  testSizeClassMap<scudo::WorkStealingSizeClassMap>();
+}
+
 TEST(ScudoSizeClassMapTest, SvelteSizeClassMap) {
   testSizeClassMap<scudo::SvelteSizeClassMap>();
 }
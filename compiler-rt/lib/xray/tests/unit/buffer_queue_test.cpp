@@ -106,6 +106,48 @@ TEST(BufferQueueTest, MultiThreaded) {
   F();
 }
 
+TEST(BufferQueueTest, MultiThreadedExclusiveOwnership) {
+  static constexpr size_t kCount = 8;
+  bool Success = false;
+  BufferQueue Buffers(kSize, kCount, Success);
+  ASSERT_TRUE(Success);
+
+  // Each thread tags the buffers it holds; no other thread may observe the tag
+  // until the buffer has gone back through the queue.
+  std::atomic<int> Conflicts{0};
+  auto F = [&](unsigned char Tag) {
+    for (int I = 0; I < 10000; ++I) {
+      BufferQueue::Buffer B;
+      if (Buffers.getBuffer(B) != BufferQueue::ErrorCode::Ok)
+        continue;
+      auto *Data = static_cast<unsigned char *>(B.Data);
+      Data[0] = Tag;
+      std::this_thread::yield();
+      if (Data[0] != Tag)
+        Conflicts.fetch_add(1, std::memory_order_relaxed);
+      ASSERT_EQ(Buffers.releaseBuffer(B), BufferQueue::ErrorCode::Ok);
+    }
+  };
+  std::thread T0(F, 1), T1(F, 2), T2(F, 3), T3(F, 4);
+  T0.join();
+  T1.join();
+  T2.join();
+  T3.join();
+  EXPECT_EQ(Conflicts.load(), 0);
+
+  // All the buffers must be back in the queue, and each handed out once.
+  BufferQueue::Buffer Held[kCount];
+  for (auto &B : Held)
+    ASSERT_EQ(Buffers.getBuffer(B), BufferQueue::ErrorCode::Ok);
+  BufferQueue::Buffer Extra;
+  EXPECT_EQ(Buffers.getBuffer(Extra), BufferQueue::ErrorCode::NotEnoughMemory);
+  for (size_t I = 0; I < kCount; ++I)
+    for (size_t J = I + 1; J < kCount; ++J)
+      EXPECT_NE(Held[I].Data, Held[J].Data);
+  for (auto &B : Held)
+    EXPECT_EQ(Buffers.releaseBuffer(B), BufferQueue::ErrorCode::Ok);
+}
+
 TEST(BufferQueueTest, Apply) {
   bool Success = false;
   BufferQueue Buffers(kSize, 10, Success);
@@ -73,6 +73,16 @@ BufferQueue::ErrorCode BufferQueue::init(size_t BS, size_t BC) {
   if (!finalizing())
     return BufferQueue::ErrorCode::AlreadyInitialized;
 
+  // Keep any buffer operations that start from now on away from the slots,
+  // then wait for the ones already in progress to finish before we tear down
+  // the queue.
+  atomic_fetch_add(&InFlight, kInitializing, memory_order_acq_rel);
+  auto ClearInitializing = at_scope_exit([this] {
+    atomic_fetch_sub(&InFlight, kInitializing, memory_order_release);
+  });
+  while (atomic_load(&InFlight, memory_order_acquire) != kInitializing)
+    internal_sched_yield();
+
   cleanupBuffers();
 
   bool Success = false;
@@ -132,11 +142,14 @@ BufferQueue::ErrorCode BufferQueue::init(size_t BS, size_t BC) {
     Buf.ExtentsBackingStore = ExtentsBackingStore;
     Buf.Count = BufferCount;
     T.Used = false;
+
+    // All buffers start out in the queue, as if slot i had been filled by the
+    // i-th release.
+    atomic_store(&T.Sequence, i + 1, memory_order_relaxed);
   }
 
-  Next = Buffers;
-  First = Buffers;
-  LiveBuffers = 0;
+  atomic_store(&DequeuePos, 0, memory_order_relaxed);
+  atomic_store(&EnqueuePos, BufferCount, memory_order_relaxed);
   atomic_store(&Finalizing, 0, memory_order_release);
   Success = true;
   return BufferQueue::ErrorCode::Ok;
@@ -148,70 +161,118 @@ BufferQueue::BufferQueue(size_t B, size_t N,
       BufferCount(N),
       Mutex(),
       Finalizing{1},
+      InFlight{0},
       BackingStore(nullptr),
       ExtentsBackingStore(nullptr),
       Buffers(nullptr),
-      Next(Buffers),
-      First(Buffers),
-      LiveBuffers(0),
+      DequeuePos{0},
+      EnqueuePos{0},
       Generation{0} {
   Success = init(B, N) == BufferQueue::ErrorCode::Ok;
 }
 
+void BufferQueue::discardBuffer(Buffer &Buf) {
+  auto *BackingStore = Buf.BackingStore;
+  auto *ExtentsBackingStore = Buf.ExtentsBackingStore;
+  auto Size = Buf.Size;
+  auto Count = Buf.Count;
+  Buf = {};
+  decRefCount(BackingStore, Size, Count);
+  decRefCount(ExtentsBackingStore, kExtentsSize, Count);
+}
+
 BufferQueue::ErrorCode BufferQueue::getBuffer(Buffer &Buf) {
   if (atomic_load(&Finalizing, memory_order_acquire))
     return ErrorCode::QueueFinalizing;
 
+  auto InFlightBefore = atomic_fetch_add(&InFlight, 1, memory_order_acquire);
+  auto DecInFlight = at_scope_exit(
+      [this] { atomic_fetch_sub(&InFlight, 1, memory_order_release); });
+
+  // Re-check now that init() can see us, in case a finalize and re-init raced
+  // with the check above.
+  if ((InFlightBefore & kInitializing) ||
+      atomic_load(&Finalizing, memory_order_acquire))
+    return ErrorCode::QueueFinalizing;
+
   BufferRep *B = nullptr;
-  {
-    SpinMutexLock Guard(&Mutex);
-    if (LiveBuffers == BufferCount)
+  atomic_uint64_t::Type Pos = atomic_load(&DequeuePos, memory_order_relaxed);
+  while (true) {
+    B = &Buffers[Pos % BufferCount];
+    atomic_uint64_t::Type Seq = atomic_load(&B->Sequence, memory_order_acquire);
+    auto Diff = static_cast<int64_t>(Seq - (Pos + 1));
+    if (Diff == 0) {
+      if (atomic_compare_exchange_weak(&DequeuePos, &Pos, Pos + 1,
+                                       memory_order_relaxed))
+        break;
+    } else if (Diff < 0) {
+      // The slot has not been refilled yet: every buffer is live.
       return ErrorCode::NotEnoughMemory;
-    B = Next++;
-    if (Next == (Buffers + BufferCount))
-      Next = Buffers;
-    ++LiveBuffers;
+    } else {
+      Pos = atomic_load(&DequeuePos, memory_order_relaxed);
+    }
   }
 
-  incRefCount(BackingStore);
-  incRefCount(ExtentsBackingStore);
   Buf = B->Buff;
-  Buf.Generation = generation();
   B->Used = true;
+
+  // Hand the slot back to producers, one lap ahead.
+  atomic_store(&B->Sequence, Pos + BufferCount, memory_order_release);
+
+  incRefCount(Buf.BackingStore);
+  incRefCount(Buf.ExtentsBackingStore);
+  Buf.Generation = generation();
   return ErrorCode::Ok;
 }
 
 BufferQueue::ErrorCode BufferQueue::releaseBuffer(Buffer &Buf) {
+  auto InFlightBefore = atomic_fetch_add(&InFlight, 1, memory_order_acquire);
+  auto DecInFlight = at_scope_exit(
+      [this] { atomic_fetch_sub(&InFlight, 1, memory_order_release); });
+
+  // Buffers from an older generation, or released while the queue is being
+  // re-initialized, are simply dropped.
+  if ((InFlightBefore & kInitializing) || Buf.Generation != generation()) {
+    discardBuffer(Buf);
+    return BufferQueue::ErrorCode::Ok;
+  }
+
   // Check whether the buffer being referred to is within the bounds of the
   // backing store's range.
+  if (Buf.Data < &BackingStore->Data ||
+      Buf.Data > &BackingStore->Data + (BufferCount * BufferSize))
+    return BufferQueue::ErrorCode::UnrecognizedBuffer;
+
   BufferRep *B = nullptr;
-  {
-    SpinMutexLock Guard(&Mutex);
-    if (Buf.Generation != generation() || LiveBuffers == 0) {
-      Buf = {};
-      decRefCount(Buf.BackingStore, Buf.Size, Buf.Count);
-      decRefCount(Buf.ExtentsBackingStore, kExtentsSize, Buf.Count);
+  atomic_uint64_t::Type Pos = atomic_load(&EnqueuePos, memory_order_relaxed);
+  while (true) {
+    B = &Buffers[Pos % BufferCount];
+    atomic_uint64_t::Type Seq = atomic_load(&B->Sequence, memory_order_acquire);
+    auto Diff = static_cast<int64_t>(Seq - Pos);
+    if (Diff == 0) {
+      if (atomic_compare_exchange_weak(&EnqueuePos, &Pos, Pos + 1,
+                                       memory_order_relaxed))
+        break;
+    } else if (Diff < 0) {
+      // The queue is already full, so this buffer cannot be one we handed out
+      // in this generation.
+      discardBuffer(Buf);
       return BufferQueue::ErrorCode::Ok;
+    } else {
+      Pos = atomic_load(&EnqueuePos, memory_order_relaxed);
     }
-
-    if (Buf.Data < &BackingStore->Data ||
-        Buf.Data > &BackingStore->Data + (BufferCount * BufferSize))
-      return BufferQueue::ErrorCode::UnrecognizedBuffer;
-
-    --LiveBuffers;
-    B = First++;
-    if (First == (Buffers + BufferCount))
-      First = Buffers;
   }
 
   // Now that the buffer has been released, we mark it as "used".
   B->Buff = Buf;
   B->Used = true;
-  decRefCount(Buf.BackingStore, Buf.Size, Buf.Count);
-  decRefCount(Buf.ExtentsBackingStore, kExtentsSize, Buf.Count);
   atomic_store(B->Buff.Extents, atomic_load(Buf.Extents, memory_order_acquire),
                memory_order_release);
-  Buf = {};
+
+  // Publish the slot to consumers.
+  atomic_store(&B->Sequence, Pos + 1, memory_order_release);
+
+  discardBuffer(Buf);
   return ErrorCode::Ok;
 }
 
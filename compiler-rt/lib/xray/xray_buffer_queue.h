@@ -28,6 +28,12 @@ namespace __xray {
 /// get from or return buffers to the queue. This is one key component of the
 /// "flight data recorder" (FDR) mode to support ongoing XRay function call
 /// trace collection.
+///
+/// Getting and releasing buffers is lock-free: the queue is a bounded
+/// multi-producer/multi-consumer ring where each slot carries a sequence number
+/// that tells producers and consumers whether the slot is ready for them. This
+/// keeps many short-lived threads from serializing on a single lock whenever
+/// they swap buffers.
 class BufferQueue {
 public:
   /// ControlBlock represents the memory layout of how we interpret the backing
@@ -71,6 +77,12 @@ public:
     // This is true if the buffer has been returned to the available queue, and
     // is considered "used" by another thread.
     bool Used = false;
+
+    // The sequence number for this slot in the queue. A slot whose sequence
+    // number equals the current enqueue position is free to receive a released
+    // buffer, and a slot whose sequence number is one past the current dequeue
+    // position holds a buffer ready to be handed out.
+    atomic_uint64_t Sequence;
   };
 
 private:
@@ -137,11 +149,23 @@ private:
   // Amount of pre-allocated buffers.
   size_t BufferCount;
 
+  // Serializes (re-)initialization and iteration over the buffers. The hot
+  // paths (getBuffer/releaseBuffer) never acquire this mutex.
   SpinMutex Mutex;
   atomic_uint8_t Finalizing;
 
+  // Count of getBuffer/releaseBuffer calls currently operating on the slots.
+  // init() sets the kInitializing bit while it tears down and rebuilds the
+  // queue, and waits for the count to drop to zero first; calls that observe
+  // the bit treat the queue as finalizing and their buffers as stale. Keeping
+  // the flag and the count in one word lets both sides get away with
+  // acquire/release ordering. Every operation writes this counter, so it
+  // lives on its own cache line.
+  static constexpr atomic_uint64_t::Type kInitializing = 1ULL << 63;
+  alignas(kCacheLineSize) atomic_uint64_t InFlight;
+
   // The collocated ControlBlock and buffer storage.
-  ControlBlock *BackingStore;
+  alignas(kCacheLineSize) ControlBlock *BackingStore;
 
   // The collocated ControlBlock and extents storage.
   ControlBlock *ExtentsBackingStore;
@@ -149,23 +173,27 @@ private:
   // A dynamically allocated array of BufferRep instances.
   BufferRep *Buffers;
 
-  // Pointer to the next buffer to be handed out.
-  BufferRep *Next;
+  // Monotonic position of the next buffer to be handed out. The slot is found
+  // at this position modulo BufferCount. The dequeue and enqueue positions
+  // are kept on separate cache lines, since they are updated by different
+  // threads.
+  alignas(kCacheLineSize) atomic_uint64_t DequeuePos;
 
-  // Pointer to the entry in the array where the next released buffer will be
+  // Monotonic position of the slot where the next released buffer will be
   // placed.
-  BufferRep *First;
-
-  // Count of buffers that have been handed out through 'getBuffer'.
-  size_t LiveBuffers;
+  alignas(kCacheLineSize) atomic_uint64_t EnqueuePos;
 
   // We use a generation number to identify buffers and which generation they're
   // associated with.
-  atomic_uint64_t Generation;
+  alignas(kCacheLineSize) atomic_uint64_t Generation;
 
   /// Releases references to the buffers backed by the current buffer queue.
   void cleanupBuffers();
 
+  /// Drops the references held by a buffer that is no longer tracked by the
+  /// queue, and resets it.
+  static void discardBuffer(Buffer &Buf);
+
 public:
   enum class ErrorCode : unsigned {
     Ok,
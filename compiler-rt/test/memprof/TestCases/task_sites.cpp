@@ -0,0 +1,43 @@
+// Check that allocations are aggregated per task spawn site, as reported to the
+// runtime by the instrumentation of Tapir tasks. We call the runtime interface
+// directly here, the way instrumented Cilk code does at task boundaries.
+
+// RUN: %clangxx_memprof -O0 %s -o %t
+// RUN: %env_memprof_opts=print_text=true:log_path=stdout %run %t | FileCheck %s
+// RUN: %env_memprof_opts=print_text=true:log_path=stdout:print_terse=1 %run %t | FileCheck %s --check-prefix=TERSE
+
+#include <sanitizer/memprof_interface.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char SiteA[] = "a.cpp:10:3 in parent";
+static const char SiteB[] = "a.cpp:12:3 in parent";
+
+static void task(int n) {
+  for (int i = 0; i < n; i++) {
+    char *x = (char *)malloc(16);
+    memset(x, 0, 16);
+    free(x);
+  }
+}
+
+int main() {
+  const char *parent = __memprof_get_task_site();
+  __memprof_set_task_site(SiteA);
+  task(2);
+  __memprof_set_task_site(parent);
+  __memprof_set_task_site(SiteB);
+  task(3);
+  __memprof_set_task_site(parent);
+  // Not made by any task.
+  free(malloc(8));
+  return 0;
+}
+
+// CHECK: Recorded MIBs per task spawn site:
+// CHECK-DAG: Task spawn site {{[0-9]+}} = a.cpp:10:3 in parent
+// CHECK-DAG: Task spawn site {{[0-9]+}} = a.cpp:12:3 in parent
+// CHECK-NOT: Task spawn site
+
+// TERSE-DAG: TASKMIB:{{[0-9]+}}/a.cpp:10:3 in parent/2/16.00/16/16/
+// TERSE-DAG: TASKMIB:{{[0-9]+}}/a.cpp:12:3 in parent/3/16.00/16/16/
@@ -14,6 +14,7 @@
 #ifndef LLVM_ANALYSIS_TAPIRRACEDETECT_H
 #define LLVM_ANALYSIS_TAPIRRACEDETECT_H
 
+#include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
@@ -23,6 +24,8 @@
 
 namespace llvm {
 
+class CallGraph;
+class GlobalVariable;
 class Loop;
 class LoopInfo;
 class RuntimePointerChecking;
@@ -31,6 +34,58 @@ class StratABIList;
 class TargetLibraryInfo;
 class TaskInfo;
 
+/// Summary of the memory a function may access, for use when analyzing calls
+/// to that function.  Any access the function performs might execute in
+/// parallel with tasks in its callers, so the summary records every location
+/// the function might read or write, except for stack and heap objects the
+/// function allocates itself.
+struct FunctionRaceSummary {
+  /// True if the function might access memory not described by ArgMR or
+  /// GlobalMR, e.g., through a pointer loaded from memory or via an opaque
+  /// call.
+  bool AccessesUnknownMemory = false;
+  /// Mod/ref behavior of the function on the pointee of each argument.
+  SmallVector<ModRefInfo, 4> ArgMR;
+  /// Mod/ref behavior of the function on global variables.
+  MapVector<const GlobalVariable *, ModRefInfo> GlobalMR;
+
+  ModRefInfo getArgModRef(unsigned ArgNo) const {
+    if (AccessesUnknownMemory || ArgNo >= ArgMR.size())
+      return ModRefInfo::ModRef;
+    return ArgMR[ArgNo];
+  }
+};
+
+/// RaceSummaryInfo - Race summaries for the functions with exact definitions
+/// in a module.  Summaries are computed once, bottom-up over the call graph,
+/// so that the race analysis of each function can look through its calls
+/// instead of treating them as opaque.
+class RaceSummaryInfo {
+public:
+  RaceSummaryInfo(Module &M, CallGraph &CG,
+                  function_ref<const TargetLibraryInfo &(Function &)> GetTLI);
+
+  /// Returns the summary for F, or nullptr if F has no exact definition in
+  /// this module.
+  const FunctionRaceSummary *getSummary(const Function *F) const {
+    auto It = Summaries.find(F);
+    if (It == Summaries.end())
+      return nullptr;
+    return &It->second;
+  }
+
+  bool invalidate(Module &M, const PreservedAnalyses &PA,
+                  ModuleAnalysisManager::Invalidator &);
+
+  void print(raw_ostream &) const;
+
+private:
+  bool computeSummary(Function &F, const TargetLibraryInfo &TLI);
+
+  Module &M;
+  DenseMap<const Function *, FunctionRaceSummary> Summaries;
+};
+
 /// RaceInfo
 class RaceInfo {
 public:
@@ -223,7 +278,8 @@ public:
 
   RaceInfo(Function *F, DominatorTree &DT, LoopInfo &LI, TaskInfo &TI,
            DependenceInfo &DI, ScalarEvolution &SE,
-           const TargetLibraryInfo *TLI);
+           const TargetLibraryInfo *TLI,
+           const RaceSummaryInfo *Summaries = nullptr);
 
   const SmallVectorImpl<RaceData> &getRaceData(const Instruction *I) {
     return Result[I];
@@ -306,6 +362,8 @@ private:
   DependenceInfo &DI;
   ScalarEvolution &SE;
   const TargetLibraryInfo *TLI;
+  // Summaries of the functions called, if available.
+  const RaceSummaryInfo *Summaries;
 
   ResultTy Result;
   // Map from underlying objects to mod/ref behavior necessary for potential
@@ -327,6 +385,30 @@ private:
   friend struct AnalysisInfoMixin<TapirRaceDetect>;
 }; // class TapirRaceDetect
 
+// Module-level analysis pass computing race summaries of functions
+class TapirRaceSummaryAnalysis
+    : public AnalysisInfoMixin<TapirRaceSummaryAnalysis> {
+public:
+  using Result = RaceSummaryInfo;
+  Result run(Module &M, ModuleAnalysisManager &MAM);
+
+private:
+  static AnalysisKey Key;
+  friend struct AnalysisInfoMixin<TapirRaceSummaryAnalysis>;
+}; // class TapirRaceSummaryAnalysis
+
+// Printer pass for race summaries
+class TapirRaceSummaryPrinterPass
+  : public PassInfoMixin<TapirRaceSummaryPrinterPass> {
+public:
+  TapirRaceSummaryPrinterPass(raw_ostream &OS) : OS(OS) {}
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &MAM);
+
+private:
+  raw_ostream &OS;
+}; // class TapirRaceSummaryPrinterPass
+
 // Printer pass
 class TapirRaceDetectPrinterPass
   : public PassInfoMixin<TapirRaceDetectPrinterPass> {
@@ -153,6 +153,13 @@ public:
   /// owned by this class.
   DIEAbbrev &uniqueAbbreviation(DIE &Die);
 
+  /// Unique an abbreviation declaration owned by another set, and return the
+  /// uniqued one owned by this class.
+  DIEAbbrev &uniqueAbbreviation(const DIEAbbrev &Abbrev);
+
+  /// Get the unique abbreviations in use, in abbreviation number order.
+  ArrayRef<DIEAbbrev *> getAbbreviations() const { return Abbreviations; }
+
   /// Print all abbreviations using the specified asm printer.
   void Emit(const AsmPrinter *AP, MCSection *Section) const;
 };
@@ -833,6 +840,19 @@ public:
   unsigned computeOffsetsAndAbbrevs(const dwarf::FormParams &FormParams,
                                     DIEAbbrevSet &AbbrevSet, unsigned CUOffset);
 
+  /// Compute the offset of this DIE and all its children, after their
+  /// abbreviations were uniqued by computeOffsetsAndAbbrevs() in a different
+  /// abbreviation set than the one that will be emitted.
+  ///
+  /// \param FormParams Used when calculating sizes.
+  /// \param AbbrevNumbers the abbreviation numbers to use, indexed by the
+  /// abbreviation numbers in the set the DIEs were uniqued in.
+  /// \param CUOffset the compile/type unit relative offset in bytes.
+  /// \returns the offset for the DIE that follows this DIE within the
+  /// current compile/type unit.
+  unsigned computeOffsets(const dwarf::FormParams &FormParams,
+                          ArrayRef<unsigned> AbbrevNumbers, unsigned CUOffset);
+
   /// Climb up the parent chain to get the compile unit or type unit DIE that
   /// this DIE belongs to.
   ///
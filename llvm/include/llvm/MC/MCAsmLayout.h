@@ -10,6 +10,7 @@
 #define LLVM_MC_MCASMLAYOUT_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 
 namespace llvm {
@@ -36,6 +37,18 @@ class MCAsmLayout {
   /// lower ordinal will be valid.
   mutable DenseMap<const MCSection *, MCFragment *> LastValidFragment;
 
+  /// The section being relaxed, or the section of the fragment being laid out
+  /// on its behalf. Null when relaxation is not in progress.
+  mutable const MCSection *CurrentSection = nullptr;
+
+  /// For each section, the other sections whose relaxation or layout read its
+  /// layout while relaxation was in progress.
+  mutable DenseMap<const MCSection *, SmallVector<const MCSection *, 2>>
+      Readers;
+
+  /// Record that the current section read the layout of \p Sec.
+  void noteRead(const MCSection *Sec) const;
+
   /// Make sure that the layout for the given fragment is valid, lazily
   /// computing it if necessary.
   void ensureValid(const MCFragment *F) const;
@@ -58,6 +71,15 @@ public:
   /// its bundle padding will be recomputed.
   void invalidateFragmentsFrom(MCFragment *F);
 
+  /// Set the section that is about to be relaxed, or null once relaxation is
+  /// done. While one is set, reads of the layout of other sections are
+  /// recorded for addAffectedSections().
+  void setRelaxingSection(const MCSection *Sec) { CurrentSection = Sec; }
+
+  /// Add to \p Sections the sections whose relaxation or layout read the
+  /// layout of a section in it, directly or through other sections.
+  void addAffectedSections(SmallPtrSetImpl<const MCSection *> &Sections) const;
+
   /// Perform layout for a single fragment, assuming that the previous
   /// fragment has already been laid out correctly, and the parent section has
   /// been initialized.
@@ -183,9 +183,10 @@ private:
   bool fragmentNeedsRelaxation(const MCRelaxableFragment *IF,
                                const MCAsmLayout &Layout) const;
 
-  /// Perform one layout iteration and return true if any offsets
-  /// were adjusted.
-  bool layoutOnce(MCAsmLayout &Layout);
+  /// Perform one layout iteration of the given sections, add the ones whose
+  /// offsets were adjusted to \p Relaxed, and return true if there are any.
+  bool layoutOnce(MCAsmLayout &Layout, ArrayRef<MCSection *> Sections,
+                  SmallPtrSetImpl<const MCSection *> &Relaxed);
 
   /// Perform one layout iteration of the given section and return true
   /// if any offsets were adjusted.
@@ -19,6 +19,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/None.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/iterator.h"
 #include "llvm/ADT/iterator_range.h"
@@ -568,6 +569,12 @@ public:
 /// This is the main interface to get coverage information, using a profile to
 /// fill out execution counts.
 class CoverageMapping {
+public:
+  /// Predicate selecting the source files whose coverage is requested. A null
+  /// filter selects every file.
+  using FilenameFilter = function_ref<bool(StringRef)>;
+
+private:
   DenseMap<size_t, DenseSet<size_t>> RecordProvenance;
   std::vector<FunctionRecord> Functions;
   DenseMap<size_t, SmallVector<unsigned, 0>> FilenameHash2RecordIndices;
@@ -578,11 +585,14 @@ class CoverageMapping {
   // Load coverage records from readers.
   static Error loadFromReaders(
       ArrayRef<std::unique_ptr<CoverageMappingReader>> CoverageReaders,
-      IndexedInstrProfReader &ProfileReader, CoverageMapping &Coverage);
+      IndexedInstrProfReader &ProfileReader, CoverageMapping &Coverage,
+      FilenameFilter IsRequestedFile);
 
-  /// Add a function record corresponding to \p Record.
+  /// Add a function record corresponding to \p Record, unless none of its
+  /// files pass \p IsRequestedFile.
   Error loadFunctionRecord(const CoverageMappingRecord &Record,
-                           IndexedInstrProfReader &ProfileReader);
+                           IndexedInstrProfReader &ProfileReader,
+                           FilenameFilter IsRequestedFile);
 
   /// Look up the indices for function records which are at least partially
   /// defined in the specified file. This is guaranteed to return a superset of
@@ -595,17 +605,24 @@ public:
   CoverageMapping(const CoverageMapping &) = delete;
   CoverageMapping &operator=(const CoverageMapping &) = delete;
 
-  /// Load the coverage mapping using the given readers.
+  /// Load the coverage mapping using the given readers. If \p IsRequestedFile
+  /// is set, only functions with code in at least one requested file are
+  /// loaded.
   static Expected<std::unique_ptr<CoverageMapping>>
   load(ArrayRef<std::unique_ptr<CoverageMappingReader>> CoverageReaders,
-       IndexedInstrProfReader &ProfileReader);
+       IndexedInstrProfReader &ProfileReader,
+       FilenameFilter IsRequestedFile = nullptr);
 
   /// Load the coverage mapping from the given object files and profile. If
   /// \p Arches is non-empty, it must specify an architecture for each object.
   /// Ignores non-instrumented object files unless all are not instrumented.
+  /// If \p IsRequestedFile is set, functions which have no code in any of the
+  /// requested files are skipped after their profile counts are looked up, so
+  /// that they are still included in getMismatchedCount().
   static Expected<std::unique_ptr<CoverageMapping>>
   load(ArrayRef<StringRef> ObjectFilenames, StringRef ProfileFilename,
-       ArrayRef<StringRef> Arches = None, StringRef CompilationDir = "");
+       ArrayRef<StringRef> Arches = None, StringRef CompilationDir = "",
+       FilenameFilter IsRequestedFile = nullptr);
 
   /// The number of functions that couldn't have their profiles mapped.
   ///
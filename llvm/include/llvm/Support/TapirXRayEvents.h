@@ -0,0 +1,54 @@
+//===- TapirXRayEvents.h - Format of XRay events for Tapir ------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the payload format of the XRay custom events that Tapir
+// lowering emits at spawn, sync, task-entry and continuation points. It is
+// shared by the compiler, which writes the payloads, and the XRay library,
+// which decodes them (see llvm/XRay/TapirEvents.h).
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_SUPPORT_TAPIRXRAYEVENTS_H
+#define LLVM_SUPPORT_TAPIRXRAYEVENTS_H
+
+#include <cstdint>
+
+namespace llvm {
+namespace xray {
+
+/// The points in a parallel program at which Tapir lowering can emit an XRay
+/// custom event.
+enum class TapirEventKind : uint16_t {
+  /// The spawner is about to detach a task.
+  Spawn = 1,
+  /// A spawned task has started to execute.
+  TaskEntry = 2,
+  /// The continuation of a spawn has started to execute. When this happens on
+  /// a different thread than the matching Spawn event, the continuation was
+  /// stolen.
+  Continue = 3,
+  /// The spawner is about to sync.
+  Sync = 4,
+};
+
+/// The first four bytes of every Tapir event payload ("TPIR").
+constexpr uint32_t TapirEventMagic = 0x52495054;
+
+/// The size in bytes of a Tapir event payload. The payload is laid out as
+/// follows, in the byte order of the traced program:
+///
+///   (4)   uint32 : magic
+///   (2)   uint16 : event kind
+///   (2)   uint16 : site number within the function
+///   (8)   uint64 : GUID of the function containing the site
+///   (8)   uint64 : frame address of the spawner
+constexpr uint32_t TapirEventSize = 24;
+
+} // namespace xray
+} // namespace llvm
+
+#endif // LLVM_SUPPORT_TAPIRXRAYEVENTS_H
@@ -47,6 +47,11 @@ void CheckAssert(SMLoc Loc, Init *Condition, Init *Message);
 extern SourceMgr SrcMgr;
 extern unsigned ErrorsPrinted;
 
+/// If set, the diagnostics printed by the functions above are also written to
+/// this stream, without colors. `-memo` uses it to print the diagnostics of a
+/// backend again when it reuses the backend's output.
+extern raw_ostream *CapturedDiagnostics;
+
 } // end namespace "llvm"
 
 #endif
@@ -13,6 +13,8 @@
 #ifndef LLVM_TABLEGEN_MAIN_H
 #define LLVM_TABLEGEN_MAIN_H
 
+#include "llvm/ADT/ArrayRef.h"
+
 namespace llvm {
 
 class raw_ostream;
@@ -22,7 +24,11 @@ class RecordKeeper;
 /// Returns true on error, false otherwise.
 using TableGenMainFn = bool (raw_ostream &OS, RecordKeeper &Records);
 
-int TableGenMain(const char *argv0, TableGenMainFn *MainFn);
+/// Parse the input file and run MainFn on it. \p Args is the command line the
+/// tool was invoked with; tools that pass it support the `-memo` option, which
+/// needs it to tell apart the memos of different invocations.
+int TableGenMain(const char *argv0, TableGenMainFn *MainFn,
+                 ArrayRef<const char *> Args = None);
 
 } // end namespace llvm
 
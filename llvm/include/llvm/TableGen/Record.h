@@ -34,6 +34,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -1786,6 +1787,14 @@ class RecordKeeper {
   using RecordMap = std::map<std::string, std::unique_ptr<Record>, std::less<>>;
   using GlobalMap = std::map<std::string, Init *, std::less<>>;
 
+public:
+  /// The kinds of lookups that are recorded by recordQueries().
+  enum QueryKind { DefQuery, ClassQuery, GlobalQuery, DerivedQuery, AllQuery };
+  using Query = std::pair<QueryKind, std::string>;
+  using QuerySet = std::set<Query>;
+
+private:
+
   std::string InputFilename;
   RecordMap Classes, Defs;
   mutable StringMap<std::vector<Record *>> ClassRecordsMap;
@@ -1800,33 +1809,53 @@ class RecordKeeper {
   Timer *LastTimer = nullptr;
   bool BackendTimer = false;
 
+  // The set the lookups are recorded into, if any.
+  mutable QuerySet *Queries = nullptr;
+
+  void noteQuery(QueryKind Kind, StringRef Name = "") const {
+    if (Queries)
+      Queries->emplace(Kind, std::string(Name));
+  }
+
 public:
   /// Get the main TableGen input file's name.
   const std::string getInputFilename() const { return InputFilename; }
 
   /// Get the map of classes.
-  const RecordMap &getClasses() const { return Classes; }
+  const RecordMap &getClasses() const {
+    noteQuery(AllQuery);
+    return Classes;
+  }
 
   /// Get the map of records (defs).
-  const RecordMap &getDefs() const { return Defs; }
+  const RecordMap &getDefs() const {
+    noteQuery(AllQuery);
+    return Defs;
+  }
 
   /// Get the map of global variables.
-  const GlobalMap &getGlobals() const { return ExtraGlobals; }
+  const GlobalMap &getGlobals() const {
+    noteQuery(AllQuery);
+    return ExtraGlobals;
+  }
 
   /// Get the class with the specified name.
   Record *getClass(StringRef Name) const {
+    noteQuery(ClassQuery, Name);
     auto I = Classes.find(Name);
     return I == Classes.end() ? nullptr : I->second.get();
   }
 
   /// Get the concrete record with the specified name.
   Record *getDef(StringRef Name) const {
+    noteQuery(DefQuery, Name);
     auto I = Defs.find(Name);
     return I == Defs.end() ? nullptr : I->second.get();
   }
 
   /// Get the \p Init value of the specified global variable.
   Init *getGlobal(StringRef Name) const {
+    noteQuery(GlobalQuery, Name);
     if (Record *R = getDef(Name))
       return R->getDefInit();
     auto It = ExtraGlobals.find(Name);
@@ -1884,6 +1913,12 @@ public:
       delete TimingGroup;
   }
 
+  /// Record the lookups made through the accessors of this keeper into \p Qs,
+  /// or stop recording if it is null. A backend can only reach the records
+  /// found by these lookups and the ones they reference, so its output stays
+  /// the same as long as those records do.
+  void recordQueries(QuerySet *Qs) const { Queries = Qs; }
+
   //===--------------------------------------------------------------------===//
   // High-level helper methods, useful for tablegen backends.
 
@@ -42,6 +42,18 @@ public:
   static bool isRequired() { return true; }
 };
 
+/// Public interface to the pass that records the spawn sites of Tapir tasks for
+/// the memory profiler.
+///
+/// This pass must run before Tapir lowering. It inserts calls that tell the
+/// MemProfiler runtime which spawn site the task running on the current thread
+/// came from, so that allocations can be attributed to spawn sites.
+class MemProfTaskSitesPass : public PassInfoMixin<MemProfTaskSitesPass> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+  static bool isRequired() { return true; }
+};
+
 // Insert MemProfiler instrumentation
 FunctionPass *createMemProfilerFunctionPass();
 ModulePass *createModuleMemProfilerLegacyPassPass();
@@ -25,6 +25,10 @@ class Module;
 /// Splits the module M into N linkable partitions. The function ModuleCallback
 /// is called N times passing each individual partition as the MPart argument.
 ///
+/// If BalanceBySize is set, the partitions are balanced on the number of
+/// instructions they contain rather than on their number of globals, so that
+/// they take about the same time to code generate.
+///
 /// FIXME: This function does not deal with the somewhat subtle symbol
 /// visibility issues around module splitting, including (but not limited to):
 ///
@@ -35,7 +39,7 @@ class Module;
 void SplitModule(
     Module &M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals = false);
+    bool PreserveLocals = false, bool BalanceBySize = false);
 
 } // end namespace llvm
 
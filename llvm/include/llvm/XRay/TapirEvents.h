@@ -0,0 +1,47 @@
+//===- TapirEvents.h - XRay custom events for Tapir tasks -------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a function to decode the payloads of the XRay custom events
+// that Tapir lowering emits at spawn, sync, task-entry and continuation points
+// from the custom event records of a trace. The payload format itself is
+// defined in llvm/Support/TapirXRayEvents.h.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_XRAY_TAPIREVENTS_H
+#define LLVM_XRAY_TAPIREVENTS_H
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/TapirXRayEvents.h"
+#include <cstdint>
+
+namespace llvm {
+namespace xray {
+
+/// A decoded Tapir event payload.
+struct TapirEvent {
+  TapirEventKind Kind;
+
+  /// Together with FunctionGUID, identifies the detach or sync that produced
+  /// this event.
+  uint16_t Site;
+  uint64_t FunctionGUID;
+
+  /// Identifies the spawning frame, so that the Spawn, TaskEntry and Continue
+  /// events of one spawn can be matched up across threads.
+  uint64_t Frame;
+};
+
+/// Decodes the data of a custom event record as a Tapir event. Returns None if
+/// the data is not a Tapir event payload.
+Optional<TapirEvent> decodeTapirEvent(StringRef Data, bool IsLittleEndian);
+
+} // namespace xray
+} // namespace llvm
+
+#endif // LLVM_XRAY_TAPIREVENTS_H
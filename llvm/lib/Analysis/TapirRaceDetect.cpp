@@ -13,9 +13,11 @@
 
 #include "llvm/Analysis/TapirRaceDetect.h"
 #include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SCCIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasSetTracker.h"
+#include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/CaptureTracking.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
 #include "llvm/Analysis/LoopAccessAnalysis.h"
@@ -28,6 +30,7 @@
 #include "llvm/Analysis/VectorUtils.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
@@ -79,6 +82,17 @@ TapirRaceDetect::run(Function &F, FunctionAnalysisManager &FAM) {
 
 AnalysisKey TapirRaceDetect::Key;
 
+TapirRaceSummaryAnalysis::Result
+TapirRaceSummaryAnalysis::run(Module &M, ModuleAnalysisManager &MAM) {
+  auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  auto GetTLI = [&FAM](Function &F) -> const TargetLibraryInfo & {
+    return FAM.getResult<TargetLibraryAnalysis>(F);
+  };
+  return RaceSummaryInfo(M, MAM.getResult<CallGraphAnalysis>(M), GetTLI);
+}
+
+AnalysisKey TapirRaceSummaryAnalysis::Key;
+
 INITIALIZE_PASS_BEGIN(TapirRaceDetectWrapperPass, "tapir-race-detect",
                       "Tapir Race Detection", true, true)
 INITIALIZE_PASS_DEPENDENCY(DependenceAnalysisWrapperPass)
@@ -137,6 +151,21 @@ TapirRaceDetectPrinterPass::run(Function &F, FunctionAnalysisManager &FAM) {
   return PreservedAnalyses::all();
 }
 
+PreservedAnalyses
+TapirRaceSummaryPrinterPass::run(Module &M, ModuleAnalysisManager &MAM) {
+  OS << "'Tapir race summaries' for module '" << M.getName() << "':\n";
+  MAM.getResult<TapirRaceSummaryAnalysis>(M).print(OS);
+  return PreservedAnalyses::all();
+}
+
+bool RaceSummaryInfo::invalidate(Module &M, const PreservedAnalyses &PA,
+                                 ModuleAnalysisManager::Invalidator &Inv) {
+  // The summaries depend on the code of every function in the module, so they
+  // are only valid if they were explicitly preserved.
+  auto PAC = PA.getChecker<TapirRaceSummaryAnalysis>();
+  return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Module>>());
+}
+
 bool RaceInfo::invalidate(Function &F, const PreservedAnalyses &PA,
                           FunctionAnalysisManager::Invalidator &Inv) {
   // Check whether the analysis, all analyses on functions, or the function's
@@ -289,9 +318,10 @@ public:
   AccessPtrAnalysis(DominatorTree &DT, TaskInfo &TI, LoopInfo &LI,
                     DependenceInfo &DI, ScalarEvolution &SE,
                     const TargetLibraryInfo *TLI,
+                    const RaceSummaryInfo *Summaries,
                     AccessToUnderlyingObjMap &AccessToObjs)
       : DT(DT), TI(TI), LI(LI), DI(DI), AA(DI.getAA()), SE(SE), TLI(TLI),
-        AccessToObjs(AccessToObjs), MPTasksInLoop(LI) {
+        Summaries(Summaries), AccessToObjs(AccessToObjs), MPTasksInLoop(LI) {
     TI.evaluateParallelState<MaybeParallelTasks>(MPTasks);
 
     std::vector<std::string> AllABIListFiles;
@@ -339,6 +369,7 @@ private:
   ScalarEvolution &SE;
 
   const TargetLibraryInfo *TLI;
+  const RaceSummaryInfo *Summaries;
   SmallPtrSet<Value *, 4> ArgumentPtrs;
   AccessToUnderlyingObjMap &AccessToObjs;
 
@@ -471,7 +502,7 @@ static bool checkInstructionForRace(const Instruction *I,
 // derived for I, false otherwise.
 static void GetGeneralAccesses(
     Instruction *I, SmallVectorImpl<GeneralAccess> &AccI, AliasAnalysis *AA,
-    const TargetLibraryInfo *TLI) {
+    const TargetLibraryInfo *TLI, const RaceSummaryInfo *Summaries) {
   // Handle common memory instructions
   if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
     MemoryLocation Loc = MemoryLocation::get(LI);
@@ -549,6 +580,12 @@ static void GetGeneralAccesses(
       }
     }
 
+    // Get the race summary of the called function, if there is one.
+    const FunctionRaceSummary *Summary = nullptr;
+    if (Summaries)
+      if (const Function *Called = Call->getCalledFunction())
+        Summary = Summaries->getSummary(Called);
+
     for (auto IdxArgPair : enumerate(Call->args())) {
       int ArgIdx = IdxArgPair.index();
       const Value *Arg = IdxArgPair.value();
@@ -560,6 +597,8 @@ static void GetGeneralAccesses(
         continue;
       ModRefInfo ArgMask = AA->getArgModRefInfo(Call, ArgIdx);
       ArgMask = intersectModRef(CallMask, ArgMask);
+      if (Summary)
+        ArgMask = intersectModRef(ArgMask, Summary->getArgModRef(ArgIdx));
       if (!isNoModRef(ArgMask)) {
         // dbgs() << "New GA for " << *I << "\n  arg " << *Arg << "\n";
         // if (ArgLoc.Size != LocationSize::unknown())
@@ -573,12 +612,253 @@ static void GetGeneralAccesses(
     if (AssumeSafeMalloc && isFreeCall(Call, TLI))
       return;
 
-    if (!Call->onlyAccessesArgMemory())
-      // Add a generic GeneralAccess for this call to represent the fact that it
-      // might access arbitrary global memory.
-      AccI.push_back(GeneralAccess(I, None, CallMask));
+    if (Call->onlyAccessesArgMemory())
+      return;
+
+    // If the summary of the called function describes all of the memory it
+    // accesses, add a GeneralAccess for each global variable it accesses.
+    if (Summary && !Summary->AccessesUnknownMemory) {
+      for (const auto &GlobalMR : Summary->GlobalMR) {
+        ModRefInfo GlobalMask = intersectModRef(CallMask, GlobalMR.second);
+        if (!isNoModRef(GlobalMask))
+          AccI.push_back(GeneralAccess(
+              I, MemoryLocation::getBeforeOrAfter(GlobalMR.first),
+              GlobalMask));
+      }
+      return;
+    }
+
+    // Add a generic GeneralAccess for this call to represent the fact that it
+    // might access arbitrary global memory.
+    AccI.push_back(GeneralAccess(I, None, CallMask));
+    return;
+  }
+}
+
+namespace {
+/// Accumulates the memory accesses of a function into its race summary.
+class RaceSummaryBuilder {
+public:
+  RaceSummaryBuilder(FunctionRaceSummary &Summary, const TargetLibraryInfo &TLI)
+      : Summary(Summary), TLI(TLI) {}
+
+  void addAccess(const Value *Ptr, ModRefInfo MRI);
+  void addGlobalAccess(const GlobalVariable *GV, ModRefInfo MRI);
+  void addUnknownAccess();
+  void addCall(const CallBase &Call, const FunctionRaceSummary *CalledSummary);
+
+  /// Returns true if any access added so far changed the summary.
+  bool changed() const { return Changed; }
+
+private:
+  void unionInto(ModRefInfo &Dst, ModRefInfo MRI) {
+    ModRefInfo New = unionModRef(Dst, MRI);
+    if (New != Dst) {
+      Dst = New;
+      Changed = true;
+    }
+  }
+
+  FunctionRaceSummary &Summary;
+  const TargetLibraryInfo &TLI;
+  bool Changed = false;
+};
+} // end anonymous namespace
+
+void RaceSummaryBuilder::addUnknownAccess() {
+  if (Summary.AccessesUnknownMemory)
+    return;
+  Summary.AccessesUnknownMemory = true;
+  Changed = true;
+}
+
+void RaceSummaryBuilder::addGlobalAccess(const GlobalVariable *GV,
+                                         ModRefInfo MRI) {
+  // Constant variables cannot race.
+  if (GV->isConstant())
+    return;
+  auto It = Summary.GlobalMR.find(GV);
+  if (It == Summary.GlobalMR.end()) {
+    Summary.GlobalMR.insert(std::make_pair(GV, MRI));
+    Changed = true;
     return;
   }
+  unionInto(It->second, MRI);
+}
+
+void RaceSummaryBuilder::addAccess(const Value *Ptr, ModRefInfo MRI) {
+  if (isNoModRef(MRI) || Summary.AccessesUnknownMemory)
+    return;
+  if (!Ptr->getType()->isPointerTy()) {
+    addUnknownAccess();
+    return;
+  }
+
+  SmallVector<const Value *, 4> Objects;
+  getUnderlyingObjects(Ptr, Objects, nullptr, 0);
+  for (const Value *Obj : Objects) {
+    // Objects allocated by the function itself cannot race with its callers.
+    if (isa<AllocaInst>(Obj) || (AssumeSafeMalloc && isAllocationFn(Obj, &TLI)))
+      continue;
+    if (isa<ConstantPointerNull>(Obj) || isa<UndefValue>(Obj) ||
+        isa<Function>(Obj))
+      continue;
+
+    if (const Argument *A = dyn_cast<Argument>(Obj)) {
+      // A byval argument is a copy local to the function.
+      if (A->hasByValAttr())
+        continue;
+      unionInto(Summary.ArgMR[A->getArgNo()], MRI);
+      continue;
+    }
+
+    if (const GlobalVariable *GV = dyn_cast<GlobalVariable>(Obj)) {
+      addGlobalAccess(GV, MRI);
+      continue;
+    }
+
+    // The access is through a pointer the summary cannot describe, e.g., one
+    // loaded from memory.
+    addUnknownAccess();
+    return;
+  }
+}
+
+void RaceSummaryBuilder::addCall(const CallBase &Call,
+                                 const FunctionRaceSummary *CalledSummary) {
+  if (Call.doesNotAccessMemory())
+    return;
+
+  if (const AnyMemIntrinsic *MI = dyn_cast<AnyMemIntrinsic>(&Call)) {
+    addAccess(MI->getRawDest(), ModRefInfo::Mod);
+    if (const AnyMemTransferInst *MTI = dyn_cast<AnyMemTransferInst>(MI))
+      addAccess(MTI->getRawSource(), ModRefInfo::Ref);
+    return;
+  }
+
+  // Map the summary of the called function onto the arguments of this call.
+  if (CalledSummary) {
+    if (CalledSummary->AccessesUnknownMemory) {
+      addUnknownAccess();
+      return;
+    }
+    // A recursive call adds no global accesses beyond the summary's own.
+    if (CalledSummary != &Summary)
+      for (const auto &GlobalMR : CalledSummary->GlobalMR)
+        addGlobalAccess(GlobalMR.first, GlobalMR.second);
+    for (auto IdxArgPair : enumerate(Call.args()))
+      addAccess(IdxArgPair.value(),
+                CalledSummary->getArgModRef(IdxArgPair.index()));
+    return;
+  }
+
+  // Otherwise rely on the attributes of the call.
+  if (!Call.onlyAccessesArgMemory()) {
+    addUnknownAccess();
+    return;
+  }
+  for (auto IdxArgPair : enumerate(Call.args())) {
+    unsigned ArgIdx = IdxArgPair.index();
+    const Value *Arg = IdxArgPair.value();
+    if (!Arg->getType()->isPtrOrPtrVectorTy() ||
+        Call.doesNotAccessMemory(ArgIdx))
+      continue;
+    addAccess(Arg, (Call.onlyReadsMemory() || Call.onlyReadsMemory(ArgIdx))
+                       ? ModRefInfo::Ref
+                       : ModRefInfo::ModRef);
+  }
+}
+
+RaceSummaryInfo::RaceSummaryInfo(
+    Module &M, CallGraph &CG,
+    function_ref<const TargetLibraryInfo &(Function &)> GetTLI)
+    : M(M) {
+  // Visit the SCCs of the call graph bottom-up, so that the summaries of
+  // called functions are available when summarizing their callers.
+  for (scc_iterator<CallGraph *> SCCI = scc_begin(&CG); !SCCI.isAtEnd();
+       ++SCCI) {
+    SmallVector<Function *, 4> SCCFunctions;
+    for (CallGraphNode *Node : *SCCI) {
+      Function *F = Node->getFunction();
+      // Only summarize functions whose definition is the one that will run.
+      if (!F || F->isDeclaration() || !F->hasExactDefinition())
+        continue;
+      Summaries[F].ArgMR.assign(F->arg_size(), ModRefInfo::NoModRef);
+      SCCFunctions.push_back(F);
+    }
+
+    // Recursive calls see the summaries of the functions in the SCC computed
+    // so far, so iterate until those summaries stop changing.
+    bool Changed;
+    do {
+      Changed = false;
+      for (Function *F : SCCFunctions)
+        Changed |= computeSummary(*F, GetTLI(*F));
+    } while (Changed && SCCI.hasCycle());
+  }
+}
+
+bool RaceSummaryInfo::computeSummary(Function &F,
+                                     const TargetLibraryInfo &TLI) {
+  FunctionRaceSummary &Summary = Summaries.find(&F)->second;
+  RaceSummaryBuilder Builder(Summary, TLI);
+  for (Instruction &I : instructions(F)) {
+    if (Summary.AccessesUnknownMemory)
+      break;
+    if (!I.mayReadOrWriteMemory() || !checkInstructionForRace(&I, &TLI))
+      continue;
+
+    if (const LoadInst *LI = dyn_cast<LoadInst>(&I))
+      Builder.addAccess(LI->getPointerOperand(), ModRefInfo::Ref);
+    else if (const StoreInst *SI = dyn_cast<StoreInst>(&I))
+      Builder.addAccess(SI->getPointerOperand(), ModRefInfo::Mod);
+    else if (const AtomicRMWInst *RMWI = dyn_cast<AtomicRMWInst>(&I))
+      Builder.addAccess(RMWI->getPointerOperand(), ModRefInfo::ModRef);
+    else if (const AtomicCmpXchgInst *CXI = dyn_cast<AtomicCmpXchgInst>(&I))
+      Builder.addAccess(CXI->getPointerOperand(), ModRefInfo::ModRef);
+    else if (const VAArgInst *VAAI = dyn_cast<VAArgInst>(&I))
+      Builder.addAccess(VAAI->getPointerOperand(), ModRefInfo::ModRef);
+    else if (const CallBase *Call = dyn_cast<CallBase>(&I))
+      Builder.addCall(*Call, Call->getCalledFunction()
+                                 ? getSummary(Call->getCalledFunction())
+                                 : nullptr);
+    else
+      Builder.addUnknownAccess();
+  }
+  return Builder.changed();
+}
+
+static void printModRef(ModRefInfo MRI, raw_ostream &OS) {
+  if (isModSet(MRI))
+    OS << " Mod";
+  if (isRefSet(MRI))
+    OS << " Ref";
+}
+
+void RaceSummaryInfo::print(raw_ostream &OS) const {
+  for (const Function &F : M) {
+    const FunctionRaceSummary *Summary = getSummary(&F);
+    if (!Summary)
+      continue;
+    OS << "Race summary for function '" << F.getName() << "':\n";
+    if (Summary->AccessesUnknownMemory) {
+      OS << "  Unknown memory\n";
+      continue;
+    }
+    for (const Argument &Arg : F.args()) {
+      ModRefInfo MRI = Summary->ArgMR[Arg.getArgNo()];
+      if (isNoModRef(MRI))
+        continue;
+      OS << "  Arg " << Arg.getArgNo() << ":";
+      printModRef(MRI, OS);
+      OS << "\n";
+    }
+    for (const auto &GlobalMR : Summary->GlobalMR) {
+      OS << "  Global @" << GlobalMR.first->getName() << ":";
+      printModRef(GlobalMR.second, OS);
+      OS << "\n";
+    }
+  }
 }
 
 void AccessPtrAnalysis::addFunctionArgument(Value *Arg) {
@@ -608,7 +888,7 @@ void AccessPtrAnalysis::addAccess(Instruction *I) {
     }
 
     SmallVector<GeneralAccess, 1> GA;
-    GetGeneralAccesses(I, GA, DI.getAA(), TLI);
+    GetGeneralAccesses(I, GA, DI.getAA(), TLI, Summaries);
     TaskAccessMap[TI.getTaskFor(I->getParent())].append(GA.begin(), GA.end());
     SpindleAccessMap[TI.getSpindleFor(I->getParent())].append(GA.begin(),
                                                               GA.end());
@@ -1972,15 +2252,17 @@ void AccessPtrAnalysis::processAccessPtrs(
 
 RaceInfo::RaceInfo(Function *F, DominatorTree &DT, LoopInfo &LI, TaskInfo &TI,
                    DependenceInfo &DI, ScalarEvolution &SE,
-                   const TargetLibraryInfo *TLI)
-    : F(F), DT(DT), LI(LI), TI(TI), DI(DI), SE(SE), TLI(TLI) {
+                   const TargetLibraryInfo *TLI,
+                   const RaceSummaryInfo *Summaries)
+    : F(F), DT(DT), LI(LI), TI(TI), DI(DI), SE(SE), TLI(TLI),
+      Summaries(Summaries) {
   analyzeFunction();
 }
 
 void RaceInfo::getObjectsFor(Instruction *I,
                              SmallPtrSetImpl<const Value *> &Objects) {
   SmallVector<GeneralAccess, 1> GA;
-  GetGeneralAccesses(I, GA, DI.getAA(), TLI);
+  GetGeneralAccesses(I, GA, DI.getAA(), TLI, Summaries);
   for (GeneralAccess Acc : GA) {
     // Skip this access if it does not have a valid pointer.
     if (!Acc.getPtr())
@@ -2055,7 +2337,7 @@ void RaceInfo::analyzeFunction() {
   // At a high level, we need to identify pairs of instructions that might
   // execute in parallel and alias.
 
-  AccessPtrAnalysis APA(DT, TI, LI, DI, SE, TLI, AccessToObjs);
+  AccessPtrAnalysis APA(DT, TI, LI, DI, SE, TLI, Summaries, AccessToObjs);
   // Record pointer arguments to this function
   for (Argument &Arg : F->args())
     if (Arg.getType()->isPtrOrPtrVectorTy())
@@ -167,6 +167,32 @@ DIEAbbrev &DIEAbbrevSet::uniqueAbbreviation(DIE &Die) {
   return *New;
 }
 
+DIEAbbrev &DIEAbbrevSet::uniqueAbbreviation(const DIEAbbrev &Abbrev) {
+  FoldingSetNodeID ID;
+  Abbrev.Profile(ID);
+
+  void *InsertPos;
+  if (DIEAbbrev *Existing =
+          AbbreviationsSet.FindNodeOrInsertPos(ID, InsertPos))
+    return *Existing;
+
+  // Copy the abbreviation data, the node itself belongs to the other set.
+  DIEAbbrev *New = new (Alloc) DIEAbbrev(Abbrev.getTag(), Abbrev.hasChildren());
+  for (const DIEAbbrevData &AttrData : Abbrev.getData()) {
+    if (AttrData.getForm() == dwarf::DW_FORM_implicit_const)
+      New->AddImplicitConstAttribute(AttrData.getAttribute(),
+                                     AttrData.getValue());
+    else
+      New->AddAttribute(AttrData.getAttribute(), AttrData.getForm());
+  }
+  Abbreviations.push_back(New);
+  New->setNumber(Abbreviations.size());
+
+  // Store it for lookup.
+  AbbreviationsSet.InsertNode(New, InsertPos);
+  return *New;
+}
+
 void DIEAbbrevSet::Emit(const AsmPrinter *AP, MCSection *Section) const {
   if (!Abbreviations.empty()) {
     // Start the debug abbrev section.
@@ -311,6 +337,25 @@ unsigned DIE::computeOffsetsAndAbbrevs(const dwarf::FormParams &FormParams,
   return CUOffset;
 }
 
+unsigned DIE::computeOffsets(const dwarf::FormParams &FormParams,
+                             ArrayRef<unsigned> AbbrevNumbers,
+                             unsigned CUOffset) {
+  setAbbrevNumber(AbbrevNumbers[getAbbrevNumber()]);
+  setOffset(CUOffset);
+  CUOffset += getULEB128Size(getAbbrevNumber());
+  for (const auto &V : values())
+    CUOffset += V.sizeOf(FormParams);
+
+  if (hasChildren()) {
+    for (auto &Child : children())
+      CUOffset = Child.computeOffsets(FormParams, AbbrevNumbers, CUOffset);
+    CUOffset += sizeof(int8_t);
+  }
+
+  setSize(CUOffset - getOffset());
+  return CUOffset;
+}
+
 //===----------------------------------------------------------------------===//
 // DIEUnit Implementation
 //===----------------------------------------------------------------------===//
@@ -14,11 +14,19 @@
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Parallel.h"
 #include <algorithm>
 #include <cstdint>
 
 using namespace llvm;
 
+static cl::opt<bool>
+    ParallelUnitLayout("dwarf-parallel-unit-layout", cl::Hidden,
+                       cl::desc("Compute the DIE offsets and abbreviations of "
+                                "the compile units concurrently"),
+                       cl::init(false));
+
 DwarfFile::DwarfFile(AsmPrinter *AP, StringRef Pref, BumpPtrAllocator &DA)
     : Asm(AP), Abbrevs(AbbrevAllocator), StrPool(DA, *Asm, Pref) {}
 
@@ -62,18 +70,65 @@ void DwarfFile::computeSizeAndOffsets() {
 
   // Iterate over each compile unit and set the size and offsets for each
   // DIE within each compile unit. All offsets are CU relative.
+  SmallVector<DwarfUnit *, 1> Units;
+  bool Abandoned = false;
   for (const auto &TheU : CUs) {
     if (TheU->getCUNode()->isDebugDirectivesOnly())
       continue;
 
     // Skip CUs that ended up not being needed (split CUs that were abandoned
     // because they added no information beyond the non-split CU)
-    if (llvm::empty(TheU->getUnitDie().values()))
-      return;
+    if (llvm::empty(TheU->getUnitDie().values())) {
+      Abandoned = true;
+      break;
+    }
+    Units.push_back(TheU.get());
+  }
+
+  SmallVector<unsigned, 1> UnitSizes(Units.size());
+  if (Units.size() > 1 && ParallelUnitLayout) {
+    // Unique the abbreviations of each unit in a set of its own, which lets
+    // the units be laid out concurrently. Merging the sets in unit order then
+    // numbers the abbreviations like laying out the units one after the other
+    // would.
+    struct UnitAbbrevs {
+      BumpPtrAllocator Alloc;
+      DIEAbbrevSet Abbrevs{Alloc};
+      SmallVector<unsigned, 0> Numbers;
+    };
+    std::vector<UnitAbbrevs> PerUnit(Units.size());
+    const dwarf::FormParams FormParams = Asm->getDwarfFormParams();
+    // The unit DIE follows the unit header, as in
+    // computeSizeAndOffsetsForUnit().
+    auto GetUnitDieOffset = [&](size_t I) {
+      return Asm->getUnitLengthFieldByteSize() + Units[I]->getHeaderSize();
+    };
+    parallelForEachN(0, Units.size(), [&](size_t I) {
+      Units[I]->getUnitDie().computeOffsetsAndAbbrevs(
+          FormParams, PerUnit[I].Abbrevs, GetUnitDieOffset(I));
+    });
+    for (UnitAbbrevs &U : PerUnit) {
+      // Abbreviation numbers start at 1.
+      U.Numbers.push_back(0);
+      for (const DIEAbbrev *Abbrev : U.Abbrevs.getAbbreviations())
+        U.Numbers.push_back(Abbrevs.uniqueAbbreviation(*Abbrev).getNumber());
+    }
+    // The size of the abbreviation codes may have changed with the numbers.
+    parallelForEachN(0, Units.size(), [&](size_t I) {
+      UnitSizes[I] = Units[I]->getUnitDie().computeOffsets(
+          FormParams, PerUnit[I].Numbers, GetUnitDieOffset(I));
+    });
+  } else {
+    for (size_t I = 0, E = Units.size(); I != E; ++I)
+      UnitSizes[I] = computeSizeAndOffsetsForUnit(Units[I]);
+  }
 
-    TheU->setDebugSectionOffset(SecOffset);
-    SecOffset += computeSizeAndOffsetsForUnit(TheU.get());
+  for (size_t I = 0, E = Units.size(); I != E; ++I) {
+    Units[I]->setDebugSectionOffset(SecOffset);
+    SecOffset += UnitSizes[I];
   }
+  if (Abandoned)
+    return;
   if (SecOffset > UINT32_MAX && !Asm->isDwarf64())
     report_fatal_error("The generated debug information is too large "
                        "for the 32-bit DWARF format.");
@@ -93,6 +93,6 @@ void llvm::splitCodeGen(
               // copied into the thread's context.
               std::move(BC));
         },
-        PreserveLocals);
+        PreserveLocals, /*BalanceBySize=*/true);
   }
 }
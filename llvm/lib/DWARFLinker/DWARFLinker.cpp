@@ -2349,7 +2349,32 @@ bool DWARFLinker::link() {
       Options.TheAccelTableKind = AccelTableKind::Apple;
   }
 
-  for (LinkContext &OptContext : ObjectContexts) {
+  // Extracting the DIEs of every compile unit is the bulk of the first phase
+  // below, and it only touches the DWARFContext of its own object file. Unless
+  // running single threaded, extract them for all the object files in
+  // parallel, while the first phase registers the module references of each
+  // object file serially and in order.
+  std::vector<std::shared_future<void>> ExtractedFiles(NumObjects);
+  Optional<ThreadPool> ExtractPool;
+  if (Options.Threads != 1) {
+    ExtractPool.emplace(hardware_concurrency(Options.Threads));
+    for (unsigned I = 0, E = NumObjects; I != E; ++I) {
+      DWARFFile &File = ObjectContexts[I].File;
+      if (!File.Warnings.empty() || !File.Dwarf ||
+          (LLVM_LIKELY(!Options.Update) && !File.Addresses->hasValidRelocs()))
+        continue;
+      ExtractedFiles[I] = ExtractPool->async([&File]() {
+        for (const auto &CU : File.Dwarf->compile_units())
+          CU->getUnitDIE(/*ExtractUnitDIEOnly=*/false);
+      });
+    }
+  }
+
+  for (unsigned I = 0, E = NumObjects; I != E; ++I) {
+    LinkContext &OptContext = ObjectContexts[I];
+    if (ExtractedFiles[I].valid())
+      ExtractedFiles[I].wait();
+
     if (Options.Verbose) {
       if (DwarfLinkerClientID == DwarfLinkerClient::Dsymutil)
         outs() << "DEBUG MAP OBJECT: " << OptContext.File.FileName << "\n";
@@ -2401,6 +2426,7 @@ bool DWARFLinker::link() {
                                 OptContext.File.Dwarf->isLittleEndian());
     }
   }
+  ExtractPool.reset();
 
   // If we haven't seen any CUs, pick an arbitrary valid Dwarf version anyway.
   if (MaxDwarfVersion == 0)
@@ -718,7 +718,9 @@ DWARFTypeUnit *DWARFContext::getTypeUnitForHash(uint16_t Version, uint64_t Hash,
     }
   }
 
-  return (*Units.Map)[Hash];
+  // Don't insert missing hashes, so that lookups don't modify the map once it
+  // has been built.
+  return Units.Map->lookup(Hash);
 }
 
 DWARFCompileUnit *DWARFContext::getDWOCompileUnitForHash(uint64_t Hash) {
@@ -18,6 +18,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
 #include "llvm/Support/DJB.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
@@ -318,24 +319,71 @@ bool DWARFVerifier::handleDebugAbbrev() {
   return NumErrors == 0;
 }
 
+namespace {
+/// Buffers the output of a unit that is verified in parallel with others.
+/// Colors are used if the stream it is eventually printed to uses them.
+class BufferedUnitOutput : public raw_string_ostream {
+  bool HasColors;
+
+public:
+  BufferedUnitOutput(std::string &Buffer, const raw_ostream &OS)
+      : raw_string_ostream(Buffer), HasColors(OS.has_colors()) {
+    // WithColor checks has_colors(), but changeColor() is a no-op unless
+    // colors are enabled, which they are not for string streams.
+    enable_colors(OS.colors_enabled());
+  }
+  bool has_colors() const override { return HasColors; }
+};
+} // namespace
+
 unsigned DWARFVerifier::verifyUnits(const DWARFUnitVector &Units) {
   unsigned NumDebugInfoErrors = 0;
   ReferenceMap CrossUnitReferences;
 
-  unsigned Index = 1;
+  // Extracting the DIEs and parsing the line table of a unit lazily updates
+  // state shared between units, so do that for all of them up front. The same
+  // goes for the maps used to look up type units by signature. The units can
+  // then be verified in parallel, each by its own verifier, and their output
+  // is printed in unit order afterwards.
   for (const auto &Unit : Units) {
-    OS << "Verifying unit: " << Index << " / " << Units.getNumUnits();
-    if (const char* Name = Unit->getUnitDIE(true).getShortName())
-      OS << ", \"" << Name << '\"';
-    OS << '\n';
-    OS.flush();
+    Unit->getUnitDIE(/* ExtractUnitDIEOnly = */ false);
+    DCtx.getLineTableForUnit(Unit.get());
+  }
+  for (bool IsDWO : {false, true})
+    DCtx.getTypeUnitForHash(/*Version=*/5, /*Hash=*/0, IsDWO);
+
+  struct UnitResult {
+    std::string Output;
+    unsigned NumErrors = 0;
+    ReferenceMap CrossUnitReferences;
+  };
+  std::vector<UnitResult> Results(Units.size());
+  parallelForEachN(0, Units.size(), [&](size_t I) {
+    DWARFUnit *Unit = Units[I].get();
+    UnitResult &Result = Results[I];
+    BufferedUnitOutput UnitOS(Result.Output, OS);
+    DWARFVerifier UnitVerifier(UnitOS, DCtx, DumpOpts);
+
+    UnitOS << "Verifying unit: " << I + 1 << " / " << Units.getNumUnits();
+    if (const char *Name = Unit->getUnitDIE(true).getShortName())
+      UnitOS << ", \"" << Name << '\"';
+    UnitOS << '\n';
     ReferenceMap UnitLocalReferences;
-    NumDebugInfoErrors +=
-        verifyUnitContents(*Unit, UnitLocalReferences, CrossUnitReferences);
-    NumDebugInfoErrors += verifyDebugInfoReferences(
-        UnitLocalReferences, [&](uint64_t Offset) { return Unit.get(); });
-    ++Index;
+    Result.NumErrors += UnitVerifier.verifyUnitContents(
+        *Unit, UnitLocalReferences, Result.CrossUnitReferences);
+    Result.NumErrors += UnitVerifier.verifyDebugInfoReferences(
+        UnitLocalReferences, [&](uint64_t Offset) { return Unit; });
+    UnitOS.flush();
+  });
+
+  for (UnitResult &Result : Results) {
+    OS << Result.Output;
+    NumDebugInfoErrors += Result.NumErrors;
+    for (auto &Reference : Result.CrossUnitReferences)
+      CrossUnitReferences[Reference.first].insert(Reference.second.begin(),
+                                                  Reference.second.end());
   }
+  OS.flush();
 
   NumDebugInfoErrors += verifyDebugInfoReferences(
       CrossUnitReferences, [&](uint64_t Offset) -> DWARFUnit * {
@@ -491,7 +491,7 @@ static void splitCodeGen(const Config &C, TargetMachine *TM,
             // copied into the thread's context.
             std::move(BC), ThreadCount++);
       },
-      false);
+      /*PreserveLocals=*/false, /*BalanceBySize=*/true);
 
   // Because the inner lambda (which runs in a worker thread) captures our local
   // variables, we need to wait for the worker threads to terminate before we
@@ -410,12 +410,20 @@ void MCAsmLayout::layoutFragment(MCFragment *F) {
 
   ++stats::FragmentLayouts;
 
+  // The size of a fragment can depend on the layout of other sections, e.g.
+  // through the count of a .fill, which needs to be laid out again if those
+  // change.
+  const MCSection *Reader = CurrentSection;
+  if (CurrentSection)
+    CurrentSection = F->getParent();
+
   // Compute fragment offset and size.
   if (Prev)
     F->Offset = Prev->Offset + getAssembler().computeFragmentSize(*this, *Prev);
   else
     F->Offset = 0;
   F->IsBeingLaidOut = false;
+  CurrentSection = Reader;
   LastValidFragment[F->getParent()] = F;
 
   // If bundling is enabled and this fragment has instructions in it, it has to
@@ -833,14 +841,26 @@ void MCAssembler::layout(MCAsmLayout &Layout) {
   }
 
   // Layout until everything fits.
-  while (layoutOnce(Layout)) {
+  SmallVector<MCSection *, 16> Sections;
+  for (MCSection &Sec : *this)
+    Sections.push_back(&Sec);
+  SmallPtrSet<const MCSection *, 16> Affected;
+  while (layoutOnce(Layout, Sections, Affected)) {
     if (getContext().hadError())
       return;
     // Size of fragments in one section can depend on the size of fragments in
     // another. If any fragment has changed size, we have to re-layout (and
-    // as a result possibly further relax) all.
-    for (MCSection &Sec : *this)
+    // as a result possibly further relax) the sections that read the layout
+    // of its section. The others would not change in another iteration.
+    Layout.addAffectedSections(Affected);
+    Sections.clear();
+    for (MCSection &Sec : *this) {
+      if (!Affected.count(&Sec))
+        continue;
       Layout.invalidateFragmentsFrom(&*Sec.begin());
+      Sections.push_back(&Sec);
+    }
+    Affected.clear();
   }
 
   DEBUG_WITH_TYPE("mc-dump", {
@@ -1211,16 +1231,19 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
   return false;
 }
 
-bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
+bool MCAssembler::layoutOnce(MCAsmLayout &Layout,
+                             ArrayRef<MCSection *> Sections,
+                             SmallPtrSetImpl<const MCSection *> &Relaxed) {
   ++stats::RelaxationSteps;
 
-  bool WasRelaxed = false;
-  for (MCSection &Sec : *this) {
-    while (layoutSectionOnce(Layout, Sec))
-      WasRelaxed = true;
+  for (MCSection *Sec : Sections) {
+    Layout.setRelaxingSection(Sec);
+    while (layoutSectionOnce(Layout, *Sec))
+      Relaxed.insert(Sec);
   }
+  Layout.setRelaxingSection(nullptr);
 
-  return WasRelaxed;
+  return !Relaxed.empty();
 }
 
 void MCAssembler::finishLayout(MCAsmLayout &Layout) {
@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/MC/MCFragment.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
@@ -48,8 +49,30 @@ bool MCAsmLayout::isFragmentValid(const MCFragment *F) const {
   return F->getLayoutOrder() <= LastValid->getLayoutOrder();
 }
 
+void MCAsmLayout::noteRead(const MCSection *Sec) const {
+  SmallVectorImpl<const MCSection *> &SecReaders = Readers[Sec];
+  if (!is_contained(SecReaders, CurrentSection))
+    SecReaders.push_back(CurrentSection);
+}
+
+void MCAsmLayout::addAffectedSections(
+    SmallPtrSetImpl<const MCSection *> &Sections) const {
+  SmallVector<const MCSection *, 16> Worklist(Sections.begin(),
+                                              Sections.end());
+  while (!Worklist.empty()) {
+    auto It = Readers.find(Worklist.pop_back_val());
+    if (It == Readers.end())
+      continue;
+    for (const MCSection *Reader : It->second)
+      if (Sections.insert(Reader).second)
+        Worklist.push_back(Reader);
+  }
+}
+
 bool MCAsmLayout::canGetFragmentOffset(const MCFragment *F) const {
   MCSection *Sec = F->getParent();
+  if (CurrentSection && CurrentSection != Sec)
+    noteRead(Sec);
   MCSection::iterator I;
   if (MCFragment *LastValid = LastValidFragment[Sec]) {
     // Fragment already valid, offset is available.
@@ -79,6 +102,8 @@ void MCAsmLayout::invalidateFragmentsFrom(MCFragment *F) {
 
 void MCAsmLayout::ensureValid(const MCFragment *F) const {
   MCSection *Sec = F->getParent();
+  if (CurrentSection && CurrentSection != Sec)
+    noteRead(Sec);
   MCSection::iterator I;
   if (MCFragment *Cur = LastValidFragment[Sec])
     I = ++MCSection::iterator(Cur);
@@ -229,8 +229,8 @@ static unsigned getMaxCounterID(const CounterMappingContext &Ctx,
 }
 
 Error CoverageMapping::loadFunctionRecord(
-    const CoverageMappingRecord &Record,
-    IndexedInstrProfReader &ProfileReader) {
+    const CoverageMappingRecord &Record, IndexedInstrProfReader &ProfileReader,
+    FilenameFilter IsRequestedFile) {
   StringRef OrigFuncName = Record.FunctionName;
   if (OrigFuncName.empty())
     return make_error<CoverageMapError>(coveragemap_error::malformed);
@@ -254,6 +254,12 @@ Error CoverageMapping::loadFunctionRecord(
       return make_error<InstrProfError>(IPE);
     Counts.assign(getMaxCounterID(Ctx, Record) + 1, 0);
   }
+
+  // Skip the region evaluation for functions which have no code in the
+  // requested files. This is only done after the profile lookup, so that hash
+  // mismatches are counted the same way whether or not files are requested.
+  if (IsRequestedFile && llvm::none_of(Record.Filenames, IsRequestedFile))
+    return Error::success();
   Ctx.setCounts(Counts);
 
   assert(!Record.MappingRegions.empty() && "Function has no regions");
@@ -310,13 +316,15 @@ Error CoverageMapping::loadFunctionRecord(
 // of CoverageMappingReader instances.
 Error CoverageMapping::loadFromReaders(
     ArrayRef<std::unique_ptr<CoverageMappingReader>> CoverageReaders,
-    IndexedInstrProfReader &ProfileReader, CoverageMapping &Coverage) {
+    IndexedInstrProfReader &ProfileReader, CoverageMapping &Coverage,
+    FilenameFilter IsRequestedFile) {
   for (const auto &CoverageReader : CoverageReaders) {
     for (auto RecordOrErr : *CoverageReader) {
       if (Error E = RecordOrErr.takeError())
         return E;
       const auto &Record = *RecordOrErr;
-      if (Error E = Coverage.loadFunctionRecord(Record, ProfileReader))
+      if (Error E = Coverage.loadFunctionRecord(Record, ProfileReader,
+                                                IsRequestedFile))
         return E;
     }
   }
@@ -325,9 +333,10 @@ Error CoverageMapping::loadFromReaders(
 
 Expected<std::unique_ptr<CoverageMapping>> CoverageMapping::load(
     ArrayRef<std::unique_ptr<CoverageMappingReader>> CoverageReaders,
-    IndexedInstrProfReader &ProfileReader) {
+    IndexedInstrProfReader &ProfileReader, FilenameFilter IsRequestedFile) {
   auto Coverage = std::unique_ptr<CoverageMapping>(new CoverageMapping());
-  if (Error E = loadFromReaders(CoverageReaders, ProfileReader, *Coverage))
+  if (Error E = loadFromReaders(CoverageReaders, ProfileReader, *Coverage,
+                                IsRequestedFile))
     return std::move(E);
   return std::move(Coverage);
 }
@@ -345,7 +354,8 @@ static Error handleMaybeNoDataFoundError(Error E) {
 Expected<std::unique_ptr<CoverageMapping>>
 CoverageMapping::load(ArrayRef<StringRef> ObjectFilenames,
                       StringRef ProfileFilename, ArrayRef<StringRef> Arches,
-                      StringRef CompilationDir) {
+                      StringRef CompilationDir,
+                      FilenameFilter IsRequestedFile) {
   auto ProfileReaderOrErr = IndexedInstrProfReader::create(ProfileFilename);
   if (Error E = ProfileReaderOrErr.takeError())
     return std::move(E);
@@ -376,7 +386,8 @@ CoverageMapping::load(ArrayRef<StringRef> ObjectFilenames,
     for (auto &Reader : CoverageReadersOrErr.get())
       Readers.push_back(std::move(Reader));
     DataFound |= !Readers.empty();
-    if (Error E = loadFromReaders(Readers, *ProfileReader, *Coverage))
+    if (Error E = loadFromReaders(Readers, *ProfileReader, *Coverage,
+                                  IsRequestedFile))
       return std::move(E);
   }
   // If no readers were created, either no objects were provided or none of them
@@ -23,6 +23,15 @@ namespace llvm {
 
 SourceMgr SrcMgr;
 unsigned ErrorsPrinted = 0;
+raw_ostream *CapturedDiagnostics = nullptr;
+
+static void PrintSourceMessage(SMLoc Loc, SourceMgr::DiagKind Kind,
+                               const Twine &Msg) {
+  SrcMgr.PrintMessage(Loc, Kind, Msg);
+  if (CapturedDiagnostics)
+    SrcMgr.PrintMessage(*CapturedDiagnostics, Loc, Kind, Msg, None, None,
+                        /*ShowColors=*/false);
+}
 
 static void PrintMessage(ArrayRef<SMLoc> Loc, SourceMgr::DiagKind Kind,
                          const Twine &Msg) {
@@ -34,16 +43,19 @@ static void PrintMessage(ArrayRef<SMLoc> Loc, SourceMgr::DiagKind Kind,
   SMLoc NullLoc;
   if (Loc.empty())
     Loc = NullLoc;
-  SrcMgr.PrintMessage(Loc.front(), Kind, Msg);
+  PrintSourceMessage(Loc.front(), Kind, Msg);
   for (unsigned i = 1; i < Loc.size(); ++i)
-    SrcMgr.PrintMessage(Loc[i], SourceMgr::DK_Note,
-                        "instantiated from multiclass");
+    PrintSourceMessage(Loc[i], SourceMgr::DK_Note,
+                       "instantiated from multiclass");
 }
 
 // Functions to print notes.
 
 void PrintNote(const Twine &Msg) {
   WithColor::note() << Msg << "\n";
+  if (CapturedDiagnostics)
+    WithColor::note(*CapturedDiagnostics, "", /*DisableColors=*/true)
+        << Msg << "\n";
 }
 
 void PrintNote(ArrayRef<SMLoc> NoteLoc, const Twine &Msg) {
@@ -86,26 +98,36 @@ void PrintFatalNote(const RecordVal *RecVal, const Twine &Msg) {
 
 // Functions to print warnings.
 
-void PrintWarning(const Twine &Msg) { WithColor::warning() << Msg << "\n"; }
+void PrintWarning(const Twine &Msg) {
+  WithColor::warning() << Msg << "\n";
+  if (CapturedDiagnostics)
+    WithColor::warning(*CapturedDiagnostics, "", /*DisableColors=*/true)
+        << Msg << "\n";
+}
 
 void PrintWarning(ArrayRef<SMLoc> WarningLoc, const Twine &Msg) {
   PrintMessage(WarningLoc, SourceMgr::DK_Warning, Msg);
 }
 
 void PrintWarning(const char *Loc, const Twine &Msg) {
-  SrcMgr.PrintMessage(SMLoc::getFromPointer(Loc), SourceMgr::DK_Warning, Msg);
+  PrintSourceMessage(SMLoc::getFromPointer(Loc), SourceMgr::DK_Warning, Msg);
 }
 
 // Functions to print errors.
 
-void PrintError(const Twine &Msg) { WithColor::error() << Msg << "\n"; }
+void PrintError(const Twine &Msg) {
+  WithColor::error() << Msg << "\n";
+  if (CapturedDiagnostics)
+    WithColor::error(*CapturedDiagnostics, "", /*DisableColors=*/true)
+        << Msg << "\n";
+}
 
 void PrintError(ArrayRef<SMLoc> ErrorLoc, const Twine &Msg) {
   PrintMessage(ErrorLoc, SourceMgr::DK_Error, Msg);
 }
 
 void PrintError(const char *Loc, const Twine &Msg) {
-  SrcMgr.PrintMessage(SMLoc::getFromPointer(Loc), SourceMgr::DK_Error, Msg);
+  PrintSourceMessage(SMLoc::getFromPointer(Loc), SourceMgr::DK_Error, Msg);
 }
 
 // This method takes a Record and uses the source location
@@ -16,8 +16,11 @@
 
 #include "llvm/TableGen/Main.h"
 #include "TGParser.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/TableGen/Error.h"
@@ -50,6 +53,12 @@ MacroNames("D", cl::desc("Name of the macro to be defined"),
 static cl::opt<bool>
 WriteIfChanged("write-if-changed", cl::desc("Only write output if it changed"));
 
+static cl::opt<std::string>
+MemoFilename("memo",
+             cl::desc("Reuse the existing output if none of the records the "
+                      "backend looked up changed since the memo was written"),
+             cl::value_desc("filename"), cl::init(""));
+
 static cl::opt<bool>
 TimePhases("time-phases", cl::desc("Time phases of parser and backend"));
 
@@ -85,7 +94,268 @@ static int createDependencyFile(const TGParser &Parser, const char *argv0) {
   return 0;
 }
 
-int llvm::TableGenMain(const char *argv0, TableGenMainFn *MainFn) {
+static std::string getDigest(MD5 &Hash) {
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return std::string(Result.digest());
+}
+
+/// Identify the invocation for `-memo`: the tool binary, the working directory
+/// and the command line, including the contents of response files.
+static std::string hashInvocation(const char *argv0,
+                                  ArrayRef<const char *> Args) {
+  MD5 Hash;
+  std::string Exe =
+      sys::fs::getMainExecutable(argv0, (void *)(intptr_t)&reportError);
+  Hash.update(Exe);
+  sys::fs::file_status Status;
+  if (!sys::fs::status(Exe, Status)) {
+    Hash.update(utostr(Status.getSize()));
+    Hash.update(
+        utostr(Status.getLastModificationTime().time_since_epoch().count()));
+  }
+  SmallString<128> CWD;
+  if (!sys::fs::current_path(CWD))
+    Hash.update(CWD);
+  for (StringRef Arg : Args) {
+    Hash.update(StringRef(Arg.data(), Arg.size() + 1));
+    if (Arg.startswith("@"))
+      if (auto RspOrErr = MemoryBuffer::getFile(Arg.drop_front()))
+        Hash.update((*RspOrErr)->getBuffer());
+  }
+  return getDigest(Hash);
+}
+
+/// Add the records that \p I refers to to \p Worklist. Returns false if \p I
+/// is of a kind whose references are not followed here, in which case it must
+/// be assumed to refer to any record.
+static bool addReferencedRecords(Init *I, SmallVectorImpl<Record *> &Worklist) {
+  auto AddAll = [&](ArrayRef<Init *> Inits) {
+    return llvm::all_of(
+        Inits, [&](Init *I) { return addReferencedRecords(I, Worklist); });
+  };
+  if (isa<UnsetInit, BitInit, IntInit, StringInit, AnonymousNameInit,
+          VarInit>(I))
+    return true;
+  if (auto *DI = dyn_cast<DefInit>(I)) {
+    Worklist.push_back(DI->getDef());
+    return true;
+  }
+  if (auto *LI = dyn_cast<ListInit>(I))
+    return AddAll(LI->getValues());
+  if (auto *DI = dyn_cast<DagInit>(I))
+    return addReferencedRecords(DI->getOperator(), Worklist) &&
+           AddAll(DI->getArgs());
+  if (auto *BI = dyn_cast<BitsInit>(I)) {
+    for (unsigned i = 0, e = BI->getNumBits(); i != e; ++i)
+      if (!addReferencedRecords(BI->getBit(i), Worklist))
+        return false;
+    return true;
+  }
+  if (auto *VBI = dyn_cast<VarBitInit>(I))
+    return addReferencedRecords(VBI->getBitVar(), Worklist);
+  if (auto *VLI = dyn_cast<VarListElementInit>(I))
+    return addReferencedRecords(VLI->getVariable(), Worklist);
+  if (auto *FI = dyn_cast<FieldInit>(I))
+    return addReferencedRecords(FI->getRecord(), Worklist);
+  if (auto *VDI = dyn_cast<VarDefInit>(I)) {
+    // The type of an anonymous instantiation is the class it instantiates.
+    for (Record *Class : cast<RecordRecTy>(VDI->getType())->getClasses())
+      Worklist.push_back(Class);
+    return AddAll(VDI->args());
+  }
+  if (auto *OI = dyn_cast<OpInit>(I)) {
+    for (unsigned i = 0, e = OI->getNumOperands(); i != e; ++i)
+      if (!addReferencedRecords(OI->getOperand(i), Worklist))
+        return false;
+    return true;
+  }
+  if (auto *CI = dyn_cast<CondOpInit>(I))
+    return AddAll(CI->getConds()) && AddAll(CI->getVals());
+  // FoldOpInit and IsAOpInit do not expose their operands.
+  return false;
+}
+
+/// Hash everything that a backend which made the lookups in \p Queries can
+/// observe of \p Records: the results of the lookups, and the contents,
+/// locations and relative order of all the records reachable from them.
+static std::string hashQueriedRecords(const RecordKeeper &Records,
+                                      const RecordKeeper::QuerySet &Queries) {
+  MD5 Hash;
+  SmallVector<Record *, 64> Worklist;
+  auto AddRecord = [&](Record *R) {
+    Hash.update(R ? R->getName() : "<none>");
+    Hash.update("\n");
+    if (R)
+      Worklist.push_back(R);
+  };
+  // Set if some value refers to records in a way that is not followed.
+  bool ReachesAll = false;
+  auto AddGlobal = [&](Init *I) {
+    Hash.update(I ? I->getAsString() : "<none>");
+    Hash.update("\n");
+    if (I && !addReferencedRecords(I, Worklist))
+      ReachesAll = true;
+  };
+
+  for (const RecordKeeper::Query &Q : Queries) {
+    Hash.update(utostr(Q.first) + " " + Q.second + "\n");
+    switch (Q.first) {
+    case RecordKeeper::DefQuery:
+      AddRecord(Records.getDef(Q.second));
+      break;
+    case RecordKeeper::ClassQuery:
+      AddRecord(Records.getClass(Q.second));
+      break;
+    case RecordKeeper::GlobalQuery:
+      AddGlobal(Records.getGlobal(Q.second));
+      break;
+    case RecordKeeper::DerivedQuery:
+      // The class may have been removed since the memo was written.
+      if (!Records.getClass(Q.second)) {
+        AddRecord(nullptr);
+        break;
+      }
+      for (Record *R : Records.getAllDerivedDefinitions(Q.second))
+        AddRecord(R);
+      break;
+    case RecordKeeper::AllQuery:
+      for (const auto &C : Records.getClasses())
+        AddRecord(C.second.get());
+      for (const auto &D : Records.getDefs())
+        AddRecord(D.second.get());
+      for (const auto &G : Records.getGlobals()) {
+        Hash.update(G.first);
+        AddGlobal(G.second);
+      }
+      break;
+    }
+  }
+
+  SmallPtrSet<Record *, 32> Seen;
+  std::vector<Record *> Reachable;
+  auto AddReachable = [&] {
+    while (!Worklist.empty()) {
+      Record *R = Worklist.pop_back_val();
+      if (!Seen.insert(R).second)
+        continue;
+      Reachable.push_back(R);
+      for (const auto &SC : R->getSuperClasses())
+        Worklist.push_back(SC.first);
+      for (const RecordVal &RV : R->getValues())
+        if (!addReferencedRecords(RV.getValue(), Worklist))
+          ReachesAll = true;
+    }
+  };
+  AddReachable();
+  if (ReachesAll) {
+    for (const auto &C : Records.getClasses())
+      Worklist.push_back(C.second.get());
+    for (const auto &D : Records.getDefs())
+      Worklist.push_back(D.second.get());
+    AddReachable();
+  }
+
+  // Backends commonly emit records in the order they were defined, and some
+  // of them print where they were defined.
+  llvm::sort(Reachable, LessRecordByID());
+  std::string Text;
+  raw_string_ostream OS(Text);
+  for (Record *R : Reachable) {
+    OS << (R->isClass() ? "class " : "def ") << *R;
+    for (SMLoc Loc : R->getLoc())
+      if (unsigned Buf = SrcMgr.FindBufferContainingLoc(Loc))
+        OS << SrcMgr.getBufferInfo(Buf).Buffer->getBufferIdentifier() << ':'
+           << SrcMgr.FindLineNumber(Loc, Buf) << '\n';
+    Hash.update(OS.str());
+    Text.clear();
+  }
+  return getDigest(Hash);
+}
+
+namespace {
+/// What a backend run that can be skipped would produce.
+struct MemoizedRun {
+  std::string Output;
+  /// The diagnostics the backend printed, see CapturedDiagnostics.
+  std::string Diagnostics;
+};
+} // end anonymous namespace
+
+/// Return the contents of the output file and the diagnostics of the backend
+/// if the memo written by a previous run shows they are what the backend would
+/// produce for \p Records.
+///
+/// The memo holds the invocation, the hash of the output, the hash of what
+/// the lookups the backend made observed, the number of lookups and the
+/// lookups themselves, one per line, followed by the text of the diagnostics.
+static Optional<MemoizedRun> reuseMemoizedRun(const RecordKeeper &Records,
+                                              StringRef Invocation) {
+  auto MemoOrErr = MemoryBuffer::getFile(MemoFilename, /*IsText=*/true);
+  if (!MemoOrErr)
+    return None;
+  StringRef Memo = (*MemoOrErr)->getBuffer();
+  auto NextLine = [&Memo] {
+    StringRef Line;
+    std::tie(Line, Memo) = Memo.split('\n');
+    return Line;
+  };
+  if (NextLine() != Invocation)
+    return None;
+  StringRef OutDigest = NextLine();
+  StringRef RecordsDigest = NextLine();
+  unsigned NumQueries;
+  if (NextLine().getAsInteger(10, NumQueries))
+    return None;
+
+  RecordKeeper::QuerySet Queries;
+  for (unsigned I = 0; I != NumQueries; ++I) {
+    StringRef Line = NextLine();
+    unsigned Kind;
+    if (Line.consumeInteger(10, Kind) || Kind > RecordKeeper::AllQuery ||
+        !Line.consume_front(" "))
+      return None;
+    Queries.emplace(RecordKeeper::QueryKind(Kind), std::string(Line));
+  }
+
+  auto OutOrErr = MemoryBuffer::getFile(OutputFilename, /*IsText=*/true);
+  if (!OutOrErr)
+    return None;
+  MD5 OutHash;
+  OutHash.update((*OutOrErr)->getBuffer());
+  if (getDigest(OutHash) != OutDigest)
+    return None;
+
+  if (hashQueriedRecords(Records, Queries) != RecordsDigest)
+    return None;
+  return MemoizedRun{std::string((*OutOrErr)->getBuffer()), std::string(Memo)};
+}
+
+/// Create the memo for `-memo` option.
+static int createMemoFile(const RecordKeeper &Records,
+                          const RecordKeeper::QuerySet &Queries,
+                          StringRef Invocation, StringRef Output,
+                          StringRef Diagnostics, const char *argv0) {
+  std::error_code EC;
+  ToolOutputFile MemoOut(MemoFilename, EC, sys::fs::OF_Text);
+  if (EC)
+    return reportError(argv0, "error opening " + MemoFilename + ":" +
+                                  EC.message() + "\n");
+  MD5 OutHash;
+  OutHash.update(Output);
+  MemoOut.os() << Invocation << '\n'
+               << getDigest(OutHash) << '\n'
+               << hashQueriedRecords(Records, Queries) << '\n'
+               << Queries.size() << '\n';
+  for (const RecordKeeper::Query &Q : Queries)
+    MemoOut.os() << Q.first << ' ' << Q.second << '\n';
+  MemoOut.os() << Diagnostics;
+  MemoOut.keep();
+  return 0;
+}
+
+int llvm::TableGenMain(const char *argv0, TableGenMainFn *MainFn,
+                       ArrayRef<const char *> Args) {
   RecordKeeper Records;
 
   if (TimePhases)
@@ -115,14 +385,45 @@ int llvm::TableGenMain(const char *argv0, TableGenMainFn *MainFn) {
     return 1;
   Records.stopTimer();
 
+  std::string Invocation;
+  Optional<MemoizedRun> Memoized;
+  if (!MemoFilename.empty()) {
+    if (OutputFilename == "-")
+      return reportError(argv0,
+                         "the option -memo must be used together with -o\n");
+    if (Args.empty())
+      return reportError(argv0,
+                         "the option -memo is not supported by this tool\n");
+    Records.startTimer("Check memo");
+    Invocation = hashInvocation(argv0, Args);
+    Memoized = reuseMemoizedRun(Records, Invocation);
+    Records.stopTimer();
+  }
+
   // Write output to memory.
-  Records.startBackendTimer("Backend overall");
   std::string OutString;
   raw_string_ostream Out(OutString);
-  unsigned status = MainFn(Out, Records);
-  Records.stopBackendTimer();
-  if (status)
-    return 1;
+  RecordKeeper::QuerySet Queries;
+  std::string Diagnostics;
+  raw_string_ostream DiagnosticsOS(Diagnostics);
+  if (Memoized) {
+    // None of the records the backend can observe changed, so it would write
+    // the same output and print the same diagnostics again.
+    OutString = std::move(Memoized->Output);
+    errs() << Memoized->Diagnostics;
+  } else {
+    Records.startBackendTimer("Backend overall");
+    if (!MemoFilename.empty()) {
+      Records.recordQueries(&Queries);
+      CapturedDiagnostics = &DiagnosticsOS;
+    }
+    unsigned status = MainFn(Out, Records);
+    Records.recordQueries(nullptr);
+    CapturedDiagnostics = nullptr;
+    Records.stopBackendTimer();
+    if (status)
+      return 1;
+  }
 
   // Always write the depfile, even if the main output hasn't changed.
   // If it's missing, Ninja considers the output dirty.  If this was below
@@ -154,7 +455,14 @@ int llvm::TableGenMain(const char *argv0, TableGenMainFn *MainFn) {
     if (ErrorsPrinted == 0)
       OutFile.keep();
   }
-  
+
+  if (!MemoFilename.empty() && !Memoized && ErrorsPrinted == 0) {
+    Records.startTimer("Write memo");
+    if (int Ret = createMemoFile(Records, Queries, Invocation, Out.str(),
+                                 DiagnosticsOS.str(), argv0))
+      return Ret;
+  }
+
   Records.stopTimer();
   Records.stopPhaseTiming();
 
@@ -2737,7 +2737,7 @@ void RecordKeeper::stopBackendTimer() {
 // the same vectors multiple times.
 std::vector<Record *> RecordKeeper::getAllDerivedDefinitions(
     StringRef ClassName) const {
-
+  noteQuery(DerivedQuery, ClassName);
   auto Pair = ClassRecordsMap.try_emplace(ClassName);
   if (Pair.second)
     Pair.first->second = getAllDerivedDefinitions(makeArrayRef(ClassName));
@@ -2748,24 +2748,25 @@ std::vector<Record *> RecordKeeper::getAllDerivedDefinitions(
 std::vector<Record *> RecordKeeper::getAllDerivedDefinitions(
     ArrayRef<StringRef> ClassNames) const {
   SmallVector<Record *, 2> ClassRecs;
-  std::vector<Record *> Defs;
+  std::vector<Record *> Result;
 
   assert(ClassNames.size() > 0 && "At least one class must be passed.");
   for (const auto &ClassName : ClassNames) {
+    noteQuery(DerivedQuery, ClassName);
     Record *Class = getClass(ClassName);
     if (!Class)
       PrintFatalError("The class '" + ClassName + "' is not defined\n");
     ClassRecs.push_back(Class);
   }
 
-  for (const auto &OneDef : getDefs()) {
+  for (const auto &OneDef : Defs) {
     if (all_of(ClassRecs, [&OneDef](const Record *Class) {
                             return OneDef.second->isSubClassOf(Class);
                           }))
-      Defs.push_back(OneDef.second.get());
+      Result.push_back(OneDef.second.get());
   }
 
-  return Defs;
+  return Result;
 }
 
 Init *MapResolver::resolve(Init *VarName) {
@@ -23,6 +23,7 @@
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
 #include "llvm/Analysis/GlobalsModRef.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
@@ -2112,8 +2113,14 @@ Value *CilkSanitizerImpl::Instrumentor::getNoAliasMAAPValue(
       continue;
 
     // If we can tell statically that these two memory locations don't alias,
-    // move on.
-    if (!AA->alias(Loc, getMemoryLocation(I, OtherRD.OperandNum, TLI)))
+    // move on.  Accesses of a call that are not through one of its operands
+    // are to global variables named by the race summary of the callee.
+    MemoryLocation OtherLoc =
+        (isa<CallBase>(I) && !isa<AnyMemIntrinsic>(I) &&
+         OtherRD.OperandNum == static_cast<unsigned>(-1))
+            ? MemoryLocation::getBeforeOrAfter(OtherRD.getPtr())
+            : getMemoryLocation(I, OtherRD.OperandNum, TLI);
+    if (!AA->alias(Loc, OtherLoc))
       continue;
 
     // We trust that the MAAP value in LocalMAAPs[] for this object Obj, set by
@@ -4858,10 +4865,6 @@ PreservedAnalyses CilkSanitizerPass::run(Module &M, ModuleAnalysisManager &AM) {
     [&FAM](Function &F) -> LoopInfo & {
       return FAM.getResult<LoopAnalysis>(F);
     };
-  auto GetRI =
-    [&FAM](Function &F) -> RaceInfo & {
-      return FAM.getResult<TapirRaceDetect>(F);
-    };
   auto GetTLI =
     [&FAM](Function &F) -> TargetLibraryInfo & {
       return FAM.getResult<TargetLibraryAnalysis>(F);
@@ -4873,6 +4876,24 @@ PreservedAnalyses CilkSanitizerPass::run(Module &M, ModuleAnalysisManager &AM) {
   bool Changed =
       CilkSanitizerImpl(M, &CG, GetDT, nullptr, GetLI, nullptr, GetTLI, nullptr)
           .setup(false);
+  // Summarize the memory accesses of each function, so that the race analysis
+  // of a caller can look through its calls.  The summaries are computed after
+  // setup and handed to the race analysis of each function directly, so they
+  // describe the code being instrumented.
+  RaceSummaryInfo Summaries(M, CG, GetTLI);
+  DenseMap<Function *, std::unique_ptr<RaceInfo>> RaceInfos;
+  auto GetRI =
+    [&FAM, &Summaries, &RaceInfos](Function &F) -> RaceInfo & {
+      std::unique_ptr<RaceInfo> &RI = RaceInfos[&F];
+      if (!RI)
+        RI = std::make_unique<RaceInfo>(
+            &F, FAM.getResult<DominatorTreeAnalysis>(F),
+            FAM.getResult<LoopAnalysis>(F), FAM.getResult<TaskAnalysis>(F),
+            FAM.getResult<DependenceAnalysis>(F),
+            FAM.getResult<ScalarEvolutionAnalysis>(F),
+            &FAM.getResult<TargetLibraryAnalysis>(F), &Summaries);
+      return *RI;
+    };
   Changed |=
       CilkSanitizerImpl(M, &CG, GetDT, GetTI, GetLI, GetRI, GetTLI, GetSE)
           .run();
@@ -15,13 +15,16 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Transforms/Instrumentation/MemProfiler.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/TapirTaskInfo.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalValue.h"
 #include "llvm/IR/IRBuilder.h"
@@ -35,9 +38,11 @@
 #include "llvm/Pass.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Instrumentation.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "llvm/Transforms/Utils/TapirUtils.h"
 
 using namespace llvm;
 
@@ -64,6 +69,9 @@ constexpr char MemProfShadowMemoryDynamicAddress[] =
 
 constexpr char MemProfFilenameVar[] = "__memprof_profile_filename";
 
+constexpr char MemProfSetTaskSiteName[] = "__memprof_set_task_site";
+constexpr char MemProfGetTaskSiteName[] = "__memprof_get_task_site";
+
 // Command-line flags.
 
 static cl::opt<bool> ClInsertVersionCheck(
@@ -300,6 +308,100 @@ ModulePass *llvm::createModuleMemProfilerLegacyPassPass() {
   return new ModuleMemProfilerLegacyPass();
 }
 
+// Returns a name for the spawn site of the task detached by DI, using its debug
+// location if available.
+static std::string getTaskSiteName(const DetachInst &DI, unsigned SiteNum) {
+  std::string Name;
+  raw_string_ostream OS(Name);
+  if (const DILocation *Loc = DI.getDebugLoc())
+    OS << Loc->getFilename() << ":" << Loc->getLine() << ":" << Loc->getColumn()
+       << " in ";
+  OS << DI.getFunction()->getName();
+  if (!DI.getDebugLoc())
+    OS << " spawn #" << SiteNum;
+  return OS.str();
+}
+
+PreservedAnalyses MemProfTaskSitesPass::run(Function &F,
+                                            FunctionAnalysisManager &AM) {
+  if (F.getName().startswith("__memprof_"))
+    return PreservedAnalyses::all();
+
+  SmallVector<DetachInst *, 8> Detaches;
+  SmallVector<SyncInst *, 8> Syncs;
+  for (BasicBlock &BB : F) {
+    if (DetachInst *DI = dyn_cast<DetachInst>(BB.getTerminator()))
+      Detaches.push_back(DI);
+    else if (SyncInst *SI = dyn_cast<SyncInst>(BB.getTerminator()))
+      Syncs.push_back(SI);
+  }
+  if (Detaches.empty())
+    return PreservedAnalyses::all();
+
+  Module &M = *F.getParent();
+  IRBuilder<> IRB(&*F.getEntryBlock().getFirstInsertionPt());
+  Type *SiteTy = IRB.getInt8PtrTy();
+  AttributeList FnAttrs =
+      AttributeList().addFnAttribute(M.getContext(), Attribute::NoUnwind);
+  FunctionCallee SetTaskSite = M.getOrInsertFunction(
+      MemProfSetTaskSiteName, FnAttrs, IRB.getVoidTy(), SiteTy);
+  FunctionCallee GetTaskSite =
+      M.getOrInsertFunction(MemProfGetTaskSiteName, FnAttrs, SiteTy);
+
+  // Remember the site of the task that called F.  Execution of F resumes after
+  // a spawn or a sync possibly on a different thread, which must then be told
+  // that it is running that task again.
+  Value *ParentSite = IRB.CreateCall(GetTaskSite, {}, "memprof.task.site");
+
+  auto SetSiteAt = [&](Instruction *InsertPt, Value *Site) {
+    IRBuilder<> B(InsertPt);
+    B.CreateCall(SetTaskSite, {Site});
+  };
+
+  DenseMap<const DetachInst *, Value *> TaskSites;
+  unsigned SiteNum = 0;
+  for (DetachInst *DI : Detaches)
+    TaskSites[DI] = IRB.CreateGlobalStringPtr(
+        getTaskSiteName(*DI, SiteNum++), "memprof.task.site.name", 0, &M);
+
+  // Code that runs in a task spawned within F resumes that task's site rather
+  // than the site of F's caller.
+  TaskInfo &TI = AM.getResult<TaskAnalysis>(F);
+  auto GetResumedSite = [&](BasicBlock *BB) {
+    Task *T = TI.getTaskFor(BB);
+    if (T->isRootTask())
+      return ParentSite;
+    return TaskSites[T->getDetach()];
+  };
+
+  SmallPtrSet<BasicBlock *, 8> Resumed;
+  for (DetachInst *DI : Detaches) {
+    SetSiteAt(&*DI->getDetached()->getFirstInsertionPt(), TaskSites[DI]);
+    BasicBlock *Cont = DI->getContinue();
+    if (Resumed.insert(Cont).second)
+      SetSiteAt(&*Cont->getFirstInsertionPt(), GetResumedSite(Cont));
+  }
+  for (SyncInst *SI : Syncs) {
+    // Lowering expects a sync.unwind to immediately follow its sync, so resume
+    // the site after the sync.unwind, if there is one.
+    BasicBlock *SyncCont = SI->getSuccessor(0);
+    Instruction *InsertPt = &*SyncCont->getFirstInsertionPt();
+    Instruction *SyncUnwind = SyncCont->getFirstNonPHIOrDbgOrLifetime();
+    if (isSyncUnwind(SyncUnwind, SI->getSyncRegion())) {
+      if (InvokeInst *II = dyn_cast<InvokeInst>(SyncUnwind))
+        InsertPt = &*II->getNormalDest()->getFirstInsertionPt();
+      else
+        InsertPt = SyncUnwind->getNextNode();
+    }
+    if (Resumed.insert(InsertPt->getParent()).second)
+      SetSiteAt(InsertPt, GetResumedSite(InsertPt->getParent()));
+  }
+
+  PreservedAnalyses PA;
+  PA.preserveSet<CFGAnalyses>();
+  return PA;
+}
+
 Value *MemProfiler::memToShadow(Value *Shadow, IRBuilder<> &IRB) {
   // (Shadow & mask) >> scale
   Shadow = IRB.CreateAnd(Shadow, Mapping.Mask);
@@ -131,6 +131,17 @@ void OpenCilkABI::setOptions(const TapirTargetOptions &Options) {
   RuntimeBCPath = OptionsCast.getRuntimeBCPath();
 }
 
+// Mark the memory accesses in runtime-ABI function \p Fn with nosanitize
+// metadata.
+static void markRuntimeAccessesNoSanitize(Function &Fn) {
+  LLVMContext &C = Fn.getContext();
+  MDNode *NoSanitize = MDNode::get(C, None);
+  for (Instruction &I : instructions(Fn))
+    if (isa<MemIntrinsic>(I) ||
+        (I.mayReadOrWriteMemory() && !isa<CallBase>(I)))
+      I.setMetadata("nosanitize", NoSanitize);
+}
+
 void OpenCilkABI::prepareModule() {
   LLVMContext &C = M.getContext();
   Type *Int8Ty = Type::getInt8Ty(C);
@@ -169,13 +180,16 @@ void OpenCilkABI::prepareModule() {
       // TODO: Consider restructuring the import process to use
       // Linker::Flags::LinkOnlyNeeded to copy over only the necessary contents
       // from the external module.
+      bool SanitizeThread = llvm::any_of(M, [](const Function &F) {
+        return F.hasFnAttribute(Attribute::SanitizeThread);
+      });
       bool Fail = Linker::linkModules(
           M, std::move(ExternalModule), Linker::Flags::None,
-          [](Module &M, const StringSet<> &GVS) {
+          [SanitizeThread](Module &M, const StringSet<> &GVS) {
             for (StringRef GVName : GVS.keys()) {
               LLVM_DEBUG(dbgs() << "Linking global value " << GVName << "\n");
               if (Function *Fn = M.getFunction(GVName)) {
-                if (!Fn->isDeclaration())
+                if (!Fn->isDeclaration()) {
                   // We set the function's linkage as available_externally, so
                   // that subsequent optimizations can remove these definitions
                   // from the module.  We don't want this module redefining any of
@@ -183,6 +197,13 @@ void OpenCilkABI::prepareModule() {
                   // OpenCilk runtime library will provide those definitions
                   // later.
                   Fn->setLinkage(Function::AvailableExternallyLinkage);
+                  // The runtime's own memory accesses synchronize through the
+                  // runtime protocol, which ThreadSanitizer does not
+                  // understand.  Keep ThreadSanitizer from checking them once
+                  // they are inlined into user code.
+                  if (SanitizeThread)
+                    markRuntimeAccessesNoSanitize(*Fn);
+                }
               } else if (GlobalVariable *G = M.getGlobalVariable(GVName)) {
                 if (!G->isDeclaration())
                   G->setLinkage(GlobalValue::AvailableExternallyLinkage);
@@ -16,11 +16,13 @@
 #include "llvm/Analysis/TapirTaskInfo.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/InitializePasses.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/TapirXRayEvents.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Tapir.h"
@@ -40,6 +42,16 @@ cl::opt<bool> UseExternalABIFunctions(
     cl::desc("Use ABI functions defined externally, rather than "
              "compiler-generated versions"));
 
+static cl::opt<bool> TapirXRayEvents(
+    "tapir-xray-events", cl::init(false), cl::Hidden,
+    cl::desc("Emit XRay custom events at spawn, task-entry, continuation and "
+             "sync points before lowering Tapir"));
+
+static cl::opt<bool> TapirTsanAnnotations(
+    "tapir-tsan-annotations", cl::init(true), cl::Hidden,
+    cl::desc("In functions compiled with ThreadSanitizer, annotate the "
+             "happens-before edges of spawns and syncs before lowering Tapir"));
+
 static const char TimerGroupName[] = DEBUG_TYPE;
 static const char TimerGroupDescription[] = "Tapir to Target";
 
@@ -59,6 +71,8 @@ public:
 
 private:
   bool unifyReturns(Function &F);
+  bool insertXRayTaskEvents(Function &F, TaskInfo &TI);
+  bool insertTsanTaskAnnotations(Function &F, TaskInfo &TI);
   void processFunction(Function &F, SmallVectorImpl<Function *> &NewHelpers);
   TFOutlineMapTy outlineAllTasks(Function &F,
                                  SmallVectorImpl<Spindle *> &AllTaskFrames,
@@ -126,6 +140,202 @@ bool TapirToTargetImpl::unifyReturns(Function &F) {
   return true;
 }
 
+/// Insert XRay custom events into \p F that record when tasks are spawned, when
+/// spawned tasks and their continuations start executing, and when F syncs.
+/// The payload of each event is described in llvm/Support/TapirXRayEvents.h.
+bool TapirToTargetImpl::insertXRayTaskEvents(Function &F, TaskInfo &TI) {
+  NamedRegionTimer NRT("insertXRayTaskEvents", "Insert XRay task events",
+                       TimerGroupName, TimerGroupDescription,
+                       TimePassesIsEnabled);
+  if (F.getFnAttribute("function-instrument").getValueAsString() ==
+      "xray-never")
+    return false;
+
+  SmallVector<DetachInst *, 8> Detaches;
+  SmallVector<SyncInst *, 8> Syncs;
+  for (BasicBlock &BB : F) {
+    if (DetachInst *DI = dyn_cast<DetachInst>(BB.getTerminator()))
+      Detaches.push_back(DI);
+    else if (SyncInst *SI = dyn_cast<SyncInst>(BB.getTerminator()))
+      Syncs.push_back(SI);
+  }
+  if (Detaches.empty() && Syncs.empty())
+    return false;
+
+  LLVMContext &Ctx = F.getContext();
+  const DataLayout &DL = M.getDataLayout();
+  Type *Int16Ty = Type::getInt16Ty(Ctx);
+  Type *Int32Ty = Type::getInt32Ty(Ctx);
+  Type *Int64Ty = Type::getInt64Ty(Ctx);
+  StructType *EventTy =
+      StructType::get(Int32Ty, Int16Ty, Int16Ty, Int64Ty, Int64Ty);
+  assert(DL.getTypeAllocSize(EventTy) == xray::TapirEventSize &&
+         "Unexpected size of Tapir event payload");
+  Function *EventFn =
+      Intrinsic::getDeclaration(&M, Intrinsic::xray_customevent);
+  Function *FrameAddrFn = Intrinsic::getDeclaration(
+      &M, Intrinsic::frameaddress,
+      {Type::getInt8PtrTy(Ctx, DL.getAllocaAddrSpace())});
+
+  // Use the frame address of F to match up the events of one spawn.  Because
+  // this value is computed in the spawner, spawned tasks receive it as an
+  // input when they are outlined.
+  IRBuilder<> EntryB(&*F.getEntryBlock().getFirstInsertionPt());
+  Value *Frame = EntryB.CreatePtrToInt(
+      EntryB.CreateCall(FrameAddrFn, EntryB.getInt32(0)), Int64Ty);
+
+  // Give each task its own payload buffer, so that a spawned task and its
+  // continuation never write the same memory.
+  DenseMap<Task *, AllocaInst *> EventBuffers;
+  auto GetEventBuffer = [&](BasicBlock *BB) {
+    Task *T = TI.getTaskFor(BB);
+    AllocaInst *&Buf = EventBuffers[T];
+    if (!Buf) {
+      IRBuilder<> B(&*T->getEntry()->getFirstInsertionPt());
+      Buf = B.CreateAlloca(EventTy, DL.getAllocaAddrSpace(), nullptr,
+                           "xray.tapir.event");
+    }
+    return Buf;
+  };
+
+  uint64_t GUID = F.getGUID();
+  auto EmitEvent = [&](Instruction *InsertPt, xray::TapirEventKind Kind,
+                       uint16_t Site) {
+    AllocaInst *Buf = GetEventBuffer(InsertPt->getParent());
+    IRBuilder<> B(InsertPt);
+    B.CreateStore(B.getInt32(xray::TapirEventMagic),
+                  B.CreateStructGEP(EventTy, Buf, 0));
+    B.CreateStore(B.getInt16(static_cast<uint16_t>(Kind)),
+                  B.CreateStructGEP(EventTy, Buf, 1));
+    B.CreateStore(B.getInt16(Site), B.CreateStructGEP(EventTy, Buf, 2));
+    B.CreateStore(B.getInt64(GUID), B.CreateStructGEP(EventTy, Buf, 3));
+    B.CreateStore(Frame, B.CreateStructGEP(EventTy, Buf, 4));
+    B.CreateCall(EventFn, {B.CreatePointerCast(Buf, B.getInt8PtrTy()),
+                           B.getInt32(xray::TapirEventSize)});
+  };
+
+  uint16_t Site = 0;
+  SmallPtrSet<BasicBlock *, 8> Continuations;
+  for (DetachInst *DI : Detaches) {
+    EmitEvent(DI, xray::TapirEventKind::Spawn, Site);
+    EmitEvent(&*DI->getDetached()->getFirstInsertionPt(),
+              xray::TapirEventKind::TaskEntry, Site);
+    if (Continuations.insert(DI->getContinue()).second)
+      EmitEvent(&*DI->getContinue()->getFirstInsertionPt(),
+                xray::TapirEventKind::Continue, Site);
+    ++Site;
+  }
+  for (SyncInst *SI : Syncs)
+    EmitEvent(SI, xray::TapirEventKind::Sync, Site++);
+
+  return true;
+}
+
+/// Insert ThreadSanitizer annotations into \p F that describe the
+/// happens-before edges implied by its spawns and syncs.  ThreadSanitizer
+/// cannot see the synchronization inside the parallel runtime, so without these
+/// annotations it reports races between a spawned task and code that the spawn
+/// or sync orders before or after it.
+///
+/// Each dynamic spawn gets a fresh sync object that the spawner releases before
+/// the detach and that both the spawned task and the continuation, which may
+/// have been stolen, acquire.  Each sync region gets a sync object that every
+/// spawned task releases at its reattach and that the spawner releases and then
+/// acquires around each sync.
+bool TapirToTargetImpl::insertTsanTaskAnnotations(Function &F, TaskInfo &TI) {
+  NamedRegionTimer NRT("insertTsanTaskAnnotations",
+                       "Insert ThreadSanitizer task annotations",
+                       TimerGroupName, TimerGroupDescription,
+                       TimePassesIsEnabled);
+  if (!F.hasFnAttribute(Attribute::SanitizeThread))
+    return false;
+
+  SmallVector<DetachInst *, 8> Detaches;
+  SmallVector<ReattachInst *, 8> Reattaches;
+  SmallVector<SyncInst *, 8> Syncs;
+  for (BasicBlock &BB : F) {
+    Instruction *Term = BB.getTerminator();
+    if (DetachInst *DI = dyn_cast<DetachInst>(Term))
+      Detaches.push_back(DI);
+    else if (ReattachInst *RI = dyn_cast<ReattachInst>(Term))
+      Reattaches.push_back(RI);
+    else if (SyncInst *SI = dyn_cast<SyncInst>(Term))
+      Syncs.push_back(SI);
+  }
+  if (Detaches.empty() && Syncs.empty())
+    return false;
+
+  LLVMContext &Ctx = F.getContext();
+  const DataLayout &DL = M.getDataLayout();
+  Type *Int8Ty = Type::getInt8Ty(Ctx);
+  Type *VoidPtrTy = Type::getInt8PtrTy(Ctx);
+  AttributeList FnAttrs = AttributeList().addFnAttribute(Ctx,
+                                                         Attribute::NoUnwind);
+  FunctionCallee AcquireFn = M.getOrInsertFunction(
+      "__tsan_acquire", FnAttrs, Type::getVoidTy(Ctx), VoidPtrTy);
+  FunctionCallee ReleaseFn = M.getOrInsertFunction(
+      "__tsan_release", FnAttrs, Type::getVoidTy(Ctx), VoidPtrTy);
+
+  // The sync objects are only used for their addresses.
+  auto CreateSyncObject = [&](Instruction *InsertPt, const Twine &Name) {
+    IRBuilder<> B(InsertPt);
+    return B.CreatePointerCast(
+        B.CreateAlloca(Int8Ty, DL.getAllocaAddrSpace(), nullptr, Name),
+        VoidPtrTy);
+  };
+  // Allocate the sync object of a sync region in the entry of the task that
+  // contains the region, so that separate instances of a task use separate
+  // sync objects.
+  DenseMap<Value *, Value *> SyncRegionObjects;
+  auto GetSyncRegionObject = [&](Value *SyncRegion) {
+    Value *&Obj = SyncRegionObjects[SyncRegion];
+    if (!Obj) {
+      Task *T = TI.getTaskFor(cast<Instruction>(SyncRegion)->getParent());
+      Obj = CreateSyncObject(&*T->getEntry()->getFirstInsertionPt(),
+                             "tsan.sync");
+    }
+    return Obj;
+  };
+
+  auto EmitCall = [](FunctionCallee Fn, Value *Obj, Instruction *InsertPt) {
+    IRBuilder<> B(InsertPt);
+    B.CreateCall(Fn, Obj);
+  };
+
+  for (DetachInst *DI : Detaches) {
+    // Allocate the sync object of a spawn right before its detach, so that
+    // each spawn in a spawning loop gets its own object.  Otherwise, a release
+    // for a later spawn could reach a spawned task that has yet to acquire the
+    // object for its own spawn, and hide a race between that task and the
+    // continuation.  If the spawn has a taskframe, the object lives in it.
+    Value *Obj = CreateSyncObject(DI, "tsan.spawn");
+    EmitCall(ReleaseFn, Obj, DI);
+    EmitCall(AcquireFn, Obj, &*DI->getDetached()->getFirstInsertionPt());
+    EmitCall(AcquireFn, Obj, &*DI->getContinue()->getFirstInsertionPt());
+  }
+  for (ReattachInst *RI : Reattaches)
+    EmitCall(ReleaseFn, GetSyncRegionObject(RI->getSyncRegion()), RI);
+  for (SyncInst *SI : Syncs) {
+    Value *Obj = GetSyncRegionObject(SI->getSyncRegion());
+    EmitCall(ReleaseFn, Obj, SI);
+    // Lowering expects a sync.unwind to immediately follow its sync, so acquire
+    // after the sync.unwind, if there is one.
+    BasicBlock *SyncCont = SI->getSuccessor(0);
+    Instruction *InsertPt = &*SyncCont->getFirstInsertionPt();
+    if (isSyncUnwind(SyncCont->getFirstNonPHIOrDbgOrLifetime(),
+                     SI->getSyncRegion())) {
+      Instruction *SyncUnwind = SyncCont->getFirstNonPHIOrDbgOrLifetime();
+      if (InvokeInst *II = dyn_cast<InvokeInst>(SyncUnwind))
+        InsertPt = &*II->getNormalDest()->getFirstInsertionPt();
+      else
+        InsertPt = SyncUnwind->getNextNode();
+    }
+    EmitCall(AcquireFn, Obj, InsertPt);
+  }
+
+  return true;
+}
+
 /// Outline all tasks in this function in post order.
 TFOutlineMapTy
 TapirToTargetImpl::outlineAllTasks(Function &F,
@@ -506,6 +716,15 @@ bool TapirToTargetImpl::run() {
   Target->prepareModule();
 
   bool Changed = false;
+  // Instrument the original functions, rather than the helpers created during
+  // lowering, so that each spawn and sync is instrumented exactly once.
+  if (TapirXRayEvents)
+    for (Function *F : WorkList)
+      Changed |= insertXRayTaskEvents(*F, GetTI(*F));
+  if (TapirTsanAnnotations)
+    for (Function *F : WorkList)
+      Changed |= insertTsanTaskAnnotations(*F, GetTI(*F));
+
   while (!WorkList.empty()) {
     // Process the next function.
     Function *F = WorkList.pop_back_val();
@@ -89,6 +89,14 @@ static void addAllGlobalValueUsers(ClusterMapType &GVtoClusterMap,
   }
 }
 
+// Returns the estimated cost of generating code for GV, which is what the
+// partitions are balanced on when balancing by size.
+static unsigned getCodeGenWeight(const GlobalValue *GV) {
+  if (const Function *F = dyn_cast<Function>(GV))
+    return std::max(F->getInstructionCount(), 1u);
+  return 1;
+}
+
 static const GlobalObject *getGVPartitioningRoot(const GlobalValue *GV) {
   const GlobalObject *GO = GV->getAliaseeObject();
   if (const auto *GI = dyn_cast_or_null<GlobalIFunc>(GO))
@@ -99,9 +107,13 @@ static const GlobalObject *getGVPartitioningRoot(const GlobalValue *GV) {
 // Find partitions for module in the way that no locals need to be
 // globalized.
 // Try to balance pack those partitions into N files since this roughly equals
-// thread balancing for the backend codegen step.
+// thread balancing for the backend codegen step. If BalanceBySize is set, every
+// definition takes part in the balancing, weighted by its instruction count;
+// otherwise the clusters are balanced on their number of members and the
+// definitions that need not stay together are left to the MD5-based
+// partitioning.
 static void findPartitions(Module &M, ClusterIDMapType &ClusterIDMap,
-                           unsigned N) {
+                           unsigned N, bool BalanceBySize) {
   // At this point module should have the proper mix of globals and locals.
   // As we attempt to partition this module, we must not change any
   // locals to globals.
@@ -109,13 +121,17 @@ static void findPartitions(Module &M, ClusterIDMapType &ClusterIDMap,
   ClusterMapType GVtoClusterMap;
   ComdatMembersType ComdatMembers;
 
-  auto recordGVSet = [&GVtoClusterMap, &ComdatMembers](GlobalValue &GV) {
+  auto recordGVSet = [&GVtoClusterMap, &ComdatMembers,
+                      BalanceBySize](GlobalValue &GV) {
     if (GV.isDeclaration())
       return;
 
     if (!GV.hasName())
       GV.setName("__llvmsplit_unnamed");
 
+    if (BalanceBySize)
+      GVtoClusterMap.insert(&GV);
+
     // Comdat groups must not be partitioned. For comdat groups that contain
     // locals, record all their members here so we can keep them together.
     // Comdat groups that only contain external globals are already handled by
@@ -169,6 +185,10 @@ static void findPartitions(Module &M, ClusterIDMapType &ClusterIDMap,
   for (unsigned i = 0; i < N; ++i)
     BalancinQueue.push(std::make_pair(i, 0));
 
+  auto getWeight = [BalanceBySize](const GlobalValue *GV) {
+    return BalanceBySize ? getCodeGenWeight(GV) : 1;
+  };
+
   using SortType = std::pair<unsigned, ClusterMapType::iterator>;
 
   SmallVector<SortType, 64> Sets;
@@ -178,10 +198,14 @@ static void findPartitions(Module &M, ClusterIDMapType &ClusterIDMap,
   // When size is the same, use leader's name.
   for (ClusterMapType::iterator I = GVtoClusterMap.begin(),
                                 E = GVtoClusterMap.end(); I != E; ++I)
-    if (I->isLeader())
-      Sets.push_back(
-          std::make_pair(std::distance(GVtoClusterMap.member_begin(I),
-                                       GVtoClusterMap.member_end()), I));
+    if (I->isLeader()) {
+      unsigned Size = 0;
+      for (ClusterMapType::member_iterator MI = GVtoClusterMap.member_begin(I),
+                                           ME = GVtoClusterMap.member_end();
+           MI != ME; ++MI)
+        Size += getWeight(*MI);
+      Sets.push_back(std::make_pair(Size, I));
+    }
 
   llvm::sort(Sets, [](const SortType &a, const SortType &b) {
     if (a.first == b.first)
@@ -208,7 +232,7 @@ static void findPartitions(Module &M, ClusterIDMapType &ClusterIDMap,
                         << ((*MI)->hasLocalLinkage() ? " l " : " e ") << "\n");
       Visited.insert(*MI);
       ClusterIDMap[*MI] = CurrentClusterID;
-      CurrentClusterSize++;
+      CurrentClusterSize += getWeight(*MI);
     }
     // Add this set size to the number of entries in this cluster.
     BalancinQueue.push(std::make_pair(CurrentClusterID, CurrentClusterSize));
@@ -251,7 +275,7 @@ static bool isInPartition(const GlobalValue *GV, unsigned I, unsigned N) {
 void llvm::SplitModule(
     Module &M, unsigned N,
     function_ref<void(std::unique_ptr<Module> MPart)> ModuleCallback,
-    bool PreserveLocals) {
+    bool PreserveLocals, bool BalanceBySize) {
   if (!PreserveLocals) {
     for (Function &F : M)
       externalize(&F);
@@ -266,7 +290,7 @@ void llvm::SplitModule(
   // This performs splitting without a need for externalization, which might not
   // always be possible.
   ClusterIDMapType ClusterIDMap;
-  findPartitions(M, ClusterIDMap, N);
+  findPartitions(M, ClusterIDMap, N, BalanceBySize);
 
   // FIXME: We should be able to reuse M as the last partition instead of
   // cloning it. Note that the callers at the moment expect the module to
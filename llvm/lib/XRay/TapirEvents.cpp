@@ -0,0 +1,43 @@
+//===- TapirEvents.cpp - XRay custom events for Tapir tasks ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/XRay/TapirEvents.h"
+#include "llvm/Support/DataExtractor.h"
+
+namespace llvm {
+namespace xray {
+
+Optional<TapirEvent> decodeTapirEvent(StringRef Data, bool IsLittleEndian) {
+  if (Data.size() != TapirEventSize)
+    return None;
+
+  DataExtractor DE(Data, IsLittleEndian, 8);
+  uint64_t OffsetPtr = 0;
+  if (DE.getU32(&OffsetPtr) != TapirEventMagic)
+    return None;
+
+  uint16_t Kind = DE.getU16(&OffsetPtr);
+  switch (static_cast<TapirEventKind>(Kind)) {
+  case TapirEventKind::Spawn:
+  case TapirEventKind::TaskEntry:
+  case TapirEventKind::Continue:
+  case TapirEventKind::Sync:
+    break;
+  default:
+    return None;
+  }
+
+  TapirEvent E;
+  E.Kind = static_cast<TapirEventKind>(Kind);
+  E.Site = DE.getU16(&OffsetPtr);
+  E.FunctionGUID = DE.getU64(&OffsetPtr);
+  E.Frame = DE.getU64(&OffsetPtr);
+  return E;
+}
+
+} // namespace xray
+} // namespace llvm
@@ -0,0 +1,42 @@
+; Check that the MAAP values for the arguments of a call account for the
+; accesses of the call to the global variables named by the race summary of the
+; callee, which are not tied to any operand of the call.
+;
+; RUN: opt < %s -passes=cilksan -S | FileCheck %s
+
+@g = internal global i32 0
+
+define void @writes_p_and_g(i32* %p) sanitize_cilk {
+entry:
+  store i32 1, i32* %p
+  store i32 2, i32* @g
+  ret void
+}
+
+define void @caller(i32* noalias %p) sanitize_cilk {
+entry:
+  %sr = call token @llvm.syncregion.start()
+  detach within %sr, label %det, label %cont
+
+det:
+  call void @writes_p_and_g(i32* %p)
+  reattach within %sr, label %cont
+
+cont:
+  call void @writes_p_and_g(i32* %p)
+  sync within %sr, label %exit
+
+exit:
+  ret void
+}
+
+; CHECK-LABEL: define void @caller(i32* noalias %p)
+; CHECK: call void @__csan_get_MAAP(
+; CHECK: call void @__csan_set_MAAP(
+; CHECK: call void @__csan_before_call(
+; CHECK: call void @writes_p_and_g(i32* %p)
+; CHECK: call void @__csan_set_MAAP(
+; CHECK: call void @__csan_before_call(
+; CHECK: call void @writes_p_and_g(i32* %p)
+
+declare token @llvm.syncregion.start()
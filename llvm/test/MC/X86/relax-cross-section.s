@@ -0,0 +1,31 @@
+# RUN: llvm-mc -triple x86_64-pc-linux -filetype=obj %s -o %t
+# RUN: llvm-objdump -s -j .data.b %t | FileCheck %s --check-prefix=DATA
+# RUN: llvm-objdump -d -j .text.a %t | FileCheck %s --check-prefix=TEXT
+
+## The size of .data.b depends on the layout of .text.a through the count of
+## a .fill, and .data.b is relaxed first. Once the jump in .text.a is relaxed,
+## .data.b must be laid out and relaxed again: the fill grows from 2 to 5
+## bytes, which makes the size of the section 129 and its ULEB128 2 bytes
+## long. This is also what relaxing every section again produces.
+
+# DATA:      Contents of section .data.b:
+# DATA-NEXT:  0000 81019090 90909000 00000000 00000000
+# DATA:       0080 00{{ }}
+
+# TEXT:      <a_start>:
+# TEXT-NEXT:   0: e9 c8 00 00 00 jmp
+
+  .section .data.b,"aw",@progbits
+b_start:
+  .uleb128 b_end - b_start
+  .fill a_end - a_start, 1, 0x90
+  .space 122
+b_end:
+
+  .section .text.a,"ax",@progbits
+a_start:
+  jmp far
+a_end:
+  .space 200
+far:
+  ret
@@ -22,6 +22,7 @@
 #include "SourceCoverageView.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/ProfileData/Coverage/CoverageMapping.h"
 #include "llvm/ProfileData/InstrProfReader.h"
@@ -428,14 +429,61 @@ static bool modifiedTimeGT(StringRef LHS, StringRef RHS) {
   return LHSTime > RHSTime;
 }
 
+/// Converts \p Path to a native path with a trailing separator.
+static std::string nativeWithTrailing(StringRef Path) {
+  if (Path.empty())
+    return "";
+  SmallString<128> NativePath;
+  sys::path::native(Path, NativePath);
+  sys::path::remove_dots(NativePath, true);
+  if (!NativePath.empty() && !sys::path::is_separator(NativePath.back()))
+    NativePath += sys::path::get_separator();
+  return NativePath.c_str();
+}
+
 std::unique_ptr<CoverageMapping> CodeCoverageTool::load() {
   for (StringRef ObjectFilename : ObjectFilenames)
     if (modifiedTimeGT(ObjectFilename, PGOFilename))
       warning("profile data may be out of date - object is newer",
               ObjectFilename);
-  auto CoverageOrErr =
-      CoverageMapping::load(ObjectFilenames, PGOFilename, CoverageArches,
-                            ViewOpts.CompilationDirectory);
+
+  // When only some source files are requested, functions which have no code
+  // in them are never shown, so don't bother loading their coverage. Input
+  // files are matched the same way remapPathNames() and
+  // removeUnmappedInputs() match them later on.
+  StringSet<> RequestedFiles;
+  std::string RemapFrom, RemapTo;
+  if (HadSourceFiles) {
+    for (const std::string &SF : SourceFiles) {
+      RequestedFiles.insert(SF);
+      SmallString<128> NativeFilename;
+      sys::path::native(SF, NativeFilename);
+      RequestedFiles.insert(NativeFilename);
+    }
+    if (PathRemapping) {
+      RemapFrom = nativeWithTrailing(PathRemapping->first);
+      RemapTo = nativeWithTrailing(PathRemapping->second);
+    }
+  }
+  auto IsRequestedFile = [&](StringRef Filename) {
+    if (RequestedFiles.count(Filename))
+      return true;
+    if (!PathRemapping)
+      return false;
+    SmallString<128> NativeFilename;
+    sys::path::native(Filename, NativeFilename);
+    sys::path::remove_dots(NativeFilename, true);
+    if (!NativeFilename.startswith(RemapFrom))
+      return false;
+    return RequestedFiles.count(
+               RemapTo + NativeFilename.substr(RemapFrom.size()).str()) != 0;
+  };
+
+  auto CoverageOrErr = CoverageMapping::load(
+      ObjectFilenames, PGOFilename, CoverageArches,
+      ViewOpts.CompilationDirectory,
+      HadSourceFiles ? CoverageMapping::FilenameFilter(IsRequestedFile)
+                     : nullptr);
   if (Error E = CoverageOrErr.takeError()) {
     error("Failed to load coverage: " + toString(std::move(E)),
           join(ObjectFilenames.begin(), ObjectFilenames.end(), ", "));
@@ -470,16 +518,6 @@ void CodeCoverageTool::remapPathNames(const CoverageMapping &Coverage) {
     return;
 
   // Convert remapping paths to native paths with trailing seperators.
-  auto nativeWithTrailing = [](StringRef Path) -> std::string {
-    if (Path.empty())
-      return "";
-    SmallString<128> NativePath;
-    sys::path::native(Path, NativePath);
-    sys::path::remove_dots(NativePath, true);
-    if (!NativePath.empty() && !sys::path::is_separator(NativePath.back()))
-      NativePath += sys::path::get_separator();
-    return NativePath.c_str();
-  };
   std::string RemapFrom = nativeWithTrailing(PathRemapping->first);
   std::string RemapTo = nativeWithTrailing(PathRemapping->second);
 
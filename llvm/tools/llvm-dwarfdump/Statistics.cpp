@@ -13,6 +13,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFDebugLoc.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/JSON.h"
+#include "llvm/Support/Parallel.h"
 
 #define DEBUG_TYPE "dwarfdump"
 using namespace llvm;
@@ -111,6 +112,28 @@ struct PerFunctionStats {
   uint64_t NumLocalVarTypes = 0;
   /// Number of local variables with DW_AT_location.
   uint64_t NumLocalVarLocations = 0;
+
+  /// Accumulate the statistics of another instance of the same function.
+  void add(const PerFunctionStats &Other) {
+    NumFnInlined += Other.NumFnInlined;
+    NumFnOutOfLine += Other.NumFnOutOfLine;
+    NumAbstractOrigins += Other.NumAbstractOrigins;
+    TotalVarWithLoc += Other.TotalVarWithLoc;
+    ConstantMembers += Other.ConstantMembers;
+    NumArtificial += Other.NumArtificial;
+    for (const auto &Var : Other.VarsInFunction)
+      VarsInFunction.insert(Var.getKey());
+    IsFunction |= Other.IsFunction;
+    HasSourceLocation |= Other.HasSourceLocation;
+    NumParams += Other.NumParams;
+    NumParamSourceLocations += Other.NumParamSourceLocations;
+    NumParamTypes += Other.NumParamTypes;
+    NumParamLocations += Other.NumParamLocations;
+    NumLocalVars += Other.NumLocalVars;
+    NumLocalVarSourceLocations += Other.NumLocalVarSourceLocations;
+    NumLocalVarTypes += Other.NumLocalVarTypes;
+    NumLocalVarLocations += Other.NumLocalVarLocations;
+  }
 };
 
 /// Holds accumulated global statistics about DIEs.
@@ -153,6 +176,27 @@ struct GlobalStats {
   /// for the top inline functions within concrete functions. This can help
   /// tune the inline settings when compiling to match user expectations.
   SaturatingUINT64 InlineFunctionSize = 0;
+
+  /// Accumulate the statistics collected from another set of DIEs.
+  void add(const GlobalStats &Other) {
+    TotalBytesCovered += Other.TotalBytesCovered.Value;
+    ScopeBytesCovered += Other.ScopeBytesCovered.Value;
+    ScopeBytes += Other.ScopeBytes.Value;
+    ScopeEntryValueBytesCovered += Other.ScopeEntryValueBytesCovered.Value;
+    ParamScopeBytesCovered += Other.ParamScopeBytesCovered.Value;
+    ParamScopeBytes += Other.ParamScopeBytes.Value;
+    ParamScopeEntryValueBytesCovered +=
+        Other.ParamScopeEntryValueBytesCovered.Value;
+    LocalVarScopeBytesCovered += Other.LocalVarScopeBytesCovered.Value;
+    LocalVarScopeBytes += Other.LocalVarScopeBytes.Value;
+    LocalVarScopeEntryValueBytesCovered +=
+        Other.LocalVarScopeEntryValueBytesCovered.Value;
+    CallSiteEntries += Other.CallSiteEntries.Value;
+    CallSiteDIEs += Other.CallSiteDIEs.Value;
+    CallSiteParamDIEs += Other.CallSiteParamDIEs.Value;
+    FunctionSize += Other.FunctionSize.Value;
+    InlineFunctionSize += Other.InlineFunctionSize.Value;
+  }
 };
 
 /// Holds accumulated debug location statistics about local variables and
@@ -186,6 +230,38 @@ struct LocationStats {
   SaturatingUINT64 NumParam = 0;
   /// Total number of local variables processed.
   SaturatingUINT64 NumVar = 0;
+
+  /// Accumulate the statistics collected from another set of DIEs.
+  void add(const LocationStats &Other) {
+    auto AddBuckets = [](std::vector<SaturatingUINT64> &Buckets,
+                         const std::vector<SaturatingUINT64> &OtherBuckets) {
+      for (unsigned I = 0; I < NumOfCoverageCategories; ++I)
+        Buckets[I] += OtherBuckets[I].Value;
+    };
+    AddBuckets(VarParamLocStats, Other.VarParamLocStats);
+    AddBuckets(VarParamNonEntryValLocStats, Other.VarParamNonEntryValLocStats);
+    AddBuckets(ParamLocStats, Other.ParamLocStats);
+    AddBuckets(ParamNonEntryValLocStats, Other.ParamNonEntryValLocStats);
+    AddBuckets(LocalVarLocStats, Other.LocalVarLocStats);
+    AddBuckets(LocalVarNonEntryValLocStats, Other.LocalVarNonEntryValLocStats);
+    NumVarParam += Other.NumVarParam.Value;
+    NumParam += Other.NumParam.Value;
+    NumVar += Other.NumVar.Value;
+  }
+};
+
+/// Holds the statistics collected from a single compile unit, which are
+/// merged into the totals in compile unit order.
+struct UnitStats {
+  GlobalStats Global;
+  LocationStats Loc;
+  StringMap<PerFunctionStats> Functions;
+  /// Variables of the functions with DW_AT_inline in this unit.
+  AbstractOriginVarsTyMap AbstractOriginFnInfo;
+  /// The unit of each function with DW_AT_inline in this unit.
+  FunctionDIECUTyMap AbstractOriginFnCUs;
+  /// DIEs of this unit whose abstract origin is in a different unit.
+  CrossCUReferencingDIELocationTy CrossCUReferences;
 };
 } // namespace
 
@@ -854,34 +930,62 @@ bool dwarfdump::collectStatsForObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
   // abstract_origin.
   FunctionDIECUTyMap AbstractOriginFnCUs;
   CrossCUReferencingDIELocationTy CrossCUReferencesToBeResolved;
+
+  // Parse the DIEs and line tables of all the units up front, as this lazily
+  // updates state shared between units. The units are then walked in
+  // parallel, which only reads it.
+  SmallVector<DWARFDie, 0> CUDies;
   for (const auto &CU : static_cast<DWARFContext *>(&DICtx)->compile_units()) {
     if (DWARFDie CUDie = CU->getNonSkeletonUnitDIE(false)) {
-      // This variable holds variable information for functions with
-      // abstract_origin, but just for the current CU.
-      AbstractOriginVarsTyMap LocalAbstractOriginFnInfo;
-      FunctionsWithAbstractOriginTy FnsWithAbstractOriginToBeProcessed;
-
-      collectStatsRecursive(
-          CUDie, "/", "g", 0, 0, Statistics, GlobalStats, LocStats,
-          AbstractOriginFnCUs, GlobalAbstractOriginFnInfo,
-          LocalAbstractOriginFnInfo, FnsWithAbstractOriginToBeProcessed);
-
-      // collectZeroLocCovForVarsWithAbstractOrigin will filter out all
-      // out-of-order DWARF functions that have been processed within it,
-      // leaving FnsWithAbstractOriginToBeProcessed with only CrossCU
-      // references.
-      collectZeroLocCovForVarsWithAbstractOrigin(
-          CUDie.getDwarfUnit(), GlobalStats, LocStats,
-          LocalAbstractOriginFnInfo, FnsWithAbstractOriginToBeProcessed);
-
-      // Collect all CrossCU references into CrossCUReferencesToBeResolved.
-      for (auto CrossCUReferencingDIEOffset :
-           FnsWithAbstractOriginToBeProcessed)
-        CrossCUReferencesToBeResolved.push_back(
-            DIELocation(CUDie.getDwarfUnit(), CrossCUReferencingDIEOffset));
+      DWARFUnit *U = CUDie.getDwarfUnit();
+      U->getContext().getLineTableForUnit(U);
+      CUDies.push_back(CUDie);
     }
   }
 
+  std::vector<UnitStats> PerUnitStats(CUDies.size());
+  parallelForEachN(0, CUDies.size(), [&](size_t I) {
+    DWARFDie CUDie = CUDies[I];
+    UnitStats &Stats = PerUnitStats[I];
+    // This variable holds variable information for functions with
+    // abstract_origin, but just for the current CU.
+    AbstractOriginVarsTyMap LocalAbstractOriginFnInfo;
+    FunctionsWithAbstractOriginTy FnsWithAbstractOriginToBeProcessed;
+
+    collectStatsRecursive(CUDie, "/", "g", 0, 0, Stats.Functions, Stats.Global,
+                          Stats.Loc, Stats.AbstractOriginFnCUs,
+                          Stats.AbstractOriginFnInfo, LocalAbstractOriginFnInfo,
+                          FnsWithAbstractOriginToBeProcessed);
+
+    // collectZeroLocCovForVarsWithAbstractOrigin will filter out all
+    // out-of-order DWARF functions that have been processed within it,
+    // leaving FnsWithAbstractOriginToBeProcessed with only CrossCU
+    // references.
+    collectZeroLocCovForVarsWithAbstractOrigin(
+        CUDie.getDwarfUnit(), Stats.Global, Stats.Loc,
+        LocalAbstractOriginFnInfo, FnsWithAbstractOriginToBeProcessed);
+
+    // Collect all CrossCU references into CrossCUReferences.
+    for (auto CrossCUReferencingDIEOffset : FnsWithAbstractOriginToBeProcessed)
+      Stats.CrossCUReferences.push_back(
+          DIELocation(CUDie.getDwarfUnit(), CrossCUReferencingDIEOffset));
+  });
+
+  // Merge the statistics of each unit in order, so that the result doesn't
+  // depend on the order the units were processed in.
+  for (UnitStats &Stats : PerUnitStats) {
+    GlobalStats.add(Stats.Global);
+    LocStats.add(Stats.Loc);
+    for (const auto &Entry : Stats.Functions)
+      Statistics[Entry.getKey()].add(Entry.getValue());
+    for (const auto &Entry : Stats.AbstractOriginFnInfo)
+      llvm::append_range(GlobalAbstractOriginFnInfo[Entry.first],
+                         Entry.second);
+    for (const auto &Entry : Stats.AbstractOriginFnCUs)
+      AbstractOriginFnCUs[Entry.first] = Entry.second;
+    llvm::append_range(CrossCUReferencesToBeResolved, Stats.CrossCUReferences);
+  }
+
   /// Resolve CrossCU references.
   collectZeroLocCovForVarsWithCrossCUReferencingAbstractOrigin(
       LocStats, AbstractOriginFnCUs, GlobalAbstractOriginFnInfo,
@@ -24,6 +24,7 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -249,6 +250,13 @@ static opt<bool> Verify("verify", desc("Verify the DWARF debug info."),
                         cat(DwarfDumpCategory));
 static opt<bool> Quiet("quiet", desc("Use with -verify to not emit to STDOUT."),
                        cat(DwarfDumpCategory));
+static opt<unsigned> NumThreads(
+    "num-threads",
+    desc("Number of threads to use with -verify and -statistics. "
+         "0 uses all available hardware threads."),
+    cat(DwarfDumpCategory), init(0), value_desc("N"));
+static alias NumThreadsAlias("j", desc("Alias for --num-threads."),
+                             aliasopt(NumThreads), cl::NotHidden);
 static opt<bool> DumpUUID("uuid", desc("Show the UUID for each architecture."),
                           cat(DwarfDumpCategory));
 static alias DumpUUIDAlias("u", desc("Alias for --uuid."), aliasopt(DumpUUID),
@@ -614,6 +622,8 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  parallel::strategy = hardware_concurrency(NumThreads);
+
   std::error_code EC;
   ToolOutputFile OutputFile(OutputFilename, EC, sys::fs::OF_TextWithCRLF);
   error("unable to open output file " + OutputFilename, EC);
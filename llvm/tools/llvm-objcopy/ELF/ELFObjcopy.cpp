@@ -15,6 +15,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Twine.h"
@@ -33,6 +34,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Memory.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -227,6 +229,36 @@ static Error replaceDebugSections(
   return Obj.replaceSections(FromTo);
 }
 
+static Error compressDebugSections(Object &Obj,
+                                   DebugCompressionType CompressionType) {
+  SmallVector<SectionBase *, 13> ToCompress;
+  for (auto &Sec : Obj.sections())
+    if (isCompressable(Sec))
+      ToCompress.push_back(&Sec);
+
+  // Compressing the section contents is the expensive part and sections are
+  // compressed independently, so do that in parallel. Adding the compressed
+  // sections to the object has to be done serially afterwards.
+  std::vector<Optional<CompressedSection>> Compressed(ToCompress.size());
+  if (Error E = parallelForEachError(
+          seq<size_t>(0, ToCompress.size()), [&](size_t I) -> Error {
+            Expected<CompressedSection> NewSection =
+                CompressedSection::create(*ToCompress[I], CompressionType);
+            if (!NewSection)
+              return NewSection.takeError();
+            Compressed[I].emplace(std::move(*NewSection));
+            return Error::success();
+          }))
+    return E;
+
+  DenseMap<SectionBase *, SectionBase *> FromTo;
+  for (size_t I = 0, E = ToCompress.size(); I != E; ++I)
+    FromTo[ToCompress[I]] =
+        &Obj.addSection<CompressedSection>(std::move(*Compressed[I]));
+
+  return Obj.replaceSections(FromTo);
+}
+
 static bool isAArch64MappingSymbol(const Symbol &Sym) {
   if (Sym.Binding != STB_LOCAL || Sym.Type != STT_NOTYPE ||
       Sym.getShndx() == SHN_UNDEF)
@@ -507,16 +539,7 @@ static Error replaceAndRemoveSections(const CommonConfig &Config,
     return E;
 
   if (Config.CompressionType != DebugCompressionType::None) {
-    if (Error Err = replaceDebugSections(
-            Obj, isCompressable,
-            [&Config, &Obj](const SectionBase *S) -> Expected<SectionBase *> {
-              Expected<CompressedSection> NewSection =
-                  CompressedSection::create(*S, Config.CompressionType);
-              if (!NewSection)
-                return NewSection.takeError();
-
-              return &Obj.addSection<CompressedSection>(std::move(*NewSection));
-            }))
+    if (Error Err = compressDebugSections(Obj, Config.CompressionType))
       return Err;
   } else if (Config.DecompressDebugSections) {
     if (Error Err = replaceDebugSections(
@@ -533,7 +533,7 @@ Error ELFSectionWriter<ELFT>::visit(const CompressedSection &Sec) {
     memcpy(Buf, &DecompressedSize, sizeof(DecompressedSize));
     Buf += sizeof(DecompressedSize);
   } else {
-    Elf_Chdr_Impl<ELFT> Chdr;
+    Elf_Chdr_Impl<ELFT> Chdr = {};
     Chdr.ch_type = ELF::ELFCOMPRESS_ZLIB;
     Chdr.ch_size = Sec.DecompressedSize;
     Chdr.ch_addralign = Sec.DecompressedAlign;
@@ -2098,12 +2098,21 @@ template <class ELFT> void ELFWriter<ELFT>::writeShdrs() {
     writeShdr(Sec);
 }
 
+template <class ELFT>
+bool ELFWriter<ELFT>::isStreamed(const SectionBase &Sec) const {
+  auto It = llvm::partition_point(StreamedSections, [&](const SectionBase *S) {
+    return S->Offset < Sec.Offset;
+  });
+  return It != StreamedSections.end() && *It == &Sec;
+}
+
 template <class ELFT> Error ELFWriter<ELFT>::writeSectionData() {
   for (SectionBase &Sec : Obj.sections())
     // Segments are responsible for writing their contents, so only write the
     // section data if the section is not in a segment. Note that this renders
-    // sections in segments effectively immutable.
-    if (Sec.ParentSegment == nullptr)
+    // sections in segments effectively immutable. Streamed sections are
+    // written by write() itself.
+    if (Sec.ParentSegment == nullptr && !isStreamed(Sec))
       if (Error Err = Sec.accept(*SecWriter))
         return Err;
 
@@ -2521,9 +2530,18 @@ template <class ELFT> Error ELFWriter<ELFT>::write() {
   if (WriteSectionHeaders)
     writeShdrs();
 
-  // TODO: Implement direct writing to the output stream (without intermediate
-  // memory buffer Buf).
-  Out.write(Buf->getBufferStart(), Buf->getBufferSize());
+  // Write Buf out, splicing in the contents of the streamed sections from the
+  // input.
+  // TODO: Implement direct writing to the output stream of the remaining
+  // sections as well (without intermediate memory buffer Buf).
+  uint64_t Pos = 0;
+  for (const SectionBase *Sec : StreamedSections) {
+    ArrayRef<uint8_t> Contents = Sec->getVerbatimContents();
+    Out.write(Buf->getBufferStart() + Pos, Sec->Offset - Pos);
+    Out.write(reinterpret_cast<const char *>(Contents.data()), Contents.size());
+    Pos = Sec->Offset + Contents.size();
+  }
+  Out.write(Buf->getBufferStart() + Pos, Buf->getBufferSize() - Pos);
   return Error::success();
 }
 
@@ -2646,12 +2664,40 @@ template <class ELFT> Error ELFWriter<ELFT>::finalize() {
   }
 
   size_t TotalSize = totalSize();
-  Buf = WritableMemoryBuffer::getNewMemBuffer(TotalSize);
+  Buf = WritableMemoryBuffer::getNewUninitMemBuffer(TotalSize);
   if (!Buf)
     return createStringError(errc::not_enough_memory,
                              "failed to allocate memory buffer of " +
                                  Twine::utohexstr(TotalSize) + " bytes");
 
+  // Sections which are not in a segment and are written out unchanged, which
+  // is most of the debug info of large binaries, are written straight from the
+  // input by write(). Their part of Buf is left uninitialized and never
+  // touched, so it doesn't take up memory. Everything else is zeroed, which
+  // includes the padding between sections.
+  StreamedSections.clear();
+  for (const SectionBase &Sec : Obj.sections())
+    if (Sec.ParentSegment == nullptr && !Sec.getVerbatimContents().empty())
+      StreamedSections.push_back(&Sec);
+  llvm::stable_sort(StreamedSections,
+                    [](const SectionBase *LHS, const SectionBase *RHS) {
+                      return LHS->Offset < RHS->Offset;
+                    });
+  uint64_t Pos = 0;
+  for (const SectionBase *Sec : StreamedSections) {
+    uint64_t End = Sec->Offset + Sec->getVerbatimContents().size();
+    if (Sec->Offset < Pos || End > TotalSize) {
+      // Sections outside of segments are laid out without overlaps, but if
+      // that ever changes, just write everything into Buf.
+      StreamedSections.clear();
+      Pos = 0;
+      break;
+    }
+    std::memset(Buf->getBufferStart() + Pos, 0, Sec->Offset - Pos);
+    Pos = End;
+  }
+  std::memset(Buf->getBufferStart() + Pos, 0, TotalSize - Pos);
+
   SecWriter = std::make_unique<ELFSectionWriter<ELFT>>(*Buf);
   return Error::success();
 }
@@ -337,9 +337,15 @@ private:
   void writeSegmentData();
 
   void assignOffsets();
+  bool isStreamed(const SectionBase &Sec) const;
 
   std::unique_ptr<ELFSectionWriter<ELFT>> SecWriter;
 
+  // Sections outside of segments with unchanged contents, sorted by offset.
+  // Their contents are written straight from the input rather than being
+  // copied into Buf.
+  std::vector<const SectionBase *> StreamedSections;
+
   size_t totalSize() const;
 
 public:
@@ -430,6 +436,9 @@ public:
   virtual void
   replaceSectionReferences(const DenseMap<SectionBase *, SectionBase *> &);
   virtual bool hasContents() const { return false; }
+  // The input data this section is written out as, unchanged. Empty if the
+  // section's contents are produced by the section writer.
+  virtual ArrayRef<uint8_t> getVerbatimContents() const { return {}; }
   // Notify the section that it is subject to removal.
   virtual void onRemove();
 };
@@ -497,6 +506,9 @@ public:
   bool hasContents() const override {
     return Type != ELF::SHT_NOBITS && Type != ELF::SHT_NULL;
   }
+  ArrayRef<uint8_t> getVerbatimContents() const override {
+    return Type != ELF::SHT_NOBITS ? Contents : ArrayRef<uint8_t>();
+  }
 };
 
 class OwnedDataSection : public SectionBase {
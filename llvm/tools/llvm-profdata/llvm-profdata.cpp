@@ -36,6 +36,7 @@
 #include "llvm/Support/Threading.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 
 using namespace llvm;
@@ -234,6 +235,51 @@ static void overlapInput(const std::string &BaseFilename,
   }
 }
 
+/// Add the record \p I read from \p Input to the writer of \p WC, whose lock
+/// must be held.
+static void addRecordToWriter(WriterContext *WC, NamedInstrProfRecord &&I,
+                              const WeightedFile &Input) {
+  const StringRef FuncName = I.Name;
+  bool Reported = false;
+  WC->Writer.addRecord(std::move(I), Input.Weight, [&](Error E) {
+    if (Reported) {
+      consumeError(std::move(E));
+      return;
+    }
+    Reported = true;
+    // Only show hint the first time an error occurs.
+    instrprof_error IPE = InstrProfError::take(std::move(E));
+    std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
+    bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
+    handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
+                           FuncName, firstTime);
+  });
+}
+
+/// Open \p Input and merge its profile kind into \p Writer. Return null for an
+/// empty raw profile, which is skipped silently.
+static Expected<std::unique_ptr<InstrProfReader>>
+openInput(const WeightedFile &Input, const InstrProfCorrelator *Correlator,
+          InstrProfWriter &Writer) {
+  auto ReaderOrErr = InstrProfReader::create(Input.Filename, Correlator);
+  if (Error E = ReaderOrErr.takeError()) {
+    // Skip the empty profiles by returning sliently.
+    instrprof_error IPE = InstrProfError::take(std::move(E));
+    if (IPE == instrprof_error::empty_raw_profile)
+      return nullptr;
+    return make_error<InstrProfError>(IPE);
+  }
+
+  auto Reader = std::move(ReaderOrErr.get());
+  if (Error E = Writer.mergeProfileKind(Reader->getProfileKind())) {
+    consumeError(std::move(E));
+    return make_error<StringError>(
+        "Merge IR generated profile with Clang generated profile.",
+        std::error_code());
+  }
+  return std::move(Reader);
+}
+
 /// Load an input into a writer context.
 static void loadInput(const WeightedFile &Input, SymbolRemapper *Remapper,
                       const InstrProfCorrelator *Correlator,
@@ -245,50 +291,61 @@ static void loadInput(const WeightedFile &Input, SymbolRemapper *Remapper,
   // invalid outside of this packaged task.
   std::string Filename = Input.Filename;
 
-  auto ReaderOrErr = InstrProfReader::create(Input.Filename, Correlator);
+  auto ReaderOrErr = openInput(Input, Correlator, WC->Writer);
   if (Error E = ReaderOrErr.takeError()) {
-    // Skip the empty profiles by returning sliently.
-    instrprof_error IPE = InstrProfError::take(std::move(E));
-    if (IPE != instrprof_error::empty_raw_profile)
-      WC->Errors.emplace_back(make_error<InstrProfError>(IPE), Filename);
+    WC->Errors.emplace_back(std::move(E), Filename);
     return;
   }
 
   auto Reader = std::move(ReaderOrErr.get());
-  if (Error E = WC->Writer.mergeProfileKind(Reader->getProfileKind())) {
-    consumeError(std::move(E));
-    WC->Errors.emplace_back(
-        make_error<StringError>(
-            "Merge IR generated profile with Clang generated profile.",
-            std::error_code()),
-        Filename);
+  if (!Reader)
     return;
-  }
 
   for (auto &I : *Reader) {
     if (Remapper)
       I.Name = (*Remapper)(I.Name);
-    const StringRef FuncName = I.Name;
-    bool Reported = false;
-    WC->Writer.addRecord(std::move(I), Input.Weight, [&](Error E) {
-      if (Reported) {
-        consumeError(std::move(E));
-        return;
-      }
-      Reported = true;
-      // Only show hint the first time an error occurs.
-      instrprof_error IPE = InstrProfError::take(std::move(E));
-      std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
-      bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
-      handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
-                             FuncName, firstTime);
-    });
+    addRecordToWriter(WC, std::move(I), Input);
   }
   if (Reader->hasError())
     if (Error E = Reader->getError())
       WC->Errors.emplace_back(std::move(E), Filename);
 }
 
+/// Load the records of \p Reader, opened from \p Input, into the writer
+/// contexts of \p Shards. Each function goes to the shard selected by the hash
+/// of its name, so that the shards hold disjoint sets of functions and several
+/// inputs can be merged concurrently into a single copy of the profile. A read
+/// error is left in \p Reader.
+static void
+loadInputIntoShards(const WeightedFile &Input, SymbolRemapper *Remapper,
+                    InstrProfReader *Reader,
+                    ArrayRef<std::unique_ptr<WriterContext>> Shards) {
+  // Hand the records over to the shards in batches, so that each shard lock
+  // is taken once per batch rather than once per function, while only a
+  // bounded number of records of this input is held at a time.
+  const size_t BatchSize = 1024;
+  std::vector<std::vector<NamedInstrProfRecord>> Batches(Shards.size());
+  auto flushBatch = [&](size_t Shard) {
+    WriterContext *WC = Shards[Shard].get();
+    std::unique_lock<std::mutex> CtxGuard{WC->Lock};
+    for (NamedInstrProfRecord &Record : Batches[Shard])
+      addRecordToWriter(WC, std::move(Record), Input);
+    Batches[Shard].clear();
+  };
+
+  for (auto &I : *Reader) {
+    if (Remapper)
+      I.Name = (*Remapper)(I.Name);
+    const size_t Shard = xxHash64(I.Name) % Shards.size();
+    Batches[Shard].push_back(std::move(I));
+    if (Batches[Shard].size() >= BatchSize)
+      flushBatch(Shard);
+  }
+  for (size_t Shard = 0; Shard < Shards.size(); ++Shard)
+    if (!Batches[Shard].empty())
+      flushBatch(Shard);
+}
+
 /// Merge the \p Src writer context into \p Dst.
 static void mergeWriterContexts(WriterContext *Dst, WriterContext *Src) {
   for (auto &ErrorPair : Src->Errors)
@@ -351,13 +408,15 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   if (NumThreads == 0)
     NumThreads = std::min(hardware_concurrency().compute_thread_count(),
                           unsigned((Inputs.size() + 1) / 2));
-  // FIXME: There's a bug here, where setting NumThreads = Inputs.size() fails
-  // the merge_empty_profile.test because the InstrProfWriter.ProfileKind isn't
-  // merged, thus the emitted file ends up with a PF_Unknown kind.
 
-  // Initialize the writer contexts.
+  // Initialize the writer contexts. With several threads, each context is a
+  // shard of the profile. There are more shards than threads so that the
+  // threads rarely wait for each other.
+  const unsigned ShardsPerThread = 4;
+  const unsigned NumContexts =
+      NumThreads == 1 ? 1 : NumThreads * ShardsPerThread;
   SmallVector<std::unique_ptr<WriterContext>, 4> Contexts;
-  for (unsigned I = 0; I < NumThreads; ++I)
+  for (unsigned I = 0; I < NumContexts; ++I)
     Contexts.emplace_back(std::make_unique<WriterContext>(
         OutputSparse, ErrorLock, WriterErrorCodes));
 
@@ -365,34 +424,60 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
     for (const auto &Input : Inputs)
       loadInput(Input, Remapper, Correlator.get(), Contexts[0].get());
   } else {
+    // Settle the profile kinds in input order, so that the inputs that are
+    // merged, and the errors reported about the others, are the same as when
+    // loading them one after the other. This only reads the header of each
+    // input. The profile kind is tracked in the first shard. Each reader is
+    // closed right away, so that the inputs are not all held open at once.
+    std::vector<Optional<Error>> InputErrors(Inputs.size());
+    std::vector<bool> ShouldLoad(Inputs.size(), false);
+    for (size_t I = 0; I < Inputs.size(); ++I) {
+      auto ReaderOrErr =
+          openInput(Inputs[I], Correlator.get(), Contexts[0]->Writer);
+      if (Error E = ReaderOrErr.takeError())
+        InputErrors[I] = std::move(E);
+      else
+        ShouldLoad[I] = *ReaderOrErr != nullptr;
+    }
+
     ThreadPool Pool(hardware_concurrency(NumThreads));
 
-    // Load the inputs in parallel (N/NumThreads serial steps).
-    unsigned Ctx = 0;
-    for (const auto &Input : Inputs) {
-      Pool.async(loadInput, Input, Remapper, Correlator.get(),
-                 Contexts[Ctx].get());
-      Ctx = (Ctx + 1) % NumThreads;
+    // Load the inputs in parallel, each of them into all of the shards. Each
+    // task opens its input again and closes it when done, so only the inputs
+    // being loaded are open at any time.
+    for (size_t I = 0; I < Inputs.size(); ++I) {
+      if (!ShouldLoad[I])
+        continue;
+      Pool.async([&, I]() {
+        auto ReaderOrErr =
+            InstrProfReader::create(Inputs[I].Filename, Correlator.get());
+        if (Error E = ReaderOrErr.takeError()) {
+          InputErrors[I] = std::move(E);
+          return;
+        }
+        std::unique_ptr<InstrProfReader> Reader = std::move(*ReaderOrErr);
+        loadInputIntoShards(Inputs[I], Remapper, Reader.get(),
+                            makeArrayRef(Contexts));
+        if (Reader->hasError())
+          if (Error E = Reader->getError())
+            InputErrors[I] = std::move(E);
+      });
     }
     Pool.wait();
 
-    // Merge the writer contexts together (~ lg(NumThreads) serial steps).
-    unsigned Mid = Contexts.size() / 2;
-    unsigned End = Contexts.size();
-    assert(Mid > 0 && "Expected more than one context");
-    do {
-      for (unsigned I = 0; I < Mid; ++I)
-        Pool.async(mergeWriterContexts, Contexts[I].get(),
-                   Contexts[I + Mid].get());
-      Pool.wait();
-      if (End & 1) {
-        Pool.async(mergeWriterContexts, Contexts[0].get(),
-                   Contexts[End - 1].get());
-        Pool.wait();
-      }
-      End = Mid;
-      Mid /= 2;
-    } while (Mid > 0);
+    // Report the errors in input order.
+    for (size_t I = 0; I < Inputs.size(); ++I)
+      if (InputErrors[I])
+        Contexts[0]->Errors.emplace_back(std::move(*InputErrors[I]),
+                                         Inputs[I].Filename);
+
+    // The shards hold disjoint sets of functions, so gathering them into the
+    // first one does not merge any counters. Release each shard as soon as it
+    // is gathered to not hold two copies of the profile.
+    for (unsigned I = 1; I < Contexts.size(); ++I) {
+      mergeWriterContexts(Contexts[0].get(), Contexts[I].get());
+      Contexts[I]->Writer.getProfileData().clear();
+    }
   }
 
   // Handle deferred errors encountered during merging. If the number of errors
@@ -47,6 +47,11 @@ static cl::opt<bool>
                    cl::desc("Split without externalizing locals"),
                    cl::cat(SplitCategory));
 
+static cl::opt<bool>
+    BalanceBySize("balance-by-size", cl::Prefix, cl::init(false),
+                  cl::desc("Balance the outputs on their instruction count"),
+                  cl::cat(SplitCategory));
+
 int main(int argc, char **argv) {
   LLVMContext Context;
   SMDiagnostic Err;
@@ -82,7 +87,7 @@ int main(int argc, char **argv) {
         // Declare success.
         Out->keep();
       },
-      PreserveLocals);
+      PreserveLocals, BalanceBySize);
 
   return 0;
 }
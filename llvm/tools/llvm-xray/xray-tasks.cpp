@@ -0,0 +1,179 @@
+//===- xray-tasks.cpp: XRay Tapir Task Timelines --------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the "tasks" subcommand, which reconstructs per-thread
+// timelines of the spawn, task-entry, continuation and sync events that Tapir
+// lowering emits as XRay custom events (see llvm/XRay/TapirEvents.h). Matching
+// the Spawn and Continue events of one spawn across threads tells us which
+// continuations were stolen by another worker.
+//
+//===----------------------------------------------------------------------===//
+
+#include <map>
+#include <tuple>
+
+#include "xray-registry.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/XRay/TapirEvents.h"
+#include "llvm/XRay/Trace.h"
+
+using namespace llvm;
+using namespace llvm::xray;
+
+static cl::SubCommand Tasks("tasks", "Per-thread Tapir task timelines");
+static cl::opt<std::string> TasksInput(cl::Positional,
+                                       cl::desc("<xray log file>"),
+                                       cl::Required, cl::sub(Tasks));
+static cl::opt<bool>
+    TasksTimeline("timeline",
+                  cl::desc("Print every task event, grouped by thread, in "
+                           "addition to the per-thread summary"),
+                  cl::sub(Tasks), cl::init(false));
+static cl::alias TasksTimeline2("t", cl::aliasopt(TasksTimeline),
+                                cl::desc("Alias for -timeline"));
+static cl::opt<std::string>
+    TasksOutput("output", cl::value_desc("output file"), cl::init("-"),
+                cl::desc("output file; use '-' for stdout"), cl::sub(Tasks));
+static cl::alias TasksOutput2("o", cl::aliasopt(TasksOutput),
+                              cl::desc("Alias for -output"));
+
+namespace {
+
+struct TaskEventRecord {
+  uint64_t TSC;
+  uint16_t CPU;
+  TapirEvent Event;
+  bool Stolen;
+};
+
+struct ThreadTasks {
+  std::vector<TaskEventRecord> Events;
+  uint64_t Spawns = 0;
+  uint64_t TaskEntries = 0;
+  uint64_t Continues = 0;
+  uint64_t Syncs = 0;
+  uint64_t Steals = 0;
+};
+
+const char *kindName(TapirEventKind K) {
+  switch (K) {
+  case TapirEventKind::Spawn:
+    return "spawn";
+  case TapirEventKind::TaskEntry:
+    return "task-entry";
+  case TapirEventKind::Continue:
+    return "continue";
+  case TapirEventKind::Sync:
+    return "sync";
+  }
+  llvm_unreachable("Unknown Tapir event kind");
+}
+
+} // namespace
+
+static CommandRegistration Unused(&Tasks, []() -> Error {
+  // Sort the records by TSC, so that the Spawn event of a spawn precedes the
+  // Continue event of the same spawn even when they were logged by different
+  // threads.
+  auto TraceOrErr = loadTraceFile(TasksInput, /*Sort=*/true);
+  if (!TraceOrErr)
+    return joinErrors(
+        make_error<StringError>(
+            Twine("Failed loading input file '") + TasksInput + "'",
+            std::make_error_code(std::errc::executable_format_error)),
+        TraceOrErr.takeError());
+
+  // Keyed by (function GUID, site, frame), the thread that last spawned from
+  // that site in that frame.
+  using SpawnKey = std::tuple<uint64_t, uint16_t, uint64_t>;
+  std::map<SpawnKey, uint32_t> PendingSpawns;
+  std::map<uint32_t, ThreadTasks> Threads;
+
+  for (const auto &R : *TraceOrErr) {
+    if (R.Type != RecordTypes::CUSTOM_EVENT)
+      continue;
+    // XRay custom events are only supported on x86_64, hence we always decode
+    // the payloads as little-endian.
+    auto E = decodeTapirEvent(R.Data, /*IsLittleEndian=*/true);
+    if (!E)
+      continue;
+
+    auto &TT = Threads[R.TId];
+    bool Stolen = false;
+    SpawnKey Key{E->FunctionGUID, E->Site, E->Frame};
+    switch (E->Kind) {
+    case TapirEventKind::Spawn:
+      ++TT.Spawns;
+      PendingSpawns[Key] = R.TId;
+      break;
+    case TapirEventKind::TaskEntry:
+      ++TT.TaskEntries;
+      break;
+    case TapirEventKind::Continue: {
+      ++TT.Continues;
+      auto It = PendingSpawns.find(Key);
+      if (It != PendingSpawns.end()) {
+        Stolen = It->second != R.TId;
+        PendingSpawns.erase(It);
+      }
+      TT.Steals += Stolen;
+      break;
+    }
+    case TapirEventKind::Sync:
+      ++TT.Syncs;
+      break;
+    }
+    if (TasksTimeline)
+      TT.Events.push_back({R.TSC, R.CPU, *E, Stolen});
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(TasksOutput, EC, sys::fs::OpenFlags::OF_TextWithCRLF);
+  if (EC)
+    return make_error<StringError>(
+        Twine("Cannot open file '") + TasksOutput + "' for writing.", EC);
+
+  if (Threads.empty()) {
+    OS << "No Tapir task events found.\n";
+    return Error::success();
+  }
+
+  OS << formatv("{0,-10} {1,10} {2,10} {3,10} {4,10} {5,10}\n", "thread",
+                "spawns", "entries", "continues", "syncs", "steals");
+  for (const auto &ThreadAndTasks : Threads) {
+    const auto &TT = ThreadAndTasks.second;
+    OS << formatv("{0,-10} {1,10} {2,10} {3,10} {4,10} {5,10}\n",
+                  ThreadAndTasks.first, TT.Spawns, TT.TaskEntries,
+                  TT.Continues, TT.Syncs, TT.Steals);
+  }
+
+  if (!TasksTimeline)
+    return Error::success();
+
+  for (const auto &ThreadAndTasks : Threads) {
+    const auto &Events = ThreadAndTasks.second.Events;
+    OS << formatv("\nthread {0}:\n", ThreadAndTasks.first);
+    uint64_t BaseTSC = Events.empty() ? 0 : Events.front().TSC;
+    for (const auto &TE : Events) {
+      OS << formatv("  +{0,-14} cpu {1,-4} {2,-10} fn {3} site {4} frame {5}",
+                    TE.TSC - BaseTSC, TE.CPU, kindName(TE.Event.Kind),
+                    format_hex(TE.Event.FunctionGUID, 18), TE.Event.Site,
+                    format_hex(TE.Event.Frame, 18));
+      if (TE.Stolen)
+        OS << " (stolen)";
+      OS << "\n";
+    }
+  }
+  return Error::success();
+});
@@ -0,0 +1,297 @@
+//===- TapirRaceSummaryTest.cpp - Tapir race summary unit tests -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/TapirRaceDetect.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/BasicAliasAnalysis.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TapirTaskInfo.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+class TapirRaceSummaryTest : public testing::Test {
+protected:
+  void parseAssembly(const char *IR) {
+    SMDiagnostic Err;
+    M = parseAssemblyString(IR, Err, Context);
+    if (!M)
+      Err.print("TapirRaceSummaryTest", errs());
+    ASSERT_TRUE(M);
+    TLII.reset(new TargetLibraryInfoImpl(Triple(M->getTargetTriple())));
+    TLI.reset(new TargetLibraryInfo(*TLII));
+    CG.reset(new CallGraph(*M));
+    Info.reset(new RaceSummaryInfo(
+        *M, *CG, [this](Function &) -> const TargetLibraryInfo & {
+          return *TLI;
+        }));
+  }
+
+  const FunctionRaceSummary *getSummary(StringRef Name) {
+    return Info->getSummary(M->getFunction(Name));
+  }
+
+  /// Run the race analysis on the function \p Name, with or without the race
+  /// summaries of the functions it calls, and pass the result to \p Test.
+  void runRaceInfo(StringRef Name, bool UseSummaries,
+                   function_ref<void(Function &F, RaceInfo &RI)> Test) {
+    Function *F = M->getFunction(Name);
+    ASSERT_NE(F, nullptr) << "Could not find " << Name;
+    AssumptionCache AC(*F);
+    DominatorTree DT(*F);
+    LoopInfo LI(DT);
+    TaskInfo TI;
+    TI.analyze(*F, DT);
+    ScalarEvolution SE(*F, *TLI, AC, DT, LI);
+    BasicAAResult BAA(M->getDataLayout(), *F, *TLI, AC, &DT);
+    AAResults AA(*TLI);
+    AA.addAAResult(BAA);
+    DependenceInfo DI(F, &AA, &SE, &LI);
+    RaceInfo RI(F, DT, LI, TI, DI, SE, TLI.get(),
+                UseSummaries ? Info.get() : nullptr);
+    Test(*F, RI);
+  }
+
+  /// Returns the first call to the function \p Callee in \p F.
+  static const CallBase *getCallTo(Function &F, StringRef Callee) {
+    for (Instruction &I : instructions(F))
+      if (const CallBase *Call = dyn_cast<CallBase>(&I))
+        if (Call->getCalledFunction() &&
+            Call->getCalledFunction()->getName() == Callee)
+          return Call;
+    return nullptr;
+  }
+
+  /// Returns the first load from the global variable \p GV in \p F.
+  static const LoadInst *getLoadFrom(Function &F, const GlobalVariable *GV) {
+    for (Instruction &I : instructions(F))
+      if (const LoadInst *Load = dyn_cast<LoadInst>(&I))
+        if (Load->getPointerOperand() == GV)
+          return Load;
+    return nullptr;
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M;
+  std::unique_ptr<TargetLibraryInfoImpl> TLII;
+  std::unique_ptr<TargetLibraryInfo> TLI;
+  std::unique_ptr<CallGraph> CG;
+  std::unique_ptr<RaceSummaryInfo> Info;
+};
+
+TEST_F(TapirRaceSummaryTest, ArgumentsAndGlobals) {
+  parseAssembly(R"IR(
+    @g = global i32 0
+    @c = constant i32 1
+
+    define void @leaf(i32* %p, i32* %q, i32* %unused) {
+      %v = load i32, i32* %q
+      %c = load i32, i32* @c
+      %sum = add i32 %v, %c
+      %gep = getelementptr i32, i32* %p, i64 1
+      store i32 %sum, i32* %gep
+      %x = alloca i32
+      store i32 %sum, i32* %x
+      ret void
+    }
+
+    define void @caller(i32* %a) {
+      call void @leaf(i32* @g, i32* %a, i32* null)
+      ret void
+    }
+
+    define void @opaque(i32** %pp) {
+      %p = load i32*, i32** %pp
+      store i32 0, i32* %p
+      ret void
+    }
+
+    declare void @external()
+
+    define void @calls_external() {
+      call void @external()
+      ret void
+    }
+
+    declare void @external_decl()
+  )IR");
+
+  const FunctionRaceSummary *Leaf = getSummary("leaf");
+  ASSERT_TRUE(Leaf);
+  EXPECT_FALSE(Leaf->AccessesUnknownMemory);
+  EXPECT_EQ(ModRefInfo::Mod, Leaf->getArgModRef(0));
+  EXPECT_EQ(ModRefInfo::Ref, Leaf->getArgModRef(1));
+  EXPECT_EQ(ModRefInfo::NoModRef, Leaf->getArgModRef(2));
+  EXPECT_TRUE(Leaf->GlobalMR.empty());
+
+  // The accesses of @leaf through its arguments map onto the arguments of the
+  // call in @caller.
+  const FunctionRaceSummary *Caller = getSummary("caller");
+  ASSERT_TRUE(Caller);
+  EXPECT_FALSE(Caller->AccessesUnknownMemory);
+  EXPECT_EQ(ModRefInfo::Ref, Caller->getArgModRef(0));
+  ASSERT_EQ(1u, Caller->GlobalMR.size());
+  EXPECT_EQ(ModRefInfo::Mod, Caller->GlobalMR.lookup(M->getNamedGlobal("g")));
+
+  EXPECT_TRUE(getSummary("opaque")->AccessesUnknownMemory);
+  EXPECT_TRUE(getSummary("calls_external")->AccessesUnknownMemory);
+  EXPECT_FALSE(getSummary("external_decl"));
+}
+
+TEST_F(TapirRaceSummaryTest, Recursion) {
+  parseAssembly(R"IR(
+    @g = global i32 0
+
+    define void @even(i32* %p, i32 %n) {
+      %done = icmp eq i32 %n, 0
+      br i1 %done, label %exit, label %recurse
+    recurse:
+      %m = sub i32 %n, 1
+      call void @odd(i32* %p, i32 %m)
+      br label %exit
+    exit:
+      ret void
+    }
+
+    define void @odd(i32* %p, i32 %n) {
+      store i32 %n, i32* @g
+      %done = icmp eq i32 %n, 0
+      br i1 %done, label %exit, label %recurse
+    recurse:
+      %m = sub i32 %n, 1
+      %v = load i32, i32* %p
+      call void @even(i32* %p, i32 %m)
+      br label %exit
+    exit:
+      ret void
+    }
+  )IR");
+
+  // Both functions in the SCC see the accesses of the other.
+  for (StringRef Name : {"even", "odd"}) {
+    const FunctionRaceSummary *Summary = getSummary(Name);
+    ASSERT_TRUE(Summary);
+    EXPECT_FALSE(Summary->AccessesUnknownMemory);
+    EXPECT_EQ(ModRefInfo::Ref, Summary->getArgModRef(0));
+    EXPECT_EQ(ModRefInfo::Mod,
+              Summary->GlobalMR.lookup(M->getNamedGlobal("g")));
+  }
+}
+
+// A spawned call to a function with a complete summary accesses the global
+// variables named by that summary, instead of arbitrary memory.
+TEST_F(TapirRaceSummaryTest, CallSiteAccessesGlobals) {
+  parseAssembly(R"IR(
+    @g = internal global i32 0
+    @h = internal global i32 0
+
+    define void @writes_g() {
+      store i32 1, i32* @g
+      ret void
+    }
+
+    define void @caller() {
+    entry:
+      %sr = call token @llvm.syncregion.start()
+      detach within %sr, label %det, label %cont
+    det:
+      call void @writes_g()
+      reattach within %sr, label %cont
+    cont:
+      %vh = load i32, i32* @h
+      %vg = load i32, i32* @g
+      sync within %sr, label %exit
+    exit:
+      ret void
+    }
+
+    declare token @llvm.syncregion.start()
+  )IR");
+
+  const GlobalVariable *G = M->getNamedGlobal("g");
+  const GlobalVariable *H = M->getNamedGlobal("h");
+
+  // Without summaries, the call might access any memory, so it races with
+  // both loads in the continuation.
+  runRaceInfo("caller", /*UseSummaries=*/false, [&](Function &F, RaceInfo &RI) {
+    const CallBase *Call = getCallTo(F, "writes_g");
+    ASSERT_TRUE(Call);
+    for (const RaceInfo::RaceData &RD : RI.getRaceData(Call))
+      EXPECT_EQ(nullptr, RD.getPtr());
+    EXPECT_TRUE(RaceInfo::isLocalRace(RI.getRaceType(getLoadFrom(F, H))));
+    EXPECT_TRUE(RaceInfo::isLocalRace(RI.getRaceType(getLoadFrom(F, G))));
+  });
+
+  // With summaries, the call only writes @g, so the load of @h no longer races
+  // with it, while the load of @g still does.
+  runRaceInfo("caller", /*UseSummaries=*/true, [&](Function &F, RaceInfo &RI) {
+    const CallBase *Call = getCallTo(F, "writes_g");
+    ASSERT_TRUE(Call);
+    bool FoundGlobalAccess = false;
+    for (const RaceInfo::RaceData &RD : RI.getRaceData(Call)) {
+      EXPECT_EQ(G, RD.getPtr());
+      EXPECT_EQ(static_cast<unsigned>(-1), RD.OperandNum);
+      FoundGlobalAccess = true;
+    }
+    EXPECT_TRUE(FoundGlobalAccess);
+    EXPECT_TRUE(RaceInfo::isLocalRace(RI.getRaceType(Call)));
+    EXPECT_FALSE(RaceInfo::isLocalRace(RI.getRaceType(getLoadFrom(F, H))));
+    EXPECT_TRUE(RaceInfo::isLocalRace(RI.getRaceType(getLoadFrom(F, G))));
+    EXPECT_EQ(ModRefInfo::Mod, RI.getLocalRaceModRef(getLoadFrom(F, G)));
+  });
+}
+
+// A call to a function whose summary is incomplete still gets an opaque access.
+TEST_F(TapirRaceSummaryTest, CallSiteAccessesUnknownMemory) {
+  parseAssembly(R"IR(
+    @h = internal global i32 0
+
+    define void @writes_loaded(i32** %pp) {
+      %p = load i32*, i32** %pp
+      store i32 1, i32* %p
+      ret void
+    }
+
+    define void @caller(i32** %pp) {
+    entry:
+      %sr = call token @llvm.syncregion.start()
+      detach within %sr, label %det, label %cont
+    det:
+      call void @writes_loaded(i32** %pp)
+      reattach within %sr, label %cont
+    cont:
+      %vh = load i32, i32* @h
+      sync within %sr, label %exit
+    exit:
+      ret void
+    }
+
+    declare token @llvm.syncregion.start()
+  )IR");
+
+  ASSERT_TRUE(getSummary("writes_loaded")->AccessesUnknownMemory);
+  runRaceInfo("caller", /*UseSummaries=*/true, [&](Function &F, RaceInfo &RI) {
+    EXPECT_TRUE(RaceInfo::isLocalRace(
+        RI.getRaceType(getLoadFrom(F, M->getNamedGlobal("h")))));
+  });
+}
+
+} // end anonymous namespace
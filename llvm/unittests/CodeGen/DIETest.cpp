@@ -172,4 +172,124 @@ INSTANTIATE_TEST_SUITE_P(
         DIETestParams{4, dwarf::DWARF64, dwarf::DW_FORM_data8, 8u},
         DIETestParams{4, dwarf::DWARF64, dwarf::DW_FORM_sec_offset, 8u}));
 
+TEST(DIEAbbrevSetTest, UniqueAbbreviationFromOtherSet) {
+  BumpPtrAllocator Alloc;
+  DIEAbbrevSet Source(Alloc);
+  DIEAbbrevSet Dest(Alloc);
+
+  DIE &Var = *DIE::get(Alloc, dwarf::DW_TAG_variable);
+  Var.addValue(Alloc, dwarf::DW_AT_name, dwarf::DW_FORM_data1, DIEInteger(1));
+  Var.addValue(Alloc, dwarf::DW_AT_const_value, dwarf::DW_FORM_implicit_const,
+               DIEInteger(-42));
+  Var.addChild(DIE::get(Alloc, dwarf::DW_TAG_member));
+  DIEAbbrev &SourceAbbrev = Source.uniqueAbbreviation(Var);
+
+  // Number the copy differently from the original.
+  DIE &Base = *DIE::get(Alloc, dwarf::DW_TAG_base_type);
+  Dest.uniqueAbbreviation(Base);
+
+  DIEAbbrev &Copy = Dest.uniqueAbbreviation(SourceAbbrev);
+  EXPECT_NE(&Copy, &SourceAbbrev);
+  EXPECT_EQ(SourceAbbrev.getNumber(), 1u);
+  EXPECT_EQ(Copy.getNumber(), 2u);
+  EXPECT_EQ(Copy.getTag(), dwarf::DW_TAG_variable);
+  EXPECT_TRUE(Copy.hasChildren());
+  ASSERT_EQ(Copy.getData().size(), 2u);
+  EXPECT_EQ(Copy.getData()[0].getAttribute(), dwarf::DW_AT_name);
+  EXPECT_EQ(Copy.getData()[0].getForm(), dwarf::DW_FORM_data1);
+  EXPECT_EQ(Copy.getData()[1].getAttribute(), dwarf::DW_AT_const_value);
+  EXPECT_EQ(Copy.getData()[1].getForm(), dwarf::DW_FORM_implicit_const);
+  EXPECT_EQ(Copy.getData()[1].getValue(), -42);
+
+  // The copy is found again, whether from the abbreviation or from the DIE.
+  EXPECT_EQ(&Dest.uniqueAbbreviation(SourceAbbrev), &Copy);
+  EXPECT_EQ(&Dest.uniqueAbbreviation(Var), &Copy);
+  EXPECT_EQ(Var.getAbbrevNumber(), 2u);
+
+  // The value of an implicit constant is part of the abbreviation.
+  DIE &OtherVar = *DIE::get(Alloc, dwarf::DW_TAG_variable);
+  OtherVar.addValue(Alloc, dwarf::DW_AT_name, dwarf::DW_FORM_data1,
+                    DIEInteger(1));
+  OtherVar.addValue(Alloc, dwarf::DW_AT_const_value,
+                    dwarf::DW_FORM_implicit_const, DIEInteger(-43));
+  OtherVar.addChild(DIE::get(Alloc, dwarf::DW_TAG_member));
+  DIEAbbrev &OtherCopy =
+      Dest.uniqueAbbreviation(Source.uniqueAbbreviation(OtherVar));
+  EXPECT_EQ(OtherCopy.getNumber(), 3u);
+  EXPECT_EQ(OtherCopy.getData()[1].getValue(), -43);
+  EXPECT_EQ(Dest.getAbbreviations().size(), 3u);
+}
+
+// A unit with a variable for each implicit constant in [First, Last).
+static DIE &createUnitDie(BumpPtrAllocator &Alloc, int64_t First,
+                          int64_t Last) {
+  DIE &Unit = *DIE::get(Alloc, dwarf::DW_TAG_compile_unit);
+  Unit.addValue(Alloc, dwarf::DW_AT_language, dwarf::DW_FORM_data2,
+                DIEInteger(dwarf::DW_LANG_C99));
+  for (int64_t I = First; I != Last; ++I) {
+    DIE &Var = Unit.addChild(DIE::get(Alloc, dwarf::DW_TAG_variable));
+    Var.addValue(Alloc, dwarf::DW_AT_name, dwarf::DW_FORM_data1,
+                 DIEInteger(I & 0xff));
+    Var.addValue(Alloc, dwarf::DW_AT_const_value,
+                 dwarf::DW_FORM_implicit_const, DIEInteger(I));
+  }
+  return Unit;
+}
+
+using DIELayout = std::vector<std::tuple<unsigned, unsigned, unsigned>>;
+
+static void getLayout(const DIE &Die, DIELayout &Layout) {
+  Layout.emplace_back(Die.getOffset(), Die.getSize(), Die.getAbbrevNumber());
+  for (const DIE &Child : Die.children())
+    getLayout(Child, Layout);
+}
+
+TEST(DIETest, ComputeOffsetsMatchesSharedAbbrevSet) {
+  BumpPtrAllocator Alloc;
+  const dwarf::FormParams Params = {5, 8, dwarf::DWARF32};
+  const unsigned HeaderSize = 12;
+  // The second unit adds abbreviations past number 127, which take two bytes
+  // in the shared set but only one in a set of its own.
+  SmallVector<DIE *, 2> Units = {&createUnitDie(Alloc, 0, 120),
+                                 &createUnitDie(Alloc, 100, 200)};
+
+  // Lay out the units one after the other, sharing an abbreviation set.
+  DIEAbbrevSet SharedAbbrevs(Alloc);
+  DIELayout Expected;
+  SmallVector<unsigned, 2> ExpectedSizes;
+  for (DIE *Unit : Units) {
+    ExpectedSizes.push_back(
+        Unit->computeOffsetsAndAbbrevs(Params, SharedAbbrevs, HeaderSize));
+    getLayout(*Unit, Expected);
+  }
+
+  // Lay out each unit against a set of its own, then merge the sets in unit
+  // order and renumber the abbreviations.
+  DIEAbbrevSet MergedAbbrevs(Alloc);
+  DIELayout Actual;
+  SmallVector<unsigned, 2> Sizes;
+  for (DIE *Unit : Units) {
+    DIEAbbrevSet UnitAbbrevs(Alloc);
+    Unit->computeOffsetsAndAbbrevs(Params, UnitAbbrevs, HeaderSize);
+    SmallVector<unsigned, 0> Numbers = {0};
+    for (const DIEAbbrev *Abbrev : UnitAbbrevs.getAbbreviations())
+      Numbers.push_back(MergedAbbrevs.uniqueAbbreviation(*Abbrev).getNumber());
+    Sizes.push_back(Unit->computeOffsets(Params, Numbers, HeaderSize));
+    getLayout(*Unit, Actual);
+  }
+
+  EXPECT_EQ(Sizes, ExpectedSizes);
+  EXPECT_EQ(Actual, Expected);
+  ASSERT_EQ(MergedAbbrevs.getAbbreviations().size(),
+            SharedAbbrevs.getAbbreviations().size());
+  EXPECT_GT(MergedAbbrevs.getAbbreviations().size(), 128u);
+  for (size_t I = 0, E = SharedAbbrevs.getAbbreviations().size(); I != E;
+       ++I) {
+    FoldingSetNodeID Merged, Shared;
+    MergedAbbrevs.getAbbreviations()[I]->Profile(Merged);
+    SharedAbbrevs.getAbbreviations()[I]->Profile(Shared);
+    EXPECT_EQ(Merged, Shared) << "abbreviation " << I + 1;
+  }
+}
+
 } // end namespace
@@ -0,0 +1,117 @@
+//===- llvm/unittest/DebugInfo/DWARFVerifierTest.cpp ----------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/ObjectYAML/DWARFEmitter.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// Units that each have an invalid unit-local reference and an out of bounds
+// DW_FORM_ref_addr, so that every unit buffers errors of its own.
+std::string getUnitsYAML(unsigned NumUnits) {
+  std::string Yaml;
+  raw_string_ostream OS(Yaml);
+  OS << R"(
+    debug_abbrev:
+      - Table:
+          - Code:            0x00000001
+            Tag:             DW_TAG_compile_unit
+            Children:        DW_CHILDREN_yes
+            Attributes:
+              - Attribute:       DW_AT_name
+                Form:            DW_FORM_string
+          - Code:            0x00000002
+            Tag:             DW_TAG_variable
+            Children:        DW_CHILDREN_no
+            Attributes:
+              - Attribute:       DW_AT_type
+                Form:            DW_FORM_ref4
+              - Attribute:       DW_AT_specification
+                Form:            DW_FORM_ref_addr
+    debug_info:
+)";
+  for (unsigned I = 0; I != NumUnits; ++I)
+    OS << R"(
+      - Version:         4
+        AddrSize:        8
+        AbbrevTableID:   0
+        Entries:
+          - AbbrCode:        0x00000001
+            Values:
+              - CStr:            unit)"
+       << I << R"(
+          - AbbrCode:        0x00000002
+            Values:
+              - Value:           )"
+       << 0x100 + I << R"(
+              - Value:           )"
+       << 0x5000 + I << R"(
+          - AbbrCode:        0x00000000
+)";
+  return OS.str();
+}
+
+std::string verify(DWARFContext &Ctx, unsigned NumThreads, bool &Success) {
+  ThreadPoolStrategy OldStrategy = parallel::strategy;
+  parallel::strategy = hardware_concurrency(NumThreads);
+  std::string Output;
+  raw_string_ostream OS(Output);
+  DIDumpOptions DumpOpts;
+  DumpOpts.DumpType = DIDT_DebugInfo;
+  Success = Ctx.verify(OS, DumpOpts);
+  parallel::strategy = OldStrategy;
+  return OS.str();
+}
+
+TEST(DWARFVerifier, UnitOutputDoesNotDependOnThreads) {
+  const unsigned NumUnits = 8;
+  Expected<StringMap<std::unique_ptr<MemoryBuffer>>> Sections =
+      DWARFYAML::emitDebugSections(getUnitsYAML(NumUnits),
+                                   /*IsLittleEndian=*/true,
+                                   /*Is64BitAddrSize=*/true);
+  ASSERT_THAT_EXPECTED(Sections, Succeeded());
+
+  // Verify on one thread first, as the thread pool only ever grows to the
+  // number of threads requested when it is first used.
+  std::unique_ptr<DWARFContext> SerialCtx =
+      DWARFContext::create(*Sections, 8, /*isLittleEndian=*/true);
+  bool SerialSuccess;
+  std::string Serial = verify(*SerialCtx, 1, SerialSuccess);
+
+  std::unique_ptr<DWARFContext> ParallelCtx =
+      DWARFContext::create(*Sections, 8, /*isLittleEndian=*/true);
+  bool ParallelSuccess;
+  std::string Parallel = verify(*ParallelCtx, 4, ParallelSuccess);
+
+  EXPECT_FALSE(SerialSuccess);
+  EXPECT_FALSE(ParallelSuccess);
+  EXPECT_EQ(Parallel, Serial);
+
+  // The output of each unit, including its errors, follows its header line,
+  // in unit order.
+  size_t Pos = 0;
+  for (unsigned I = 0; I != NumUnits; ++I) {
+    std::string Header = "Verifying unit: " + std::to_string(I + 1) + " / " +
+                         std::to_string(NumUnits) + ", \"unit" +
+                         std::to_string(I) + "\"\n";
+    Pos = Serial.find(Header, Pos);
+    ASSERT_NE(Pos, std::string::npos) << Header;
+    Pos += Header.size();
+    EXPECT_EQ(Serial.compare(Pos, 7, "error: "), 0) << Header;
+  }
+}
+
+} // end anonymous namespace
@@ -238,7 +238,8 @@ struct CoverageMappingTest : ::testing::TestWithParam<std::tuple<bool, bool>> {
     ProfileReader = std::move(ReaderOrErr.get());
   }
 
-  Expected<std::unique_ptr<CoverageMapping>> readOutputFunctions() {
+  Expected<std::unique_ptr<CoverageMapping>>
+  readOutputFunctions(CoverageMapping::FilenameFilter IsRequestedFile) {
     std::vector<std::unique_ptr<CoverageMappingReader>> CoverageReaders;
     if (UseMultipleReaders) {
       for (const auto &OF : OutputFunctions) {
@@ -251,13 +252,16 @@ struct CoverageMappingTest : ::testing::TestWithParam<std::tuple<bool, bool>> {
       CoverageReaders.push_back(
           std::make_unique<CoverageMappingReaderMock>(Funcs));
     }
-    return CoverageMapping::load(CoverageReaders, *ProfileReader);
+    return CoverageMapping::load(CoverageReaders, *ProfileReader,
+                                 IsRequestedFile);
   }
 
-  Error loadCoverageMapping(bool EmitFilenames = true) {
+  Error loadCoverageMapping(
+      bool EmitFilenames = true,
+      CoverageMapping::FilenameFilter IsRequestedFile = nullptr) {
     readProfCounts();
     writeAndReadCoverageRegions(EmitFilenames);
-    auto CoverageOrErr = readOutputFunctions();
+    auto CoverageOrErr = readOutputFunctions(IsRequestedFile);
     if (!CoverageOrErr)
       return CoverageOrErr.takeError();
     LoadedCoverage = std::move(CoverageOrErr.get());
@@ -374,6 +378,61 @@ TEST_P(CoverageMappingTest, load_coverage_for_several_functions) {
   }
 }
 
+TEST_P(CoverageMappingTest, load_coverage_for_requested_files) {
+  ProfileWriter.addRecord({"func1", 0x1234, {10}}, Err);
+  ProfileWriter.addRecord({"func2", 0x2345, {20}}, Err);
+  ProfileWriter.addRecord({"func3", 0x3456, {30}}, Err);
+
+  startFunction("func1", 0x1234);
+  addCMR(Counter::getCounter(0), "foo", 1, 1, 5, 5);
+
+  startFunction("func2", 0x2345);
+  addCMR(Counter::getCounter(0), "bar", 2, 2, 6, 6);
+
+  // Functions with code in a requested file are loaded whole.
+  startFunction("func3", 0x3456);
+  addCMR(Counter::getCounter(0), "baz", 3, 3, 7, 7);
+  addExpansionCMR("baz", "foo", 4, 4, 4, 10);
+  addCMR(Counter::getCounter(0), "foo", 1, 1, 1, 10);
+
+  EXPECT_THAT_ERROR(
+      loadCoverageMapping(/*EmitFilenames=*/true,
+                          [](StringRef Filename) { return Filename == "foo"; }),
+      Succeeded());
+
+  std::vector<std::string> Names;
+  for (const auto &FunctionRecord : LoadedCoverage->getCoveredFunctions())
+    Names.push_back(FunctionRecord.Name);
+  ASSERT_EQ(2U, Names.size());
+  EXPECT_EQ("func1", Names[0]);
+  EXPECT_EQ("func3", Names[1]);
+  EXPECT_TRUE(LoadedCoverage->getCoverageForFile("bar").empty());
+  EXPECT_FALSE(LoadedCoverage->getCoverageForFile("baz").empty());
+}
+
+TEST_P(CoverageMappingTest, requested_files_keep_hash_mismatches) {
+  ProfileWriter.addRecord({"func1", 0x1234, {10}}, Err);
+  ProfileWriter.addRecord({"func2", 0x2345, {20}}, Err);
+
+  startFunction("func1", 0x1234);
+  addCMR(Counter::getCounter(0), "foo", 1, 1, 5, 5);
+
+  // A function with a stale profile is counted as mismatched even though it
+  // has no code in a requested file.
+  startFunction("func2", 0x5432);
+  addCMR(Counter::getCounter(0), "bar", 2, 2, 6, 6);
+
+  EXPECT_THAT_ERROR(
+      loadCoverageMapping(/*EmitFilenames=*/true,
+                          [](StringRef Filename) { return Filename == "foo"; }),
+      Succeeded());
+
+  EXPECT_EQ(1U, LoadedCoverage->getMismatchedCount());
+  const auto FunctionRecords = LoadedCoverage->getCoveredFunctions();
+  ASSERT_EQ(1, std::distance(FunctionRecords.begin(), FunctionRecords.end()));
+  EXPECT_EQ("func1", (*FunctionRecords.begin()).Name);
+}
+
 TEST_P(CoverageMappingTest, create_combined_regions) {
   ProfileWriter.addRecord({"func1", 0x1234, {1, 2, 3}}, Err);
   startFunction("func1", 0x1234);
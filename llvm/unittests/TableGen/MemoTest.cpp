@@ -0,0 +1,171 @@
+//===- llvm/unittest/TableGen/MemoTest.cpp - Tests for -memo --------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TableGen/Error.h"
+#include "llvm/TableGen/Main.h"
+#include "llvm/TableGen/Record.h"
+#include "llvm/Testing/Support/SupportHelpers.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using llvm::unittest::TempDir;
+
+namespace {
+
+unsigned NumBackendRuns = 0;
+
+// Looks up A only, which reaches its class and the record its field refers
+// to, and warns about it.
+bool emitA(raw_ostream &OS, RecordKeeper &Records) {
+  ++NumBackendRuns;
+  Record *A = Records.getDef("A");
+  OS << A->getValueAsInt("V") << ' '
+     << A->getValueAsDef("Ref")->getValueAsInt("V") << '\n';
+  PrintWarning(A->getLoc(), "A is deprecated");
+  return false;
+}
+
+// Looks up a class whose body keeps an unresolved !isa, which does not expose
+// the records it refers to.
+bool emitIsAClass(raw_ostream &OS, RecordKeeper &Records) {
+  ++NumBackendRuns;
+  OS << Records.getClass("IsA")->getValues().size() << '\n';
+  return false;
+}
+
+class TableGenMemoTest : public ::testing::Test {
+protected:
+  TableGenMemoTest()
+      : Dir("tblgen-memo", /*Unique=*/true), Input(Dir.path("input.td")),
+        Output(Dir.path("output.inc")), Memo(Dir.path("output.memo")) {}
+
+  void writeInput(StringRef Contents) {
+    std::error_code EC;
+    raw_fd_ostream OS(Input, EC);
+    ASSERT_FALSE(EC);
+    OS << Contents;
+  }
+
+  /// Run the backend through TableGenMain, returning what it printed to
+  /// stderr.
+  std::string run(ArrayRef<const char *> ExtraArgs = None,
+                  TableGenMainFn *MainFn = &emitA) {
+    SmallVector<const char *, 8> Args = {"llvm-tblgen", Input.c_str(), "-o",
+                                         Output.c_str(), "-memo", Memo.c_str()};
+    Args.append(ExtraArgs.begin(), ExtraArgs.end());
+    // Each run parses its input as a new process would.
+    SrcMgr = SourceMgr();
+    cl::ResetAllOptionOccurrences();
+    EXPECT_TRUE(cl::ParseCommandLineOptions(Args.size(), Args.data(), "",
+                                            &errs()));
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(TableGenMain(Args[0], MainFn, Args), 0);
+    return testing::internal::GetCapturedStderr();
+  }
+
+  std::string readOutput() {
+    auto OutOrErr = MemoryBuffer::getFile(Output);
+    EXPECT_TRUE(bool(OutOrErr));
+    return OutOrErr ? std::string((*OutOrErr)->getBuffer()) : "";
+  }
+
+  TempDir Dir;
+  std::string Input;
+  std::string Output;
+  std::string Memo;
+};
+
+const char *Records = R"(
+class C<int v> {
+  int V = v;
+}
+def X : C<10>;
+def Unrelated : C<20>;
+class WithRef<int v, C r> : C<v> {
+  C Ref = r;
+}
+def A : WithRef<1, X>;
+class IsA<C r> {
+  bit B = !isa<WithRef>(r);
+}
+)";
+
+TEST_F(TableGenMemoTest, Hit) {
+  writeInput(Records);
+  NumBackendRuns = 0;
+  std::string FirstDiags = run();
+  EXPECT_EQ(NumBackendRuns, 1u);
+  EXPECT_EQ(readOutput(), "1 10\n");
+  EXPECT_NE(FirstDiags.find("warning: A is deprecated"), std::string::npos);
+
+  // The output is reused, and the warning is printed again.
+  std::string SecondDiags = run();
+  EXPECT_EQ(NumBackendRuns, 1u);
+  EXPECT_EQ(readOutput(), "1 10\n");
+  EXPECT_EQ(SecondDiags, FirstDiags);
+}
+
+TEST_F(TableGenMemoTest, MissAfterEditingReachableRecord) {
+  writeInput(Records);
+  NumBackendRuns = 0;
+  run();
+  EXPECT_EQ(NumBackendRuns, 1u);
+
+  // X is only reachable through the field of A.
+  std::string Edited(Records);
+  Edited.replace(Edited.find("C<10>"), 5, "C<11>");
+  writeInput(Edited);
+  run();
+  EXPECT_EQ(NumBackendRuns, 2u);
+  EXPECT_EQ(readOutput(), "1 11\n");
+}
+
+TEST_F(TableGenMemoTest, NoRerunAfterEditingUnrelatedRecord) {
+  writeInput(Records);
+  NumBackendRuns = 0;
+  run();
+  EXPECT_EQ(NumBackendRuns, 1u);
+
+  std::string Edited(Records);
+  Edited.replace(Edited.find("C<20>"), 5, "C<21>");
+  writeInput(Edited);
+  run();
+  EXPECT_EQ(NumBackendRuns, 1u);
+  EXPECT_EQ(readOutput(), "1 10\n");
+}
+
+TEST_F(TableGenMemoTest, MissOnInvocationMismatch) {
+  writeInput(Records);
+  NumBackendRuns = 0;
+  run();
+  EXPECT_EQ(NumBackendRuns, 1u);
+
+  run({"-write-if-changed"});
+  EXPECT_EQ(NumBackendRuns, 2u);
+  run({"-write-if-changed"});
+  EXPECT_EQ(NumBackendRuns, 2u);
+}
+
+TEST_F(TableGenMemoTest, UnfollowedReferencesReachEverything) {
+  writeInput(Records);
+  NumBackendRuns = 0;
+  run(None, &emitIsAClass);
+  run(None, &emitIsAClass);
+  EXPECT_EQ(NumBackendRuns, 1u);
+
+  std::string Edited(Records);
+  Edited.replace(Edited.find("C<20>"), 5, "C<21>");
+  writeInput(Edited);
+  run(None, &emitIsAClass);
+  EXPECT_EQ(NumBackendRuns, 2u);
+}
+
+} // end anonymous namespace
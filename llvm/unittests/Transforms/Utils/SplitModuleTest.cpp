@@ -0,0 +1,97 @@
+//===- SplitModuleTest.cpp - Unit tests for SplitModule -------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+static std::unique_ptr<Module> parseIR(LLVMContext &C, const char *IR) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> Mod = parseAssemblyString(IR, Err, C);
+  if (!Mod)
+    Err.print("SplitModuleTest", errs());
+  return Mod;
+}
+
+static const char *const UnbalancedIR = R"(
+  define i32 @big(i32 %x) {
+    %a = add i32 %x, 1
+    %b = mul i32 %a, %x
+    %c = add i32 %b, 2
+    %d = mul i32 %c, %b
+    %e = add i32 %d, 3
+    %f = mul i32 %e, %d
+    %g = add i32 %f, 4
+    %h = mul i32 %g, %f
+    ret i32 %h
+  }
+  define void @small0() {
+    ret void
+  }
+  define void @small1() {
+    ret void
+  }
+  define void @small2() {
+    ret void
+  }
+  define void @small3() {
+    ret void
+  }
+)";
+
+// Returns the names of the functions defined in each partition of M.
+static std::vector<std::vector<std::string>>
+splitFunctions(Module &M, unsigned N, bool BalanceBySize) {
+  std::vector<std::vector<std::string>> Partitions;
+  SplitModule(
+      M, N,
+      [&](std::unique_ptr<Module> MPart) {
+        Partitions.emplace_back();
+        for (const Function &F : *MPart)
+          if (!F.isDeclaration())
+            Partitions.back().push_back(F.getName().str());
+      },
+      /*PreserveLocals=*/false, BalanceBySize);
+  return Partitions;
+}
+
+TEST(SplitModule, BalanceBySize) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, UnbalancedIR);
+  ASSERT_TRUE(M);
+
+  auto Partitions = splitFunctions(*M, 2, /*BalanceBySize=*/true);
+  ASSERT_EQ(2u, Partitions.size());
+
+  // The large function goes to a partition of its own, and all of the small
+  // ones go to the other.
+  unsigned BigPart = Partitions[0].size() == 1 ? 0 : 1;
+  EXPECT_EQ(std::vector<std::string>{"big"}, Partitions[BigPart]);
+  EXPECT_EQ(4u, Partitions[1 - BigPart].size());
+}
+
+TEST(SplitModule, BalanceBySizeIsDeterministic) {
+  LLVMContext C;
+  std::unique_ptr<Module> M = parseIR(C, UnbalancedIR);
+  ASSERT_TRUE(M);
+
+  auto First = splitFunctions(*M, 3, /*BalanceBySize=*/true);
+  auto Second = splitFunctions(*M, 3, /*BalanceBySize=*/true);
+  EXPECT_EQ(First, Second);
+
+  // Each function is defined in exactly one partition.
+  unsigned NumDefined = 0;
+  for (const auto &Partition : First)
+    NumDefined += Partition.size();
+  EXPECT_EQ(5u, NumDefined);
+}
@@ -0,0 +1,55 @@
+//===- TapirEventsTest.cpp - XRay Tapir event unit tests --------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/XRay/TapirEvents.h"
+#include "llvm/Support/Endian.h"
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace llvm {
+namespace xray {
+namespace {
+
+std::string makePayload(uint32_t Magic, uint16_t Kind, uint16_t Site,
+                        uint64_t GUID, uint64_t Frame) {
+  std::string Data(TapirEventSize, '\0');
+  char *P = &Data[0];
+  support::endian::write32le(P, Magic);
+  support::endian::write16le(P + 4, Kind);
+  support::endian::write16le(P + 6, Site);
+  support::endian::write64le(P + 8, GUID);
+  support::endian::write64le(P + 16, Frame);
+  return Data;
+}
+
+TEST(TapirEventsTest, DecodesPayload) {
+  auto Data = makePayload(TapirEventMagic,
+                          static_cast<uint16_t>(TapirEventKind::Continue), 3,
+                          0x0123456789abcdefULL, 0x7ffc0000ULL);
+  auto E = decodeTapirEvent(Data, /*IsLittleEndian=*/true);
+  ASSERT_TRUE(E.hasValue());
+  EXPECT_EQ(E->Kind, TapirEventKind::Continue);
+  EXPECT_EQ(E->Site, 3u);
+  EXPECT_EQ(E->FunctionGUID, 0x0123456789abcdefULL);
+  EXPECT_EQ(E->Frame, 0x7ffc0000ULL);
+}
+
+TEST(TapirEventsTest, RejectsOtherCustomEvents) {
+  EXPECT_FALSE(decodeTapirEvent("hello, world", true).hasValue());
+  EXPECT_FALSE(
+      decodeTapirEvent(makePayload(0xdeadbeef, 1, 0, 0, 0), true).hasValue());
+  EXPECT_FALSE(decodeTapirEvent(makePayload(TapirEventMagic, 42, 0, 0, 0), true)
+                   .hasValue());
+  auto Truncated = makePayload(TapirEventMagic, 1, 0, 0, 0);
+  Truncated.pop_back();
+  EXPECT_FALSE(decodeTapirEvent(Truncated, true).hasValue());
+}
+
+} // namespace
+} // namespace xray
+} // namespace llvm
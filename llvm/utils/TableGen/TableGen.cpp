@@ -282,7 +282,7 @@ int main(int argc, char **argv) {
   InitLLVM X(argc, argv);
   cl::ParseCommandLineOptions(argc, argv);
 
-  return TableGenMain(argv[0], &LLVMTableGenMain);
+  return TableGenMain(argv[0], &LLVMTableGenMain, makeArrayRef(argv, argc));
 }
 
 #ifndef __has_feature